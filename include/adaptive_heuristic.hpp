@@ -0,0 +1,56 @@
+#ifndef A_STAR_ADAPTIVE_HEURISTIC_HPP
+#define A_STAR_ADAPTIVE_HEURISTIC_HPP
+
+#include "grid_edit_listener.hpp"
+#include "node.hpp"
+#include "search_state.hpp"
+#include <deque>
+#include <vector>
+
+class NodeGrid;
+
+// Heuristic values learned across queries to one goal (Adaptive A*,
+// Koenig & Likhachev). After an optimal search that reached the goal at
+// cost C, every expanded node s satisfies d(s, goal) >= C - g(s), so h(s)
+// is raised to that. The raised values stay consistent, and later queries
+// to the same goal from other starts expand fewer nodes.
+//
+// Values are tagged with a generation, so dropping all of them (new goal,
+// map reset, changed moves) is O(1). Blocking cells only makes paths
+// longer and keeps every learned value admissible; freeing a cell can
+// make them overestimate, so such an edit drops them too.
+class AdaptiveHeuristic : public GridEditListener {
+public:
+    AdaptiveHeuristic();
+
+    // Binds to a goal; values learned for another goal are dropped
+    void setGoal(const NodeGrid& grid, NodeId goal);
+
+    Cost operator()(NodeId nid) const;
+
+    // Learns from a finished optimal search: start plus the expanded nodes
+    // in trace, with their final g in state
+    void learn(const SearchState& state, NodeId start, const std::deque<TraceEntry>& trace);
+
+    NodeId goal() const { return m_goal; }
+    uint32_t generation() const { return m_generation; }
+    size_t learnedCount() const { return m_learned; }
+
+    void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onMapReset(const NodeGrid& grid) override;
+
+private:
+    void invalidate();
+
+    const NodeGrid* m_grid;
+    NodeId m_goal;
+    Connectivity m_connectivity;
+    CornerRule m_cornerRule;
+
+    uint32_t m_generation;
+    size_t m_learned;                   // nodes tagged with the current generation
+    std::vector<uint32_t> m_stamp;
+    std::vector<Cost> m_h;
+};
+
+#endif /* A_STAR_ADAPTIVE_HEURISTIC_HPP */
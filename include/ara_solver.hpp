@@ -0,0 +1,95 @@
+#ifndef A_STAR_ARA_SOLVER_HPP
+#define A_STAR_ARA_SOLVER_HPP
+
+#include "indexed_heap.hpp"
+#include "search_state.hpp"
+#include <chrono>
+#include <deque>
+#include <vector>
+
+class NodeGrid;
+
+// A path published by an anytime search, with the proven bound on how
+// far its cost may be above the optimal one (cost <= bound * optimal)
+struct AnytimeSolution {
+    std::vector<NodeId> path;    // goal to start
+    Cost cost;
+    float bound;
+    double elapsedMs;            // since the search started
+    uint64_t expansions;         // total so far
+};
+
+// Anytime Repairing A* (Likhachev, Gordon & Thrun). The first search is
+// weighted A* with f = g + epsilon * h, which finds a path quickly whose
+// cost is within epsilon of optimal. Each improve() lowers epsilon and
+// searches again, reusing every g-value found so far: only nodes whose g
+// dropped after they were expanded (the INCONS list) and the old open list
+// are re-queued, so later passes touch a fraction of the grid.
+//
+// After a pass the bound is tightened to cost / min(g + h) over every node
+// still queued or inconsistent, which is often well below epsilon.
+// Epsilon is kept in thousandths so the keys stay integral.
+//
+// Kept across queries, like the search state it runs in, so starting one
+// costs no work per node.
+class AraSolver {
+public:
+    static constexpr float DEFAULT_EPSILON = 3.0f;
+    static constexpr float DEFAULT_EPSILON_STEP = 0.5f;
+
+    typedef std::chrono::steady_clock Clock;
+
+    AraSolver(const NodeGrid& grid, SearchState& state, IndexedHeap<Cost>& openList,
+              float epsilonStep = DEFAULT_EPSILON_STEP);
+
+    // First pass with the given epsilon (at least 1). Expanded nodes are
+    // appended to trace. Returns false if goal is unreachable.
+    bool solve(NodeId start, NodeId goal, float epsilon, SearchStats& stats,
+               std::deque<TraceEntry>& trace);
+
+    // Lowers epsilon and repairs the path. Returns true if a pass finished
+    // before the deadline; an interrupted pass leaves the last path and
+    // bound in place and may be resumed by calling again.
+    bool improve(Clock::time_point deadline, SearchStats& stats, std::deque<TraceEntry>& trace);
+
+    bool isOptimal() const { return !m_solutions.empty() && m_solutions.back().bound <= 1.0f; }
+    float epsilon() const  { return m_epsilon / 1000.0f; }
+
+    // One solution per finished pass, each cheaper or better bounded
+    const std::vector<AnytimeSolution>& solutions() const { return m_solutions; }
+
+private:
+    Cost key(NodeId nid) const;
+
+    // Expands nodes until none queued can lead to a cheaper goal; false if
+    // the deadline passed first
+    bool improvePath(Clock::time_point deadline, SearchStats& stats,
+                     std::deque<TraceEntry>& trace);
+
+    // Records the path of a finished pass with its bound against every
+    // node that may still lead to a cheaper one
+    void publish(const SearchStats& stats);
+
+    bool isClosed(NodeId nid) const { return (m_closed[nid] >> 1) == m_pass; }
+
+    const NodeGrid& m_grid;
+    SearchState& m_state;
+    IndexedHeap<Cost>& m_openList;
+
+    NodeId m_start, m_goal;
+    uint32_t m_epsilon, m_epsilonStep;     // thousandths
+    bool m_resume;                         // last pass was cut off by a deadline
+    Clock::time_point m_startTime;
+    std::vector<AnytimeSolution> m_solutions;
+
+    // Pass in which each node was closed, shifted left by one, with the low
+    // bit set once it is on the INCONS list. A new pass reopens everything.
+    // Passes are numbered on across queries, so the marks are only cleared
+    // when the grid is resized or the count wraps.
+    static constexpr uint32_t MAX_PASS = UINT32_MAX >> 1;
+    uint32_t m_pass;
+    std::vector<uint32_t> m_closed;
+    std::vector<NodeId> m_incons;
+};
+
+#endif /* A_STAR_ARA_SOLVER_HPP */
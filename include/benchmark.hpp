@@ -0,0 +1,15 @@
+#ifndef A_STAR_BENCHMARK_HPP
+#define A_STAR_BENCHMARK_HPP
+
+// Headless solver benchmarks on a ROWS x COLS map, run with
+//   a-star ROWS COLS --bench
+int runBenchmarks(int rows, int cols);
+
+// Offline path database for the map the first randomize (R) makes on a
+// ROWS x COLS grid: loads FILE if it holds the database of that map, or
+// builds it on every hardware thread and saves it there, then times
+// queries against it. Run with
+//   a-star ROWS COLS --cpd FILE
+int runPathDatabaseTool(int rows, int cols, const char* path);
+
+#endif /* A_STAR_BENCHMARK_HPP */
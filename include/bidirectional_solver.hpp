@@ -0,0 +1,71 @@
+#ifndef A_STAR_BIDIRECTIONAL_SOLVER_HPP
+#define A_STAR_BIDIRECTIONAL_SOLVER_HPP
+
+#include "indexed_heap.hpp"
+#include "search_state.hpp"
+#include <deque>
+#include <vector>
+
+class NodeGrid;
+
+// Bidirectional A*: one search grows from the start towards the goal and
+// a second one from the goal back towards the start, each with its own
+// search state and open list. Every step expands the side with the
+// smaller open list.
+//
+// Both sides use the balanced potential p(v) = (h(v, goal) - h(v, start)) / 2,
+// forwards and negated backwards (Ikeda et al.), which keeps reduced edge
+// costs non-negative for consistent h. The pair then behaves like a
+// bidirectional Dijkstra: whenever a node reached by one side is also
+// touched by the other, the two partial paths join into a start-goal path
+// and the cheapest join seen so far (mu) is kept, and the search stops,
+// still optimal, once the two top keys together reach mu. Unlike stopping
+// on either side's own f, this does not need one frontier to sweep past
+// the other before it may end.
+//
+// Keys are kept doubled and shifted by h(start, goal) so that they stay
+// integral and non-negative.
+class BidirectionalSolver {
+public:
+    BidirectionalSolver(const NodeGrid& grid,
+                        SearchState& forward,  IndexedHeap<Cost>& forwardOpen,
+                        SearchState& backward, IndexedHeap<Cost>& backwardOpen);
+
+    // Searches between start and goal and appends every expanded node
+    // except the two roots to trace, tagged with its frontier. Returns
+    // true if a path was found.
+    bool solve(NodeId start, NodeId goal, SearchStats& stats, std::deque<TraceEntry>& trace);
+
+    // Cost of the path found and the node where the two searches met
+    Cost pathCost() const   { return m_bestCost; }
+    NodeId meetNode() const { return m_meet; }
+
+    // Path through the meeting node, ordered from goal to start
+    void buildPath(std::vector<NodeId>& path) const;
+
+private:
+    struct Side {
+        SearchState& state;
+        IndexedHeap<Cost>& openList;
+        NodeId source, target;
+        Frontier frontier;
+    };
+
+    // Open-list key of a node reached at cost g: 2 * (g + p(v)) + shift
+    Cost key(const Side& side, NodeId nid, Cost g) const;
+
+    // Expands the top node of one side and updates mu against the other
+    void expand(Side& side, const SearchState& other, SearchStats& stats,
+                std::deque<TraceEntry>& trace);
+
+    void updateMeet(NodeId nid, Cost g, const SearchState& other);
+
+    const NodeGrid& m_grid;
+    Side m_forward, m_backward;
+
+    Cost m_shift;    // h(start, goal), keeps every key non-negative
+    Cost m_bestCost;
+    NodeId m_meet;
+};
+
+#endif /* A_STAR_BIDIRECTIONAL_SOLVER_HPP */
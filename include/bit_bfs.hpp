@@ -0,0 +1,96 @@
+#ifndef A_STAR_BIT_BFS_HPP
+#define A_STAR_BIT_BFS_HPP
+
+#include "node.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class NodeGrid;
+
+// Breadth-first search over the obstacle bitmap that moves the frontier
+// a word of 64 cells at a time. The cells one hop on from the frontier
+// are its words shifted left and right and the words above and below,
+// ORed together and masked by the free cells not yet visited, so a level
+// costs a few word operations per 64 cells where a queue pops each cell
+// and checks its eight neighbors.
+//
+// Each level only reads the words the frontier holds and the ones next to
+// them, so the cost follows the frontier instead of the map size. Moves
+// are the grid's own, corner rule included, each one hop; the search
+// reads the map as it is and keeps nothing of it between searches.
+class BitBfs {
+public:
+    static constexpr uint32_t UNREACHED = UINT32_MAX;
+
+    BitBfs();
+
+    // Whether goal can be reached from start, stopping at the level that
+    // reaches it
+    bool reachable(const NodeGrid& grid, NodeId start, NodeId goal);
+
+    // Floods from every free source at once, up to maxHops moves away, and
+    // returns the number of cells reached, sources included
+    size_t floodFill(const NodeGrid& grid, const std::vector<NodeId>& sources,
+                     uint32_t maxHops = UNREACHED);
+
+    // Fewest moves to every cell from the nearest source, UNREACHED for
+    // blocked cells and the ones no source reaches; returns the number of
+    // cells reached
+    size_t hopDistances(const NodeGrid& grid, const std::vector<NodeId>& sources,
+                        std::vector<uint32_t>& hops);
+
+    // Whether the last search reached nid
+    bool reached(NodeId nid) const;
+
+    // Levels and frontier words the last search expanded
+    uint32_t levels() const { return m_levels; }
+    size_t expandedWords() const { return m_expandedWords; }
+
+private:
+    // Takes the grid's size and moves and clears what the last search left
+    void begin(const NodeGrid& grid);
+
+    // Runs the search, calling onLevel(level, word, bits) with the cells
+    // each level adds to a word until it returns true or the frontier is
+    // used up
+    template <typename Fn>
+    void search(const NodeGrid& grid, const std::vector<NodeId>& sources, uint32_t maxHops,
+                Fn&& onLevel);
+
+    // Cells of word the frontier reaches in one move, visited or not
+    uint64_t reach(const uint64_t* obstacles, size_t word) const;
+
+    // Word and bit of a cell, indexed like the obstacle bitmap's words
+    size_t wordOf(NodeId nid) const;
+    static uint64_t bitOf(NodeId nid, int columns) {
+        return uint64_t(1) << ((nid % columns + 1) % 64);
+    }
+
+    NodeId cellAt(size_t word, int bit) const {
+        int row = static_cast<int>(word / m_stride) - 1;
+        int column = static_cast<int>(word % m_stride) * 64 + bit - 1;
+        return static_cast<NodeId>(row * m_columns + column);
+    }
+
+    int m_rows, m_columns;
+    size_t m_stride;
+    Connectivity m_connectivity;
+    CornerRule m_cornerRule;
+
+    // Bitmaps one word longer at each end than the obstacle bitmap, so
+    // the words left of the first row can be read as empty
+    std::vector<uint64_t> m_visitedWords, m_frontierWords, m_nextWords;
+    uint64_t* m_visited;
+    uint64_t* m_frontier;
+    uint64_t* m_next;
+
+    std::vector<uint32_t> m_active, m_nextActive;    // words holding the frontier
+    std::vector<uint32_t> m_seen;                    // level a word was last expanded in
+    uint32_t m_stamp;
+
+    uint32_t m_levels;
+    size_t m_expandedWords;
+};
+
+#endif /* A_STAR_BIT_BFS_HPP */
@@ -0,0 +1,114 @@
+#ifndef A_STAR_BUCKET_QUEUE_HPP
+#define A_STAR_BUCKET_QUEUE_HPP
+
+#include "node.hpp"
+#include <cstddef>
+#include <vector>
+
+// Dial-style bucket queue over integer f-values with O(1) push and
+// amortised O(1) pop, a drop-in alternative to IndexedHeap for the
+// fixed-point cost model.
+//
+// Buckets form a ring with one bucket per f-value. With a consistent
+// heuristic all live keys lie in [minF, minF + 2 * max step cost], so a
+// ring wider than that never aliases; the ring grows if a push would
+// overflow it. Decrease-key leaves the old entry behind, and it is
+// dropped when its bucket is reached because the node's key moved on.
+// Within a bucket entries pop last-in first-out, so ties are broken
+// deterministically towards the most recently generated node.
+class BucketQueue {
+public:
+    explicit BucketQueue(size_t numNodes = 0, size_t numBuckets = 4096) {
+        resize(numNodes);
+        m_buckets.resize(roundUpPow2(numBuckets));
+        m_mask = m_buckets.size() - 1;
+    }
+
+    void resize(size_t numNodes) { m_key.assign(numNodes, STALE); clear(); }
+
+    void clear() {
+        for (auto& bucket : m_buckets) {
+            bucket.clear();
+        }
+        m_size = 0;
+        m_cursor = 0;
+        m_maxKey = 0;
+    }
+
+    bool empty() const  { return m_size == 0; }
+    size_t size() const { return m_size; }
+
+    void push(NodeId nid, Cost f, Cost) {
+        m_key[nid] = f;
+        insert(nid, f);
+        ++m_size;
+    }
+
+    void decreaseKey(NodeId nid, Cost f) {
+        m_key[nid] = f;
+        insert(nid, f);
+    }
+
+    NodeId pop() {
+        while (true) {
+            auto& bucket = m_buckets[m_cursor & m_mask];
+
+            while (!bucket.empty()) {
+                NodeId nid = bucket.back();
+                bucket.pop_back();
+
+                if (m_key[nid] == m_cursor) {
+                    m_key[nid] = STALE;
+                    --m_size;
+                    return nid;
+                }
+            }
+            ++m_cursor;
+        }
+    }
+
+private:
+    static constexpr Cost STALE = COST_INFINITY;
+
+    static size_t roundUpPow2(size_t n) {
+        size_t pow2 = 1;
+        while (pow2 < n) {
+            pow2 <<= 1;
+        }
+        return pow2;
+    }
+
+    void insert(NodeId nid, Cost f) {
+        if (m_size == 0 || f < m_cursor)
+            m_cursor = f;
+        if (f > m_maxKey || m_size == 0)
+            m_maxKey = f;
+        if (m_maxKey - m_cursor >= m_buckets.size())
+            grow(m_maxKey - m_cursor + 1);
+
+        m_buckets[f & m_mask].push_back(nid);
+    }
+
+    // Widen the ring and re-file every live entry under the new mask
+    void grow(size_t span) {
+        std::vector<std::vector<NodeId>> old(roundUpPow2(span * 2));
+        old.swap(m_buckets);
+        m_mask = m_buckets.size() - 1;
+
+        for (auto& bucket : old) {
+            for (NodeId nid : bucket) {
+                if (m_key[nid] != STALE)
+                    m_buckets[m_key[nid] & m_mask].push_back(nid);
+            }
+        }
+    }
+
+    std::vector<std::vector<NodeId>> m_buckets;
+    std::vector<Cost> m_key;    // current f of each queued node
+    size_t m_mask;
+    size_t m_size;
+    Cost m_cursor;              // lowest key that may still be queued
+    Cost m_maxKey;
+};
+
+#endif /* A_STAR_BUCKET_QUEUE_HPP */
@@ -0,0 +1,105 @@
+#ifndef A_STAR_COMPONENT_MAP_HPP
+#define A_STAR_COMPONENT_MAP_HPP
+
+#include "grid_edit_listener.hpp"
+#include "node.hpp"
+#include <cstddef>
+#include <vector>
+
+class NodeGrid;
+
+// Connected region of every free cell under the grid's moves, so a query
+// between two regions is known to fail before any search floods the
+// start's region to find out.
+//
+// The labels are built with union-find: strips of rows are joined on a
+// pool of threads, then the seams between strips serially, and the roots
+// are numbered. After that the labels are flat, one 32-bit word per
+// cell, and reading them takes no locks.
+//
+// Edits are applied in place when they are committed. An opened cell
+// joins the regions around it, relabeling the smaller ones. A blocked
+// cell may split its region: a search from each of its neighbors runs in
+// turn, one step each, searches that meet are joined, and a group of them
+// that runs out of cells is a region of its own and gets a new label.
+// Once a single group is left the rest keeps the old label, so a split
+// costs about the size of the smaller parts, and nothing if there is none.
+class ComponentMap : public GridEditListener {
+public:
+    static constexpr uint32_t NO_COMPONENT = UINT32_MAX;
+
+    ComponentMap();
+
+    // Labels the whole map; numThreads = 0 uses one thread per hardware
+    // thread
+    void rebuild(const NodeGrid& grid, unsigned numThreads = 0);
+
+    // False once the map was resized or its moves changed since it was
+    // built; edits keep it current
+    bool isCurrent(const NodeGrid& grid) const;
+
+    // Region label of a free cell, NO_COMPONENT for blocked cells. Labels
+    // are small integers but not dense, and edits may change them.
+    uint32_t component(NodeId nid) const { return m_label[nid]; }
+
+    // Whether a path between the two cells exists
+    bool connected(NodeId a, NodeId b) const {
+        return m_label[a] != NO_COMPONENT && m_label[a] == m_label[b];
+    }
+
+    size_t componentCount() const { return m_count; }
+    uint32_t componentSize(uint32_t label) const { return m_sizes[label]; }
+    uint32_t largestComponent() const;
+
+    // Sizes of all regions, largest first
+    std::vector<uint32_t> componentSizes() const;
+
+    // Cells given a new label by the last rebuild or edit
+    size_t updatedCells() const { return m_updatedCells; }
+
+    size_t memoryBytes() const {
+        return (m_label.size() + m_sizes.size()) * sizeof(uint32_t);
+    }
+
+    void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onTerrainChanged(const NodeGrid&, const std::vector<NodeId>&) override {}    // regions ignore costs
+    void onMapReset(const NodeGrid& grid) override;
+
+private:
+    uint32_t newLabel();
+    void freeLabel(uint32_t label);
+
+    // Cell one step from nid in direction dir, INVALID_NODE off the map
+    NodeId neighborAt(NodeId nid, int dir) const;
+
+    // Gives every cell of the region labeled from, which holds nid, the
+    // label to
+    void relabel(NodeId nid, uint32_t from, uint32_t to);
+
+    // Joins the regions of two adjacent cells, relabeling the smaller one
+    void join(NodeId a, NodeId b);
+
+    // Splits the region label into its connected parts, each of which
+    // holds at least one of the seeds
+    void split(uint32_t label, const std::vector<NodeId>& seeds);
+
+    const NodeGrid* m_grid;
+    int m_rows, m_columns;
+    Connectivity m_connectivity;
+    CornerRule m_cornerRule;
+
+    std::vector<uint32_t> m_label;
+    std::vector<uint32_t> m_sizes;         // per label, 0 if unused
+    std::vector<uint32_t> m_freeLabels;
+    size_t m_count;
+    size_t m_updatedCells;
+
+    // Split and relabel scratch: the split a cell was reached in and by
+    // which of its searches
+    std::vector<uint32_t> m_visitStamp;
+    std::vector<uint32_t> m_visitOwner;
+    uint32_t m_stamp;
+    std::vector<NodeId> m_queue;
+};
+
+#endif /* A_STAR_COMPONENT_MAP_HPP */
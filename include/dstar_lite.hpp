@@ -0,0 +1,72 @@
+#ifndef A_STAR_DSTAR_LITE_HPP
+#define A_STAR_DSTAR_LITE_HPP
+
+#include "grid_edit_listener.hpp"
+#include "indexed_heap.hpp"
+#include "node.hpp"
+#include "search_state.hpp"
+#include <deque>
+#include <vector>
+
+class NodeGrid;
+
+// D* Lite (Koenig & Likhachev) incremental replanning. The search runs
+// backwards from the goal, keeping for every node its distance g and the
+// one-step lookahead rhs = min(step + g(neighbor)) across queries. A node
+// with g != rhs is inconsistent and queued; planning settles queued nodes
+// until the start is consistent and no queued key can beat it.
+//
+// An edit only recomputes rhs for the flipped cells and their neighbors,
+// whose moves changed, so the next plan repairs just the part of the
+// search tree that went through them. The start may move freely between
+// plans: keys are not rebuilt but lifted lazily by the accumulated
+// heuristic offset km. Terrain edits change the costs of the moves of the
+// same cells and are repaired alike. A new goal, map reset, change of
+// moves or of the heuristic's terrain scale starts over from scratch.
+class DStarLite : public GridEditListener {
+public:
+    DStarLite();
+
+    // Plans from start to goal, reusing the previous search if the goal is
+    // the same. Nodes settled by this call are appended to trace. Returns
+    // false if start can not reach goal.
+    bool plan(const NodeGrid& grid, NodeId start, NodeId goal, SearchStats& stats,
+              std::deque<TraceEntry>& trace);
+
+    // Cost and cells of the path found by the last plan, goal to start
+    Cost pathCost() const { return m_pathCost; }
+    void buildPath(std::vector<NodeId>& path) const;
+
+    size_t queueSize() const { return m_queue.size(); }
+
+    void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onTerrainChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onMapReset(const NodeGrid& grid) override;
+
+private:
+    void initialize(NodeId start, NodeId goal);
+
+    // Queue key (min(g, rhs) + h(start, nid) + km, min(g, rhs)) packed into
+    // one integer that orders like the pair
+    uint64_t key(NodeId nid) const;
+
+    Cost lookahead(NodeId nid) const;    // min over moves of step + g
+    void updateVertex(NodeId nid);
+    void computeShortestPath(SearchStats& stats, std::deque<TraceEntry>& trace);
+
+    const NodeGrid* m_grid;
+    Connectivity m_connectivity;
+    CornerRule m_cornerRule;
+    uint8_t m_minTerrain;               // heuristic scale the keys were made with
+    bool m_stale;                       // needs initialize before the next plan
+
+    NodeId m_start, m_goal;
+    Cost m_km;
+
+    std::vector<Cost> m_g, m_rhs;
+    IndexedHeap<uint64_t> m_queue;
+
+    Cost m_pathCost;
+};
+
+#endif /* A_STAR_DSTAR_LITE_HPP */
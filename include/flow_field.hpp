@@ -0,0 +1,118 @@
+#ifndef A_STAR_FLOW_FIELD_HPP
+#define A_STAR_FLOW_FIELD_HPP
+
+#include "grid_edit_listener.hpp"
+#include "node.hpp"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+class NodeGrid;
+
+// One-to-all distance and direction field towards one goal, so any number
+// of agents heading there can look up their next step instead of running
+// a search each. One Dijkstra from the goal fills it.
+//
+// Per cell it keeps a 16-bit distance and a 3-bit direction, 21 of those
+// packed per 64-bit word: under 2.4 bytes a cell. Distances count 10 per
+// straight and 14 per diagonal step so that they fit and stay exact, which
+// makes the field slightly favour diagonals over the grid's own costs
+// (paths within 1% of solvePath's). On weighted maps a move counts half a
+// step per terrain multiplier of each of its cells, like the grid's
+// costs, so distances run out sooner. Cells farther than MAX_DISTANCE
+// read as unreachable.
+//
+// Edits are repaired in place when they are committed. The cells whose
+// route to the goal ran through a blocked cell or a move that is no longer
+// allowed lose their values, and a Dijkstra seeded from the valid cells
+// around them and around opened cells fills them in again and lowers
+// every distance an opened cell shortened. Terrain edits drop the values
+// of the changed cells and of those routed through them alike. The result
+// is the one a rebuild would give, ties between equal routes aside.
+class FlowField : public GridEditListener {
+public:
+    static constexpr uint16_t UNREACHABLE   = UINT16_MAX;
+    static constexpr uint16_t MAX_DISTANCE  = UNREACHABLE - 1;
+    static constexpr uint16_t STEP_STRAIGHT = 10;
+    static constexpr uint16_t STEP_DIAGONAL = 14;
+
+    FlowField();
+
+    // Fills the field towards goal
+    void rebuild(const NodeGrid& grid, NodeId goal);
+
+    // False once the map was resized or its moves changed since the field
+    // was built; edits keep it current
+    bool isCurrent(const NodeGrid& grid) const;
+
+    NodeId goal() const { return m_goal; }
+
+    // Distance to the goal in field units, UNREACHABLE for blocked cells
+    // and those the goal can not be reached from
+    uint16_t distance(NodeId nid) const { return m_dist[nid]; }
+
+    // Neighbor to step to from nid, INVALID_NODE at the goal and wherever
+    // the goal is unreachable
+    NodeId nextStep(NodeId nid) const {
+        if (m_dist[nid] == UNREACHABLE || nid == m_goal)
+            return INVALID_NODE;
+        return nid + m_dirOffset[direction(nid)];
+    }
+
+    // Direction of nextStep; only meaningful where there is one
+    Direction direction(NodeId nid) const {
+        return static_cast<Direction>((m_dirs[nid / DIRS_PER_WORD] >> shiftOf(nid)) & 7);
+    }
+
+    // Cells given a new distance by the last rebuild or repair
+    size_t updatedCells() const { return m_updatedCells; }
+
+    size_t memoryBytes() const {
+        return m_dist.size() * sizeof(uint16_t) + m_dirs.size() * sizeof(uint64_t);
+    }
+
+    void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onTerrainChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onMapReset(const NodeGrid& grid) override;
+
+private:
+    static constexpr unsigned DIRS_PER_WORD = 21;
+
+    static unsigned shiftOf(NodeId nid) { return (nid % DIRS_PER_WORD) * 3; }
+
+    void setDirection(NodeId nid, Direction dir) {
+        uint64_t& word = m_dirs[nid / DIRS_PER_WORD];
+        word = (word & ~(uint64_t(7) << shiftOf(nid))) | (uint64_t(dir) << shiftOf(nid));
+    }
+
+    // Cell one step from nid in direction dir, INVALID_NODE off the map
+    NodeId neighborAt(NodeId nid, int dir) const;
+
+    // Drops the value of nid and of every cell whose route ran through it
+    void invalidate(NodeId nid);
+
+    // Refills the invalid cells from the valid cells around them
+    void refill(std::vector<std::pair<uint16_t, NodeId>>& sources);
+
+    // Dijkstra from every source at its own distance, in increasing order.
+    // Ring buckets over the distances hold the queue, one more than the
+    // longest step on the map.
+    void propagate(std::vector<std::pair<uint16_t, NodeId>>& sources);
+
+    const NodeGrid* m_grid;
+    int m_rows, m_columns;
+    Connectivity m_connectivity;
+    CornerRule m_cornerRule;
+    int m_dirOffset[NUM_DIRECTIONS];
+
+    NodeId m_goal;
+    std::vector<uint16_t> m_dist;
+    std::vector<uint64_t> m_dirs;
+    size_t m_updatedCells;
+
+    // Repair and propagation scratch
+    std::vector<NodeId> m_invalid;
+    std::vector<std::vector<NodeId>> m_buckets;
+};
+
+#endif /* A_STAR_FLOW_FIELD_HPP */
@@ -0,0 +1,85 @@
+#ifndef A_STAR_FRINGE_SOLVER_HPP
+#define A_STAR_FRINGE_SOLVER_HPP
+
+#include "search_state.hpp"
+#include <deque>
+#include <vector>
+
+class NodeGrid;
+
+// Fringe Search (Björnsson, Enzenberger, Holte & Schaeffer). Like IDA* it
+// works in iterations with an f threshold, but the frontier of the last
+// iteration is kept, so an iteration resumes where the previous one
+// stopped instead of searching again from the start.
+//
+// The frontier is an unsorted list: nodes above the threshold are
+// skipped until the next iteration, the others are expanded in place
+// with their children inserted right behind them. Nothing is ever sorted
+// or pushed to a heap.
+//
+// Every node the query reaches keeps its g, h, parent and list links in
+// a hash table of a fixed size instead of per-cell arrays, so memory
+// follows the ceiling given to solve and not the map. Entries are never
+// dropped, as the list and the path run through them: a query that
+// reaches more nodes than the table holds gives up (outOfMemory), and
+// solvePath runs it again as IDA*, unreachable goals included, which
+// IDA* is slow to prove (see ida_star_solver.hpp). Entries are stamped
+// with their query, so a new one clears nothing.
+//
+// Each iteration walks the whole list, so it suits maps where f takes few
+// distinct values. On weighted terrain, with the heuristic scaled down to
+// the cheapest multiplier, the threshold creeps up through thousands of
+// values and the walks dominate; A* is far faster there.
+class FringeSolver {
+public:
+    FringeSolver();
+
+    // Searches from start to goal with a node table of at most tableBytes.
+    // At most traceLimit expansions are appended to trace. Returns false
+    // if goal is unreachable or the table ran full.
+    bool solve(const NodeGrid& grid, NodeId start, NodeId goal, size_t tableBytes,
+               size_t traceLimit, SearchStats& stats, std::deque<TraceEntry>& trace);
+
+    // Cost and cells of the path found by the last solve, goal to start
+    Cost pathCost() const { return m_pathCost; }
+    void buildPath(std::vector<NodeId>& path) const;
+
+    // Whether the last solve stopped because the table was full
+    bool outOfMemory() const { return m_outOfMemory; }
+
+    uint32_t iterations() const { return m_iterations; }
+
+    size_t memoryBytes() const { return m_table.size() * sizeof(Entry); }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Entry {
+        NodeId nid;
+        Cost g, h;
+        NodeId parent;
+        uint32_t next, prev;    // slots in the list, prev NONE once closed
+        uint32_t query;
+    };
+
+    // Slot holding nid in this query, or the free one it goes to
+    uint32_t slotOf(NodeId nid) const;
+
+    // Doubly linked list through the table; the slot past the last entry
+    // is the head and tail sentinel
+    void insertAfter(uint32_t pos, uint32_t slot);
+    void unlink(uint32_t slot);
+
+    std::vector<Entry> m_table;
+    uint32_t m_capacity;           // entries, not counting the sentinel
+    uint32_t m_sentinel;
+    uint32_t m_query;              // kept across queries, so no clearing
+    uint32_t m_size, m_maxSize;    // linear probing wants some slots free
+
+    bool m_outOfMemory;
+    uint32_t m_iterations;
+    NodeId m_goal;
+    Cost m_pathCost;
+};
+
+#endif /* A_STAR_FRINGE_SOLVER_HPP */
@@ -6,6 +6,7 @@
 
 static constexpr int PIXEL_SIZE = 1;
 static constexpr int SCALE_FACTOR = 10;
+static constexpr uint8_t MUD_TERRAIN = 4;
 
 class GameEngine : public olc::PixelGameEngine
 {
@@ -25,10 +26,14 @@ private:
         BACKGROUND     = 0x000000,
         NEUTRAL_NODE   = 0x002200,
         VISITED_NODE   = 0x508050,
+        VISITED_BACK   = 0x807050,
         OBSTACLE_NODE  = 0x20207F,
+        MUD_NODE       = 0x604020,
         START_NODE     = 0x00FF00,
         END_NODE       = 0xFF0000,
         PATH_LINE      = 0x00FFFF,
+        FLOW_NEAR      = 0xFFE040,
+        FLOW_FAR       = 0x603000,
     };
 
     olc::Pixel getPixelColor(GameEngine::ColorEnums color);
@@ -38,15 +43,20 @@ private:
 
     void DrawNodeGrid();
     void DrawNodeConnections();
+    void DrawFlowField();
     void DrawShortestPath();
+    void DrawPathInfo();
     void DrawNodes();
-    void DrawVisitedNode(const NodePtr& nodePtr);
+    void DrawVisitedNode(const TraceEntry& entry);
+    void advanceVisitedNode();
+    void replanLive();
 
     bool isLargerThanFPS = false;
     int getStdDistVal(int x, int mean, float std_dev, int size);
 
     int m_totalFrames, m_frameCount;
-    NodePtr m_nodePtr;
+    bool m_isAnimating;
+    bool m_showFlowField;
 };
 
 #endif /* A_STAR_GAME_ENGINE_HPP */
@@ -0,0 +1,32 @@
+#ifndef A_STAR_GRID_EDIT_LISTENER_HPP
+#define A_STAR_GRID_EDIT_LISTENER_HPP
+
+#include "node.hpp"
+#include <vector>
+
+class NodeGrid;
+
+// Receives committed obstacle and terrain edits from a NodeGrid, so that
+// structures derived from the map can patch only what the edit touched.
+class GridEditListener {
+public:
+    virtual ~GridEditListener() {}
+
+    // Called once per committed edit with every cell whose obstacle state
+    // flipped. The grid already reflects the new state.
+    virtual void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) = 0;
+
+    // Called once per committed edit with every cell whose terrain
+    // multiplier changed, after onObstaclesChanged if obstacles changed
+    // too. Only move costs changed, so structures that depend on the
+    // obstacles alone can ignore it; by default it counts as a map reset.
+    virtual void onTerrainChanged(const NodeGrid& grid, const std::vector<NodeId>&) {
+        onMapReset(grid);
+    }
+
+    // Called when the whole map was replaced (e.g. randomized) and derived
+    // data should be rebuilt from scratch.
+    virtual void onMapReset(const NodeGrid& grid) = 0;
+};
+
+#endif /* A_STAR_GRID_EDIT_LISTENER_HPP */
@@ -0,0 +1,169 @@
+#ifndef A_STAR_HPA_MAP_HPP
+#define A_STAR_HPA_MAP_HPP
+
+#include "grid_edit_listener.hpp"
+#include "indexed_heap.hpp"
+#include "node.hpp"
+#include "search_state.hpp"
+#include <deque>
+#include <vector>
+
+class HpaMap;
+class NodeGrid;
+
+// Result of an HPA* query: the abstract path as a list of waypoint cells
+// (start, sector transitions, goal), turned into grid cells on demand.
+// Each abstract edge is refined by a search confined to a single sector,
+// so the first steps of a long path are ready long before the rest.
+//
+// A path refers to the HpaMap that produced it and is meant to be walked
+// before the map is edited again; if an edit makes a leg impassable,
+// refinement stops there and finished() becomes true.
+class HpaPath {
+public:
+    HpaPath();
+
+    bool found() const { return !m_waypoints.empty(); }
+    bool finished() const;
+    Cost cost() const { return m_cost; }
+
+    // Start, every transition cell on the abstract path, then the goal
+    const std::vector<NodeId>& waypoints() const { return m_waypoints; }
+
+    // Appends up to count further cells of the path (the start cell is not
+    // included) to steps, refining only as many abstract edges as that
+    // needs. Returns how many cells were appended.
+    size_t nextSteps(size_t count, std::vector<NodeId>& steps);
+
+private:
+    friend class HpaMap;
+
+    HpaMap* m_map;
+    std::vector<NodeId> m_waypoints;
+    size_t m_nextLeg;                   // first waypoint pair not refined yet
+    std::vector<NodeId> m_pending;      // refined cells not handed out yet
+    size_t m_pendingPos;
+    Cost m_cost;
+};
+
+// Hierarchical abstraction of a NodeGrid for HPA* (Botea, Mueller and
+// Schaeffer). The map is cut into square sectors. Where two neighboring
+// sectors touch, each maximal run of free cell pairs across the border is
+// an entrance with one transition (two for long runs), and the transition
+// cells of a sector are joined by their shortest distances inside it.
+// Diagonal moves that cross a border away from any run, or through a
+// sector corner, become entrances of their own, so the abstract graph
+// connects exactly what the grid connects.
+//
+// A query links start and goal into their sectors, runs A* over the
+// abstract graph and hands back an HpaPath to refine lazily. Paths follow
+// the sector structure and are typically within a few percent of optimal.
+// Edits recompute the intra-sector distances of the edited sector, and the
+// entrances of its borders only when a border cell changed; terrain edits
+// the same, as they change the costs of both. Entrances are placed by the
+// obstacles alone, so weighted maps give paths further from optimal.
+class HpaMap : public GridEditListener {
+public:
+    static constexpr int DEFAULT_SECTOR_SIZE = 32;
+
+    explicit HpaMap(int sectorSize = DEFAULT_SECTOR_SIZE);
+
+    void rebuild(const NodeGrid& grid);
+
+    int sectorSize() const { return m_sectorSize; }
+    int sectorCount() const { return static_cast<int>(m_sectors.size()); }
+    size_t transitionCount() const;
+
+    // Abstract search from start to goal. Expanded transitions are appended
+    // to trace if given. Returns false if the goal is unreachable.
+    bool findPath(NodeId start, NodeId goal, HpaPath& path, SearchStats& stats,
+                  std::deque<TraceEntry>* trace = nullptr);
+
+    void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onTerrainChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onMapReset(const NodeGrid& grid) override;
+
+private:
+    friend class HpaPath;
+
+    enum Border {
+        BORDER_EAST,
+        BORDER_SOUTH,
+        CORNER_SOUTH_EAST,
+        CORNER_SOUTH_WEST,
+        NUM_BORDERS,
+    };
+
+    // A single move from a cell of one sector into a neighboring sector
+    struct Crossing {
+        NodeId inside, outside;
+        Cost cost;
+
+        bool operator==(const Crossing& other) const {
+            return inside == other.inside && outside == other.outside && cost == other.cost;
+        }
+    };
+
+    struct Sector {
+        std::vector<Crossing> borders[NUM_BORDERS];  // crossings out of this sector
+        std::vector<NodeId>   transitions;           // sorted transition cells
+        std::vector<Cost>     dist;                  // n x n distances inside the sector
+        std::vector<uint32_t> interBegin;            // per transition, into inter
+        std::vector<Crossing> inter;                 // crossings of every transition
+    };
+
+    int sectorOf(NodeId nid) const;
+    void sectorRect(int sector, int& x0, int& y0, int& x1, int& y1) const;
+    int neighborSector(int sector, int dx, int dy) const;
+    bool isFree(int x, int y) const;
+    bool canStep(int x, int y, int dx, int dy) const;
+    Crossing crossing(NodeId inside, NodeId outside) const;
+
+    // Recomputes the entrances of one border of a sector; true if they changed
+    bool computeBorder(int sector, Border border);
+    void computeBorderLine(int ax, int ay, int stepX, int stepY, int crossX, int crossY,
+                           int length, std::vector<Crossing>& crossings) const;
+
+    // Gathers the transitions of a sector and their distances inside it;
+    // true if the transition set changed
+    bool computeSectorGraph(int sector);
+
+    // Search over the cells of one sector from source: A* towards goal if
+    // it is valid, otherwise Dijkstra until every target is settled.
+    // Distances and parents stay readable until the next call.
+    void searchSector(int sector, NodeId source, NodeId goal,
+                      const std::vector<NodeId>& targets);
+    Cost localDistance(NodeId nid) const;
+    int localIndex(NodeId nid) const;
+
+    // Appends the cells of the abstract edge from -> to, excluding from;
+    // false if an edit made the leg impassable
+    bool refineLeg(NodeId from, NodeId to, std::vector<NodeId>& cells);
+
+    // Dense numbering of all transitions for the abstract search
+    void buildIndex();
+    uint32_t abstractId(int sector, NodeId cell) const;
+
+    const NodeGrid* m_grid;
+    int m_sectorSize;
+    int m_rows, m_columns;
+    int m_sectorsX, m_sectorsY;
+    Connectivity m_connectivity;
+    CornerRule m_cornerRule;
+
+    std::vector<Sector> m_sectors;
+
+    bool m_indexDirty;
+    std::vector<uint32_t> m_sectorBase;     // first abstract id of each sector
+    std::vector<NodeId>   m_abstractCell;
+    std::vector<int>      m_abstractSector;
+    SearchState           m_abstractState;
+    IndexedHeap<Cost>     m_abstractOpen;
+
+    // Scratch for searches inside one sector, indexed by local cell
+    int m_localX0, m_localY0;
+    SearchState       m_localState;
+    IndexedHeap<Cost> m_localOpen;
+};
+
+#endif /* A_STAR_HPA_MAP_HPP */
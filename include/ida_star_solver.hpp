@@ -0,0 +1,80 @@
+#ifndef A_STAR_IDA_STAR_SOLVER_HPP
+#define A_STAR_IDA_STAR_SOLVER_HPP
+
+#include "search_state.hpp"
+#include <deque>
+#include <vector>
+
+class NodeGrid;
+
+// Iterative deepening A* (Korf). Each iteration is a depth-first search
+// that cuts off every node with g + h above a threshold, the next
+// threshold being the smallest f that was cut off. No open list is kept:
+// the only per-query memory is the current path on the stack.
+//
+// Grids reach most cells along many paths of the same cost, which plain
+// IDA* would explore once per path. A fixed-size transposition table
+// keeps the cheapest g each cell was reached at during the query and
+// prunes later visits that are no cheaper. Entries are overwritten on
+// collision, which only loses pruning, so the table may be as small as
+// the memory ceiling demands and the search stays optimal. The stack
+// shares the ceiling: it gets room for a path through every cell, or a
+// quarter of it on maps too large for that, and a query that needs a
+// deeper stack gives up (outOfMemory).
+//
+// The price is paid on maps with many obstacles, where f grows in many
+// small steps and each step is another iteration, and most of all on
+// unreachable goals: those are only proven so once an iteration cuts
+// nothing off, after searching every reachable cell many times over.
+class IdaStarSolver {
+public:
+    IdaStarSolver();
+
+    // Searches from start to goal with a transposition table and stack of
+    // at most memoryBytes together. At most traceLimit expansions are
+    // appended to trace. Returns false if goal is unreachable or the
+    // stack ran full.
+    bool solve(const NodeGrid& grid, NodeId start, NodeId goal, size_t memoryBytes,
+               size_t traceLimit, SearchStats& stats, std::deque<TraceEntry>& trace);
+
+    // Cost and cells of the path found by the last solve, goal to start
+    Cost pathCost() const { return m_pathCost; }
+    void buildPath(std::vector<NodeId>& path) const;
+
+    // Whether the last solve stopped because the stack was full
+    bool outOfMemory() const { return m_outOfMemory; }
+
+    uint32_t iterations() const { return m_iterations; }
+
+    // Table plus the deepest stack of the last solve
+    size_t memoryBytes() const;
+
+private:
+    struct Entry {
+        NodeId nid;
+        Cost g;
+        uint32_t iteration;
+    };
+
+    struct Frame {
+        NodeId nid;
+        Cost g;
+        uint8_t moves;     // Direction bits not yet tried
+    };
+
+    // False if nid was already reached as cheaply during this query
+    bool visit(NodeId nid, Cost g);
+
+    std::vector<Entry> m_table;
+    uint32_t m_iteration;          // kept across queries, so no clearing
+    uint32_t m_firstIteration;     // of the current query
+
+    std::vector<Frame> m_stack;    // reserved to maxFrames, so never regrown
+    size_t m_maxFrames;
+    size_t m_maxDepth;
+    bool m_outOfMemory;
+    uint32_t m_iterations;
+    Cost m_pathCost;
+};
+
+#endif /* A_STAR_IDA_STAR_SOLVER_HPP */
@@ -0,0 +1,160 @@
+#ifndef A_STAR_INDEXED_HEAP_HPP
+#define A_STAR_INDEXED_HEAP_HPP
+
+#include "node.hpp"
+#include <cstddef>
+#include <vector>
+
+// Index-addressed d-ary min-heap of NodeIds keyed on a cached f-value.
+//
+// Every node remembers its slot in the heap, which gives O(log n)
+// decrease-key without searching. Ties on f are broken towards the lower
+// h (i.e. the node closer to the goal). The slot table is never cleared:
+// a slot is only trusted when the heap entry it points at names the same
+// node, so clear() is O(1).
+template <typename Key, int Arity = 4>
+class IndexedHeap {
+public:
+    explicit IndexedHeap(size_t numNodes = 0) { resize(numNodes); }
+
+    void resize(size_t numNodes) { m_slot.assign(numNodes, 0); m_heap.clear(); }
+    void clear() { m_heap.clear(); }
+
+    bool empty() const  { return m_heap.empty(); }
+    size_t size() const { return m_heap.size();  }
+    size_t capacity() const { return m_slot.size(); }    // nodes it can hold
+
+    bool contains(NodeId nid) const {
+        uint32_t slot = m_slot[nid];
+        return slot < m_heap.size() && m_heap[slot].nid == nid;
+    }
+
+    NodeId top() const  { return m_heap.front().nid; }
+    Key topKey() const  { return m_heap.front().f;   }
+
+    void push(NodeId nid, Key f, Key h) {
+        m_heap.push_back(Entry{ f, h, nid });
+        siftUp(static_cast<uint32_t>(m_heap.size() - 1));
+    }
+
+    // f may only go down; h of a node never changes within a query
+    void decreaseKey(NodeId nid, Key f) {
+        uint32_t slot = m_slot[nid];
+        m_heap[slot].f = f;
+        siftUp(slot);
+    }
+
+    // Moves a queued node to an arbitrary new key
+    void update(NodeId nid, Key f) {
+        uint32_t slot = m_slot[nid];
+        bool lower = f < m_heap[slot].f;
+        m_heap[slot].f = f;
+
+        if (lower)
+            siftUp(slot);
+        else
+            siftDown(slot);
+    }
+
+    void remove(NodeId nid) {
+        uint32_t slot = m_slot[nid];
+        Entry last = m_heap.back();
+        m_heap.pop_back();
+
+        if (slot < m_heap.size()) {
+            place(slot, last);
+            siftUp(slot);
+            siftDown(m_slot[last.nid]);
+        }
+    }
+
+    // Calls fn(nid) for every queued node, in no particular order
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const Entry& entry : m_heap) {
+            fn(entry.nid);
+        }
+    }
+
+    // Replaces every key with keyOf(nid) and restores heap order in O(n);
+    // keys may move either way
+    template <typename KeyFn>
+    void rekey(KeyFn&& keyOf) {
+        for (Entry& entry : m_heap) {
+            entry.f = keyOf(entry.nid);
+        }
+        for (uint32_t slot = static_cast<uint32_t>(m_heap.size()); slot-- > 0; ) {
+            siftDown(slot);
+        }
+    }
+
+    NodeId pop() {
+        NodeId nid = m_heap.front().nid;
+        Entry last = m_heap.back();
+        m_heap.pop_back();
+
+        if (!m_heap.empty()) {
+            m_heap.front() = last;
+            siftDown(0);
+        }
+        return nid;
+    }
+
+private:
+    struct Entry {
+        Key f;
+        Key h;
+        NodeId nid;
+    };
+
+    static bool less(const Entry& a, const Entry& b) {
+        return a.f < b.f || (a.f == b.f && a.h < b.h);
+    }
+
+    void place(uint32_t slot, const Entry& entry) {
+        m_heap[slot] = entry;
+        m_slot[entry.nid] = slot;
+    }
+
+    void siftUp(uint32_t slot) {
+        Entry entry = m_heap[slot];
+
+        while (slot > 0) {
+            uint32_t parent = (slot - 1) / Arity;
+            if (!less(entry, m_heap[parent]))
+                break;
+            place(slot, m_heap[parent]);
+            slot = parent;
+        }
+        place(slot, entry);
+    }
+
+    void siftDown(uint32_t slot) {
+        Entry entry = m_heap[slot];
+        uint32_t count = static_cast<uint32_t>(m_heap.size());
+
+        while (true) {
+            uint32_t first = slot * Arity + 1;
+            if (first >= count)
+                break;
+
+            uint32_t last = (first + Arity < count) ? first + Arity : count;
+            uint32_t best = first;
+            for (uint32_t child = first + 1; child < last; ++child) {
+                if (less(m_heap[child], m_heap[best]))
+                    best = child;
+            }
+
+            if (!less(m_heap[best], entry))
+                break;
+            place(slot, m_heap[best]);
+            slot = best;
+        }
+        place(slot, entry);
+    }
+
+    std::vector<Entry> m_heap;
+    std::vector<uint32_t> m_slot;
+};
+
+#endif /* A_STAR_INDEXED_HEAP_HPP */
@@ -0,0 +1,51 @@
+#ifndef A_STAR_JPS_PLUS_TABLE_HPP
+#define A_STAR_JPS_PLUS_TABLE_HPP
+
+#include "grid_edit_listener.hpp"
+#include "node.hpp"
+#include <vector>
+
+// JPS+ jump-distance tables: for every cell and each of the 8 directions,
+// the distance along that direction to the next jump point (> 0) or the
+// number of free cells before the next wall (<= 0, negated). A JPS query
+// then reads a successor out of the table instead of scanning the grid.
+//
+// The table follows obstacle edits incrementally: straight entries are
+// recomputed only on the rows and columns through and next to an edited
+// cell, and diagonal entries are walked back from every cell whose
+// straight entries or neighborhood changed until the values settle.
+// Distances are 16 bit, so a side of the map may be at most 32767 cells.
+class JpsPlusTable : public GridEditListener {
+public:
+    JpsPlusTable();
+
+    void rebuild(const NodeGrid& grid);
+
+    int distance(NodeId nid, int dir) const { return m_dist[static_cast<size_t>(nid) * NUM_DIRECTIONS + dir]; }
+
+    void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onTerrainChanged(const NodeGrid&, const std::vector<NodeId>&) override {}    // jumps ignore costs
+    void onMapReset(const NodeGrid& grid) override;
+
+private:
+    int16_t& entry(int x, int y, int dir) {
+        return m_dist[(static_cast<size_t>(y) * m_columns + x) * NUM_DIRECTIONS + dir];
+    }
+
+    bool isFree(int x, int y) const;
+
+    // Recompute a whole row (east/west) or column (north/south); cells whose
+    // entries change are appended to changed
+    void computeRow(int y, std::vector<NodeId>* changed);
+    void computeColumn(int x, std::vector<NodeId>* changed);
+    void computeStraightLine(int x, int y, int dir, std::vector<NodeId>* changed);
+
+    int16_t diagonalValue(int x, int y, int dir) const;
+    void computeAllDiagonals();
+
+    const NodeGrid* m_grid;
+    int m_rows, m_columns;
+    std::vector<int16_t> m_dist;
+};
+
+#endif /* A_STAR_JPS_PLUS_TABLE_HPP */
@@ -0,0 +1,58 @@
+#ifndef A_STAR_JPS_SOLVER_HPP
+#define A_STAR_JPS_SOLVER_HPP
+
+#include "indexed_heap.hpp"
+#include "jps_plus_table.hpp"
+#include "search_state.hpp"
+#include <deque>
+
+class NodeGrid;
+
+// Jump Point Search (Harabor & Grastien) for the uniform-cost 8-connected
+// movement model of NodeGrid, where diagonal steps may pass blocked
+// corners. Symmetric paths are pruned and only jump points enter the open
+// list, yet path costs are the same as A*'s.
+//
+// The parent of a jump point is the previous jump point, joined to it by
+// a straight or diagonal run. Horizontal jumps scan the obstacle bitmap
+// 64 cells at a time. Given a JpsPlusTable (JPS+) the jumps become table
+// lookups, with the goal found by checking whether it lies on, or in the
+// quadrant of, each run.
+class JpsSolver {
+public:
+    JpsSolver(const NodeGrid& grid, SearchState& state, IndexedHeap<Cost>& openList,
+              const JpsPlusTable* table = nullptr);
+
+    // Searches from start to goal and appends every expanded jump point
+    // except the start to trace. Returns true if the goal was reached.
+    bool solve(NodeId start, NodeId goal, SearchStats& stats, std::deque<TraceEntry>& trace);
+
+    // Travel cost of a straight or diagonal run between two cells
+    static Cost runCost(int dx, int dy);
+
+private:
+    bool isFree(int x, int y) const;
+
+    // Directions worth searching from nid given how it was reached
+    uint8_t successorDirections(NodeId nid, NodeId parent) const;
+
+    // Jump from (x, y), the first cell of a run in direction (dx, dy).
+    // Returns the jump point found or INVALID_NODE.
+    NodeId jump(int x, int y, int dx, int dy) const;
+    NodeId jumpHorizontal(int x, int y, int dx) const;
+    NodeId jumpVertical(int x, int y, int dy) const;
+
+    // Successor of (x, y) in direction dir, from the table or by jumping
+    NodeId successor(int x, int y, int dir) const;
+    NodeId tableSuccessor(int x, int y, int dir) const;
+
+    const NodeGrid& m_grid;
+    SearchState& m_state;
+    IndexedHeap<Cost>& m_openList;
+    const JpsPlusTable* m_table;
+
+    NodeId m_goal;
+    int m_goalX, m_goalY;
+};
+
+#endif /* A_STAR_JPS_SOLVER_HPP */
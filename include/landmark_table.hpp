@@ -0,0 +1,91 @@
+#ifndef A_STAR_LANDMARK_TABLE_HPP
+#define A_STAR_LANDMARK_TABLE_HPP
+
+#include "grid_edit_listener.hpp"
+#include "node.hpp"
+#include <cstddef>
+#include <vector>
+
+class NodeGrid;
+
+// Landmark distance tables for the ALT heuristic (Goldberg & Harrelson).
+// For a handful of landmarks L the exact distance d(L, v) to every node is
+// precomputed, and by the triangle inequality |d(L, t) - d(L, v)| is a
+// lower bound on d(v, t), one that sees the walls octile distance ignores.
+//
+// Landmarks are picked farthest-point first on the largest connected
+// region, then one Dijkstra per landmark runs on a pool of threads.
+// Distances are stored as 16-bit multiples of a per-table quantum, all
+// landmarks of a node side by side, and unreachable nodes as UNREACHABLE.
+//
+// Any edit can shorten distances, so an edit marks the tables stale and
+// the owner rebuilds them before the next query that uses them. Tables
+// can be saved and loaded again as long as the map is the same.
+class LandmarkTable : public GridEditListener {
+public:
+    static constexpr int DEFAULT_LANDMARKS = 8;
+    static constexpr uint16_t UNREACHABLE = UINT16_MAX;
+
+    explicit LandmarkTable(int numLandmarks = DEFAULT_LANDMARKS);
+
+    // Picks the landmarks and fills the tables; numThreads = 0 uses one
+    // thread per hardware thread
+    void rebuild(const NodeGrid& grid, unsigned numThreads = 0);
+
+    // False once the map was edited, resized or its moves changed since the
+    // tables were built or loaded
+    bool isCurrent(const NodeGrid& grid) const;
+
+    int landmarkCount() const { return static_cast<int>(m_landmarks.size()); }
+    NodeId landmark(int i) const { return m_landmarks[i]; }
+    Cost quantum() const { return m_quantum; }
+    size_t memoryBytes() const { return m_dist.size() * sizeof(uint16_t); }
+
+    // Quantized distances of one node to every landmark
+    const uint16_t* distances(NodeId nid) const {
+        return m_dist.data() + static_cast<size_t>(nid) * m_landmarks.size();
+    }
+
+    // Binary dump of the tables, tagged with the map they belong to. load
+    // fails and leaves the table untouched if the file is for another map.
+    bool save(const char* path) const;
+    bool load(const NodeGrid& grid, const char* path);
+
+    void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onMapReset(const NodeGrid& grid) override;
+
+private:
+    std::vector<NodeId> selectLandmarks(const NodeGrid& grid) const;
+
+    int m_numLandmarks;
+    const NodeGrid* m_grid;
+    bool m_stale;
+
+    int m_rows, m_columns;
+    Connectivity m_connectivity;
+    CornerRule m_cornerRule;
+    Cost m_quantum;
+
+    std::vector<NodeId>   m_landmarks;
+    std::vector<uint16_t> m_dist;    // node-major, landmarkCount() per node
+};
+
+// ALT heuristic towards one goal: the larger of the octile distance and the
+// best landmark bound. Distances are rounded down to multiples of the
+// quantum, so the bound is lowered by one quantum to stay admissible. It is
+// not quite consistent (neighbors may differ by up to a quantum more than
+// their step cost), which A* handles by reopening closed nodes.
+class LandmarkHeuristic {
+public:
+    LandmarkHeuristic(const NodeGrid& grid, const LandmarkTable& table, NodeId goal);
+
+    Cost operator()(NodeId nid) const;
+
+private:
+    const NodeGrid& m_grid;
+    const LandmarkTable& m_table;
+    NodeId m_goal;
+    std::vector<uint16_t> m_goalDist;
+};
+
+#endif /* A_STAR_LANDMARK_TABLE_HPP */
@@ -1,70 +1,148 @@
 #ifndef A_STAR_NODE_HPP
 #define A_STAR_NODE_HPP
 
-#include <vector>
-#include <memory>
 #include <cmath>
+#include <cstdint>
 
-class Node;
-
-typedef std::shared_ptr<Node> NodePtr;
-
-class Node {
-public:
-    Node(int x, int y, int nid)
-        : m_x(x), m_y(y)
-        , m_nid(nid)
-        , m_isObstacle(false)
-        , m_isVisited(false)
-        , m_isStartNode(false)
-        , m_isEndNode(false)
-        , parent(nullptr)
-    {
-        // printf("Creating new Node[x,y] = [%d, %d]\n", m_x, m_y);
-    }
+// Nodes are addressed by their 32-bit cell index (y * columns + x) into
+// the packed per-cell arrays held by NodeGrid.
+typedef uint32_t NodeId;
+
+static constexpr NodeId INVALID_NODE = UINT32_MAX;
+
+enum NodeFlags : uint8_t {
+    NODE_START    = 1 << 0,
+    NODE_END      = 1 << 1,
+};
+
+// Move directions: the four straight moves come first so that
+// 4-connected iteration is simply a prefix of the 8-connected one.
+enum Direction : uint8_t {
+    DIR_EAST, DIR_SOUTH, DIR_WEST, DIR_NORTH,
+    DIR_SOUTH_EAST, DIR_SOUTH_WEST, DIR_NORTH_WEST, DIR_NORTH_EAST,
+    NUM_DIRECTIONS
+};
+
+static constexpr int DIR_DX[NUM_DIRECTIONS] = { 1, 0, -1,  0, 1, -1, -1,  1 };
+static constexpr int DIR_DY[NUM_DIRECTIONS] = { 0, 1,  0, -1, 1,  1, -1, -1 };
+
+// Direction for a unit step (dx, dy), indexed by (dy + 1) * 3 + (dx + 1)
+static constexpr Direction STEP_DIRECTION[9] = {
+    DIR_NORTH_WEST, DIR_NORTH, DIR_NORTH_EAST,
+    DIR_WEST,       DIR_EAST,  DIR_EAST,    // centre entry is never used
+    DIR_SOUTH_WEST, DIR_SOUTH, DIR_SOUTH_EAST,
+};
+
+inline Direction stepDirection(int dx, int dy) {
+    return STEP_DIRECTION[(dy + 1) * 3 + (dx + 1)];
+}
+
+// Fixed-point move costs: a straight step costs COST_STRAIGHT and a
+// diagonal step COST_DIAGONAL, i.e. sqrt(2) to three decimals.
+typedef uint32_t Cost;
 
-    NodePtr parent;
-    std::vector<NodePtr> adjNodes;
+static constexpr Cost COST_STRAIGHT = 1000;
+static constexpr Cost COST_DIAGONAL = 1414;
+static constexpr Cost COST_INFINITY = UINT32_MAX;
 
-    int x()   { return m_x;   }
-    int y()   { return m_y;   }
-    int nid() { return m_nid; }
+static constexpr Cost DIR_COST[NUM_DIRECTIONS] = {
+    COST_STRAIGHT, COST_STRAIGHT, COST_STRAIGHT, COST_STRAIGHT,
+    COST_DIAGONAL, COST_DIAGONAL, COST_DIAGONAL, COST_DIAGONAL
+};
+
+// Terrain multipliers (NodeGrid::setTerrain) weigh a move by both of its
+// cells: HALF_DIR_COST[dir] * (terrain(from) + terrain(to)), which is
+// DIR_COST[dir] between two plain cells. Costs are uint32, so a path
+// overflows past about 4.29 million straight steps at multiplier 1, or
+// 16.8 thousand across cells of TERRAIN_MAX.
+static constexpr uint8_t TERRAIN_PLAIN = 1;
+static constexpr uint8_t TERRAIN_MAX   = UINT8_MAX;
 
-    bool isObstacle()  { return m_isObstacle;  }
-    bool isVisited()   { return m_isVisited;   }
-    bool isStartNode() { return m_isStartNode; }
-    bool isEndNode()   { return m_isEndNode;   }
+static constexpr Cost HALF_DIR_COST[NUM_DIRECTIONS] = {
+    COST_STRAIGHT / 2, COST_STRAIGHT / 2, COST_STRAIGHT / 2, COST_STRAIGHT / 2,
+    COST_DIAGONAL / 2, COST_DIAGONAL / 2, COST_DIAGONAL / 2, COST_DIAGONAL / 2
+};
 
-    void toggleObstacle()         { m_isObstacle  = !m_isObstacle; }
-    void setVisited(bool _flag)   { m_isVisited   = _flag; }
-    void setStartNode(bool _flag) { m_isStartNode = _flag; }
-    void setEndNode(bool _flag)   { m_isEndNode   = _flag; }
+// Fixed-point cost back to grid units
+inline float costToFloat(Cost cost) {
+    return (cost == COST_INFINITY) ? INFINITY : static_cast<float>(cost) / COST_STRAIGHT;
+}
 
-    void setDistFromStart(float dist) { m_distFromStart = dist; }
-    float distFromStart() { return m_distFromStart; }
+enum class Connectivity : int {
+    FOUR  = 4,
+    EIGHT = 8,
+};
 
-    void setDistToEnd(float dist) { m_distToEnd = dist; }
-    float distToEnd() {  return m_distToEnd; }
+// Which diagonal moves are allowed next to blocked straight neighbors
+enum class CornerRule {
+    CUT_CORNERS,    // any diagonal into a free cell
+    NO_SQUEEZE,     // not between two blocked cells
+    NO_CUTTING,     // only with both straight neighbors free
+};
 
-    void clearFlags() {
-        m_isObstacle  = false;
-        m_isVisited   = false;
-        m_isStartNode = false;
-        m_isEndNode   = false;
+// Heuristic of the A* solver
+enum class HeuristicType {
+    OCTILE,         // Manhattan when 4-connected
+    MANHATTAN,
+    EUCLIDEAN,
+    ZERO,           // plain Dijkstra
+};
+
+enum class SolverType {
+    ASTAR,          // A* over every grid cell
+    JPS,            // Jump Point Search, 8-connected only
+    JPS_PLUS,       // JPS over precomputed jump distances, 8-connected only
+    BIDIRECTIONAL,  // A* from both ends, meeting in the middle
+    HPA,            // hierarchical A* over sectors, near-optimal paths
+    ARA,            // anytime repairing A*, improves a weighted A* path
+    DSTAR_LITE,     // incremental, repairs its last search after edits
+    FRINGE,         // Fringe Search, f-limited iterations over an unsorted list
+    IDA_STAR,       // iterative deepening A*, memory bounded
+    THETA,          // any-angle Theta*, paths of straight segments
+    LAZY_THETA,     // Theta* checking line of sight only on expansion
+    CPD,            // first-move lookups in a precomputed path database
+};
+
+inline const char* solverName(SolverType type) {
+    switch (type) {
+        case SolverType::ASTAR:         return "A*";
+        case SolverType::JPS:           return "JPS";
+        case SolverType::JPS_PLUS:      return "JPS+";
+        case SolverType::BIDIRECTIONAL: return "BiA*";
+        case SolverType::HPA:           return "HPA*";
+        case SolverType::ARA:           return "ARA*";
+        case SolverType::DSTAR_LITE:    return "D* Lite";
+        case SolverType::FRINGE:        return "Fringe";
+        case SolverType::IDA_STAR:      return "IDA*";
+        case SolverType::THETA:         return "Theta*";
+        case SolverType::LAZY_THETA:    return "Lazy Theta*";
+        case SolverType::CPD:           return "CPD";
     }
+    return "?";
+}
 
-private:
-    int m_x;
-    int m_y;
-    int m_nid;
+inline const char* cornerRuleName(CornerRule rule) {
+    switch (rule) {
+        case CornerRule::CUT_CORNERS: return "cut corners";
+        case CornerRule::NO_SQUEEZE:  return "no squeeze";
+        case CornerRule::NO_CUTTING:  return "no cutting";
+    }
+    return "?";
+}
 
-    bool m_isObstacle;
-    bool m_isVisited;
-    bool m_isStartNode;
-    bool m_isEndNode;
+inline const char* heuristicName(HeuristicType type) {
+    switch (type) {
+        case HeuristicType::OCTILE:    return "octile";
+        case HeuristicType::MANHATTAN: return "manhattan";
+        case HeuristicType::EUCLIDEAN: return "euclidean";
+        case HeuristicType::ZERO:      return "zero";
+    }
+    return "?";
+}
 
-    float m_distFromStart = INFINITY;
-    float m_distToEnd = INFINITY;
+enum class OpenListType {
+    HEAP,      // indexed 4-ary heap
+    BUCKET,    // Dial bucket queue over integer f
 };
 
-#endif /* A_STAR_NODE_HPP */
\ No newline at end of file
+#endif /* A_STAR_NODE_HPP */
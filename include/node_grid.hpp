@@ -2,41 +2,440 @@
 #define A_STAR_NODE_GRID_HPP
 
 #include "node.hpp"
+#include "adaptive_heuristic.hpp"
+#include "ara_solver.hpp"
+#include "bucket_queue.hpp"
+#include "component_map.hpp"
+#include "dstar_lite.hpp"
+#include "flow_field.hpp"
+#include "fringe_solver.hpp"
+#include "grid_edit_listener.hpp"
+#include "hpa_map.hpp"
+#include "ida_star_solver.hpp"
+#include "indexed_heap.hpp"
+#include "jps_plus_table.hpp"
+#include "landmark_table.hpp"
+#include "obstacle_bitmap.hpp"
+#include "path_cache.hpp"
+#include "path_database.hpp"
+#include "query_pool.hpp"
+#include "search_context.hpp"
+#include "search_policies.hpp"
+#include "search_state.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <deque>
+#include <memory>
 #include <random>
+#include <vector>
 
 class NodeGrid {
 public:
     NodeGrid(int rows, int columns);
     ~NodeGrid();
 
-    int getRows();
-    int getColumns();
-    int getTotalNodes();
-    std::vector<NodePtr> getNodes();
-    std::vector<NodePtr> getShortestPath();
-    std::deque<NodePtr> getVisitedNodes();
+    int getRows() const;
+    int getColumns() const;
+    int getTotalNodes() const;
+
+    // Path of the last solvePath from end to start node. Every step is to
+    // a neighbor cell, except for the any-angle solvers, whose paths are
+    // their waypoints with a straight line of sight between each pair.
+    const std::vector<NodeId>& getShortestPath() const;
+    const std::deque<TraceEntry>& getVisitedNodes() const;
     void popFrontVisitedNode();
+    const SearchStats& getSearchStats() const { return m_context.stats; }
+
+    // Print progress and the solved path from solvePath (on by default)
+    void setVerbose(bool verbose) { m_verbose = verbose; }
+
+    NodeId getStartNode() const;
+    NodeId getEndNode() const;
+
+    // Per-node accessors into the packed cell arrays
+    int x(NodeId nid) const { return static_cast<int>(nid % m_columns); }
+    int y(NodeId nid) const { return static_cast<int>(nid / m_columns); }
+    NodeId nodeAt(int x, int y) const { return static_cast<NodeId>(y * m_columns + x); }
+
+    bool isObstacle(NodeId nid)  const { return m_obstacles.test(x(nid), y(nid)); }
+    bool isVisited(NodeId nid)   const { return isSearched(m_context.search, nid) || isSearched(m_context.reverseSearch, nid); }
+    bool isStartNode(NodeId nid) const { return m_flags[nid] & NODE_START;    }
+    bool isEndNode(NodeId nid)   const { return m_flags[nid] & NODE_END;      }
+
+    // Search state of the last query; nodes it did not reach, and all of
+    // them after a solver with its own state, have no parent or distances
+    NodeId getParent(NodeId nid) const {
+        return isSearched(m_context.search, nid) ? m_context.search.parent(nid) : INVALID_NODE;
+    }
+    float distFromStart(NodeId nid) const {
+        return costToFloat(isSearched(m_context.search, nid) ? m_context.search.gRaw(nid) : COST_INFINITY);
+    }
+    float distToEnd(NodeId nid) const {
+        return costToFloat(isSearched(m_context.search, nid) ? m_context.search.hRaw(nid) : COST_INFINITY);
+    }
+
+    // Cost of the path found by the last solvePath, infinite if none was.
+    // Solvers that do not settle the end node in the forward search (the
+    // bidirectional one) report it only here, not via distFromStart.
+    float getPathCost() const { return costToFloat(m_context.pathCost); }
+
+    // Proven bound on how far that cost may be above the optimal one, as a
+    // factor: 1 for the exact solvers, the weight for weighted A*, the
+    // latest epsilon bound for ARA*, infinite if none is known (HPA*,
+    // any-angle Theta*)
+    float getPathBound() const { return m_context.pathBound; }
+
+    Connectivity getConnectivity() const { return m_connectivity; }
+    void setConnectivity(Connectivity connectivity) { m_connectivity = connectivity; }
+
+    // Diagonal moves past blocked cells (cutting corners by default). The
+    // rule applies to every solver; JPS and JPS+ assume corner cutting and
+    // fall back to A* under the other rules.
+    CornerRule getCornerRule() const { return m_cornerRule; }
+    void setCornerRule(CornerRule rule) { m_cornerRule = rule; }
+
+    // Heuristic of the A* solver when landmarks are off (octile by default).
+    // Manhattan overestimates diagonal moves, so it trades optimality for
+    // speed when 8-connected. The other solvers always use heuristicCost.
+    HeuristicType getHeuristicType() const { return m_heuristicType; }
+    void setHeuristicType(HeuristicType type) { m_heuristicType = type; }
+
+    // Weighted A*: the A* solver inflates its heuristic by this factor
+    // (1 by default, i.e. optimal) and finds paths at most that factor
+    // above optimal while expanding far fewer nodes
+    float getWeight() const { return m_weight; }
+    void setWeight(float weight) { m_weight = std::max(1.0f, weight); }
+
+    // ARA* starts at this epsilon and keeps improving its path until the
+    // time budget runs out or the path is proven optimal. Every improved
+    // path is published with its bound, the last one becomes the result.
+    float getAnytimeEpsilon() const { return m_anytimeEpsilon; }
+    void setAnytimeEpsilon(float epsilon) { m_anytimeEpsilon = std::max(1.0f, epsilon); }
+    double getAnytimeBudgetMs() const { return m_anytimeBudgetMs; }
+    void setAnytimeBudgetMs(double budgetMs) { m_anytimeBudgetMs = budgetMs; }
+    const std::vector<AnytimeSolution>& getAnytimeSolutions() const { return m_anytimeSolutions; }
+
+    // Memory ceiling of the Fringe and IDA* solvers (16 MB by default).
+    // A quarter goes to the visited trace, which stops recording when
+    // full, and the rest to the solver, which needs nothing per cell:
+    // Fringe keeps the nodes it reaches in a table of that size, IDA* its
+    // transposition table and stack. A Fringe query that reaches more
+    // nodes than fit runs again as IDA*.
+    static constexpr size_t DEFAULT_MEMORY_LIMIT = size_t(16) << 20;
+    size_t getMemoryLimit() const { return m_memoryLimit; }
+    void setMemoryLimit(size_t bytes) { m_memoryLimit = bytes; }
+
+    OpenListType getOpenListType() const { return m_openListType; }
+    void setOpenListType(OpenListType type) { m_openListType = type; }
+
+    // Solver used by solvePath. JPS and JPS+ need 8-connectivity and fall
+    // back to A* otherwise; they and the bidirectional search always use
+    // the heap open list.
+    SolverType getSolverType() const { return m_solverType; }
+    void setSolverType(SolverType type) { m_solverType = type; }
+
+    // JPS+ tables, built on first use and then kept in step with edits
+    const JpsPlusTable& getJpsPlusTable();
+
+    // HPA* sector graph, built on first use and then kept in step with edits
+    HpaMap& getHpaMap();
+
+    // D* Lite search kept across queries, created on first use. Edits and
+    // start moves are repaired by the next solvePath instead of a new search.
+    DStarLite& getDStarLite();
+
+    // ALT landmark heuristic for the A* solver (off by default). The tables
+    // are built on first use and rebuilt on the first use after an edit.
+    bool getUseLandmarks() const { return m_useLandmarks; }
+    void setUseLandmarks(bool useLandmarks) { m_useLandmarks = useLandmarks; }
+    const LandmarkTable& getLandmarkTable();
+
+    // Replaces the landmark tables with ones saved for this exact map
+    bool loadLandmarkTable(const char* path);
+
+    // Compressed path database of the CPD solver, which runs A* while
+    // there is none for the current map. It takes a Dijkstra per free
+    // cell, so it is never built on demand: build it offline on
+    // numThreads threads (all for 0) and save it, or load, memory mapped,
+    // one saved for this exact map. Edits make it stale.
+    const PathDatabase& buildPathDatabase(unsigned numThreads = 0);
+    bool loadPathDatabase(const char* path);
+    const PathDatabase* getPathDatabase() const { return m_pathDatabase.get(); }
+
+    // Adaptive A* for the A* solver when landmarks are off (off by
+    // default): each unweighted search raises the heuristic of the nodes
+    // it expanded, and later queries to the same goal start from those
+    // values instead of heuristicCost. Weighted searches use but do not
+    // learn values, and the heuristic type is ignored.
+    bool getUseAdaptive() const { return m_useAdaptive; }
+    void setUseAdaptive(bool useAdaptive) { m_useAdaptive = useAdaptive; }
+    const AdaptiveHeuristic& getAdaptiveHeuristic();
+
+    // Flow field towards goal for agents that share it, built on first use
+    // and then repaired with every edit. The fields of the most recently
+    // used MAX_FLOW_FIELDS goals are kept, older ones are dropped.
+    static constexpr size_t MAX_FLOW_FIELDS = 8;
+    const FlowField& getFlowField(NodeId goal);
+
+    // Connected region of every free cell, built on first use and then
+    // kept in step with edits. With components on (the default)
+    // solvePath rejects a start and end node in different regions before
+    // running any solver, building the map on its first call, and so does
+    // solve once the map is built (prepareQueries). Turning them off
+    // skips the labels and their upkeep on edits.
+    bool getUseComponents() const { return m_useComponents; }
+    void setUseComponents(bool useComponents) { m_useComponents = useComponents; }
+    const ComponentMap& getComponentMap();
+
+    // LRU cache of solvePath results (off by default, capacity 0), valid
+    // for the current map and settings and patched by edits. It holds the
+    // paths of every solver but ARA*, whose result depends on its time
+    // budget, and the any-angle ones. A hit runs no search, so it leaves
+    // no trace, search state or expansions behind.
+    size_t getPathCacheCapacity() const { return m_pathCache.capacity(); }
+    void setPathCacheCapacity(size_t paths) { m_pathCache.setCapacity(paths); }
+    const PathCache& getPathCache() const { return m_pathCache; }
+
+    // Admissible and consistent estimate of the cost between two nodes:
+    // octile distance when 8-connected, Manhattan distance when 4-connected,
+    // times the smallest terrain multiplier on the map
+    Cost heuristicCost(NodeId node_A, NodeId node_B) const {
+        Cost dx = static_cast<Cost>(std::abs(x(node_A) - x(node_B)));
+        Cost dy = static_cast<Cost>(std::abs(y(node_A) - y(node_B)));
+
+        if (m_connectivity == Connectivity::FOUR)
+            return COST_STRAIGHT * (dx + dy) * m_minTerrain;
+
+        Cost lo = std::min(dx, dy);
+        Cost hi = std::max(dx, dy);
+        return (COST_STRAIGHT * hi + (COST_DIAGONAL - COST_STRAIGHT) * lo) * m_minTerrain;
+    }
+
+    // Cost of the move from a cell to its neighbor in direction dir
+    Cost stepCost(NodeId from, NodeId to, Direction dir) const {
+        if (m_terrain.empty())
+            return DIR_COST[dir];
+        return HALF_DIR_COST[dir] * (Cost(m_terrain[from]) + m_terrain[to]);
+    }
+    Cost stepCost(NodeId from, NodeId to) const {
+        return stepCost(from, to, stepDirection(x(to) - x(from), y(to) - y(from)));
+    }
+
+    const ObstacleBitmap& getObstacles() const { return m_obstacles; }
 
-    NodePtr getStartNode();
-    NodePtr getEndNode();
+    // Bit per Direction set for every neighbor a free node can move to,
+    // read from the 3x3 block of the obstacle bitmap in three word loads.
+    uint8_t freeNeighbors(NodeId nid) const {
+        int node_x = x(nid);
+        int node_y = y(nid);
+
+        if (m_obstacles.test(node_x, node_y))
+            return 0;
+
+        uint8_t blocked = m_obstacles.blockedNeighbors(node_x, node_y);
+        if (m_connectivity == Connectivity::FOUR)
+            return ~blocked & 0x0F;
+
+        switch (m_cornerRule) {
+            case CornerRule::NO_SQUEEZE: return ~blocked & NoSqueezing::allowed(blocked);
+            case CornerRule::NO_CUTTING: return ~blocked & NoCornerCutting::allowed(blocked);
+            default:                     return ~blocked;
+        }
+    }
+
+    // Calls fn(adj, dir) for every free neighbor of a free node. Neighbors
+    // are derived from the coordinates and obstacle bitmap on the fly, so
+    // nothing has to be rebuilt when obstacles change.
+    template <typename Fn>
+    void forEachNeighbor(NodeId nid, Fn&& fn) const {
+        unsigned dirs = freeNeighbors(nid);
+
+        while (dirs) {
+            int dir = __builtin_ctz(dirs);
+            dirs &= dirs - 1;
+            fn(nid + m_dirOffset[dir], static_cast<Direction>(dir));
+        }
+    }
+
+    // True if the straight segment between the two cell centers passes
+    // only through free cells. Touching the corner of a blocked cell
+    // follows the corner rule, as 4-connected grids follow no cutting, so
+    // every move freeNeighbors allows is also in sight. One bitmap span
+    // check, 64 cells per word, per row or column the segment crosses,
+    // whichever are fewer.
+    bool hasLineOfSight(NodeId from, NodeId to) const;
+
+    // Obstacle edits. Every call commits on its own unless it runs inside
+    // a beginEdit()/commitEdit() transaction, in which case listeners are
+    // notified once at commit with all the cells that flipped. Edits cost
+    // O(changed cells); start and end nodes can not be blocked.
+    void setObstacle(NodeId nid, bool blocked);
+    void toggleObstacle(NodeId nid);
+    void setObstacleRect(int x0, int y0, int x1, int y1, bool blocked);
+    void setObstacles(const std::vector<NodeId>& cells, bool blocked);
+
+    // Terrain cost layer: a multiplier per cell from TERRAIN_PLAIN to
+    // TERRAIN_MAX (0 is taken as plain) that weighs every move by both of
+    // its cells, see HALF_DIR_COST. It takes one byte per cell, and none
+    // while every cell is plain. Heuristics scale by the smallest
+    // multiplier on the map, which keeps them admissible and consistent;
+    // a few cheap roads across costly ground leave them weak. Terrain
+    // edits join the obstacle transactions below and reach listeners
+    // through onTerrainChanged. JPS, JPS+ and the any-angle solvers assume
+    // uniform costs and run as A* while the map has terrain.
+    uint8_t getTerrain(NodeId nid) const {
+        return m_terrain.empty() ? TERRAIN_PLAIN : m_terrain[nid];
+    }
+    bool hasTerrain() const { return !m_terrain.empty(); }
+    const uint8_t* getTerrainData() const { return m_terrain.empty() ? nullptr : m_terrain.data(); }
+    uint8_t getMinTerrain() const { return m_minTerrain; }
+    uint8_t getMaxTerrain() const { return m_maxTerrain; }
+
+    void setTerrain(NodeId nid, uint8_t multiplier);
+    void setTerrainRect(int x0, int y0, int x1, int y1, uint8_t multiplier);
+    void setTerrains(const std::vector<NodeId>& cells, uint8_t multiplier);
+    void clearTerrain();
+
+    void beginEdit();
+    void commitEdit();
+
+    // Bumped by every committed edit and every map reset
+    uint32_t getMapRevision() const { return m_mapRevision; }
+
+    // Hash of the obstacle layout and terrain. Files of precomputed tables
+    // are tagged with it so they load only for the map they were made for
+    uint64_t getMapFingerprint() const;
+
+    void addEditListener(GridEditListener* listener);
+    void removeEditListener(GridEditListener* listener);
 
     void initGridNodes(int totalNodes);
     void setStartNode(int nodeId);
     void setEndNode(int nodeId);
 
     void randomizeObstacles();
-    void updateNodeAdjacency();
+    void resetSearch();
     void solvePath();
 
+    // Solves from start to goal into context with the current settings,
+    // reading nothing but the map and tables already built, so threads
+    // may call it at once with a context each while the map is not
+    // edited. JPS+ and landmarks need their tables built beforehand
+    // (prepareQueries); without them JPS and the plain heuristic run, and
+    // CPD runs A* without a current database. Solvers with state of their
+    // own (HPA*, ARA*, D* Lite, Fringe, IDA*, adaptive A*) run as A*.
+    // Returns false if goal is unreachable.
+    bool solve(NodeId start, NodeId goal, SearchContext& context) const;
+
+    // Builds or refreshes the tables the current settings use in solve
+    void prepareQueries();
+
+    // Solves count queries on a pool of numThreads worker threads (every
+    // hardware thread for 0), kept for later batches. Each worker solves
+    // into a context of its own, reused across batches, and writes each
+    // path into the buffer of its query; only the map is shared.
+    BatchStats solveBatch(BatchQuery* queries, size_t count, unsigned numThreads = 0);
+
 protected:
     std::default_random_engine generator;
 
 private:
+    // A* through PolicySearch, specialised on the connectivity, corner
+    // rule and open list selected at runtime
+    template <typename Heuristic>
+    void runAStar(NodeId start, NodeId goal, const Heuristic& heuristic,
+                  SearchContext& context) const;
+    template <typename Heuristic>
+    void runWeightedAStar(NodeId start, NodeId goal, const Heuristic& heuristic,
+                          SearchContext& context) const;
+    template <typename CostModel, typename Heuristic>
+    void runAStarWithCost(NodeId start, NodeId goal, const Heuristic& heuristic,
+                          SearchContext& context) const;
+    template <typename Connectivity, typename Corners, typename CostModel, typename Heuristic>
+    void runAStar(NodeId start, NodeId goal, const Heuristic& heuristic,
+                  SearchContext& context) const;
+
+    // JPS pruning assumes 8-connected moves of uniform cost that may cut
+    // corners
+    bool canJump() const {
+        return m_connectivity == Connectivity::EIGHT && m_cornerRule == CornerRule::CUT_CORNERS &&
+               m_terrain.empty();
+    }
+
+    // Whether state reached nid; false before its arrays are allocated
+    static bool isSearched(const SearchState& state, NodeId nid) {
+        return nid < state.size() && state.isTouched(nid);
+    }
+
+    // Path from goal back to the start of context's forward search
+    void buildShortestPath(NodeId goal, SearchContext& context) const;
+
+    // Every setting a solved path depends on, as the path cache's key
+    uint64_t solverSettings() const;
+
+    void flipObstacle(NodeId nid);
+    void writeTerrain(NodeId nid, uint8_t multiplier);
+    void updateTerrainRange();
+    void notifyMapReset();
+
     int m_rows, m_columns;
-    std::vector<NodePtr> m_NodeGrid, m_shortestPath;
-    std::deque<NodePtr> m_visitedNodes;
-    NodePtr startNode, endNode;
+
+    // Structure-of-arrays cell storage, indexed by NodeId
+    ObstacleBitmap       m_obstacles;
+    ObstacleBitmap       m_columnObstacles;   // transpose, for steep lines of sight
+    std::vector<uint8_t> m_flags;
+    std::vector<uint8_t> m_terrain;           // empty while every cell is plain
+
+    // Cells per terrain multiplier, for the smallest and largest one
+    uint32_t m_terrainCounts[TERRAIN_MAX + 1];
+    uint8_t  m_minTerrain, m_maxTerrain;
+
+    // Search arrays are allocated by the first solver that uses them, so
+    // the solvers with their own state (HPA*, D* Lite, IDA*) run without
+    // them and Fringe without the open lists
+    SearchContext        m_context;
+
+    Connectivity m_connectivity;
+    CornerRule   m_cornerRule;
+    HeuristicType m_heuristicType;
+    float        m_weight;
+    float        m_anytimeEpsilon;
+    double       m_anytimeBudgetMs;
+    size_t       m_memoryLimit;
+    OpenListType m_openListType;
+    SolverType   m_solverType;
+
+    std::unique_ptr<JpsPlusTable> m_jpsPlusTable;
+    std::unique_ptr<HpaMap> m_hpaMap;
+    std::unique_ptr<DStarLite> m_dstarLite;
+    FringeSolver m_fringe;
+    IdaStarSolver m_idaStar;
+    AraSolver m_ara;
+    std::unique_ptr<LandmarkTable> m_landmarkTable;
+    std::unique_ptr<PathDatabase> m_pathDatabase;
+    bool m_useLandmarks;
+    std::unique_ptr<AdaptiveHeuristic> m_adaptiveHeuristic;
+    bool m_useAdaptive;
+    std::vector<std::unique_ptr<FlowField>> m_flowFields;    // most recently used last
+    std::unique_ptr<ComponentMap> m_componentMap;
+    bool m_useComponents;
+    PathCache m_pathCache;
+    int m_dirOffset[NUM_DIRECTIONS];    // NodeId delta per Direction
+
+    std::vector<AnytimeSolution> m_anytimeSolutions;
+    NodeId startNode, endNode;
+
+    // Batch workers and their contexts, one per thread
+    std::unique_ptr<QueryPool> m_queryPool;
+    std::vector<std::unique_ptr<SearchContext>> m_batchContexts;
+
+    int m_editDepth;
+    uint32_t m_mapRevision;
+    std::vector<NodeId> m_pendingEdits;
+    std::vector<NodeId> m_pendingTerrainEdits;
+    std::vector<GridEditListener*> m_editListeners;
+
+    bool m_verbose;
 };
 
 #endif /* A_STAR_NODE_GRID_HPP */
@@ -0,0 +1,170 @@
+#ifndef A_STAR_OBSTACLE_BITMAP_HPP
+#define A_STAR_OBSTACLE_BITMAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Row-major obstacle bitmap, 64 cells per word.
+//
+// Every row is padded with a blocked guard cell on each side plus one spare
+// word, and a blocked guard row sits above and below the map. Neighborhood
+// and line-of-sight queries can therefore read past the map edges without
+// bounds checks: anything outside the map reads as an obstacle.
+class ObstacleBitmap {
+public:
+    static constexpr int BITS_PER_WORD = 64;
+
+    ObstacleBitmap(int width, int height);
+
+    int width()  const { return m_width;  }
+    int height() const { return m_height; }
+    int wordsPerRow() const { return m_stride; }
+
+    // Cell access, valid for x in [-1, width] and y in [-1, height]
+    bool test(int x, int y) const {
+        size_t bit = static_cast<size_t>(x + 1);
+        return (rowWords(y)[bit / BITS_PER_WORD] >> (bit % BITS_PER_WORD)) & 1;
+    }
+    void set(int x, int y)    { rowWords(y)[wordOf(x)] |=  maskOf(x); }
+    void clear(int x, int y)  { rowWords(y)[wordOf(x)] &= ~maskOf(x); }
+    void toggle(int x, int y) { rowWords(y)[wordOf(x)] ^=  maskOf(x); }
+    void assign(int x, int y, bool blocked) { blocked ? set(x, y) : clear(x, y); }
+
+    // 64 consecutive cells of row y starting at column x (bit 0 = column x).
+    // Columns outside the map read as blocked.
+    uint64_t bitsAt(int x, int y) const {
+        size_t bit = static_cast<size_t>(x + 1);
+        const uint64_t* row = rowWords(y);
+        size_t word  = bit / BITS_PER_WORD;
+        unsigned off = bit % BITS_PER_WORD;
+
+        if (off == 0)
+            return row[word];
+        return (row[word] >> off) | (row[word + 1] << (BITS_PER_WORD - off));
+    }
+
+    // Bit per Direction set when that neighbor of (x, y) is blocked
+    uint8_t blockedNeighbors(int x, int y) const {
+        unsigned above = static_cast<unsigned>(bitsAt(x - 1, y - 1)) & 7;
+        unsigned mid   = static_cast<unsigned>(bitsAt(x - 1, y    )) & 7;
+        unsigned below = static_cast<unsigned>(bitsAt(x - 1, y + 1)) & 7;
+
+        return static_cast<uint8_t>(((mid   >> 2) & 1) << 0    // east
+                                  | ((below >> 1) & 1) << 1    // south
+                                  | ((mid       ) & 1) << 2    // west
+                                  | ((above >> 1) & 1) << 3    // north
+                                  | ((below >> 2) & 1) << 4    // south east
+                                  | ((below     ) & 1) << 5    // south west
+                                  | ((above     ) & 1) << 6    // north west
+                                  | ((above >> 2) & 1) << 7);  // north east
+    }
+
+    // Bulk edits over the half-open rectangle [x0, x1) x [y0, y1)
+    void setRect(int x0, int y0, int x1, int y1);
+    void clearRect(int x0, int y0, int x1, int y1);
+    void clearAll();
+
+    // Rebuilds this bitmap as the transpose of source, whose width and
+    // height must be this one's height and width
+    void assignTransposed(const ObstacleBitmap& source);
+
+    // XOR every map cell with a fair coin flip, 64 cells per draw
+    template <typename Generator>
+    void toggleRandomly(Generator& generator) {
+        std::uniform_int_distribution<uint64_t> distribution;
+        for (int y = 0; y < m_height; ++y) {
+            uint64_t* row = rowWords(y);
+            for (int w = 0; w < m_stride; ++w) {
+                row[w] ^= distribution(generator) & m_rowMask[w];
+            }
+        }
+    }
+
+    // Calls fn(x, y) for every cell of [x0, x1) x [y0, y1) whose state
+    // differs from blocked, i.e. the cells an assign of the rect would flip
+    template <typename Fn>
+    void forEachDifferingInRect(int x0, int y0, int x1, int y1, bool blocked, Fn&& fn) const {
+        if (!clipRect(x0, y0, x1, y1))
+            return;
+
+        int wordLo = (x0 + 1) / BITS_PER_WORD;
+        int wordHi = x1 / BITS_PER_WORD;
+
+        for (int y = y0; y < y1; ++y) {
+            const uint64_t* row = rowWords(y);
+            for (int w = wordLo; w <= wordHi; ++w) {
+                uint64_t diff = (blocked ? ~row[w] : row[w]) & rangeMask(w, x0 + 1, x1 + 1);
+                while (diff) {
+                    fn(w * BITS_PER_WORD + __builtin_ctzll(diff) - 1, y);
+                    diff &= diff - 1;
+                }
+            }
+        }
+    }
+
+    size_t count() const;
+    size_t countRow(int y) const;
+    size_t countRect(int x0, int y0, int x1, int y1) const;
+
+    // First blocked / free column >= x in row y, or width() if there is none
+    int findNextObstacle(int x, int y) const;
+    int findNextFreeInRow(int x, int y) const;
+
+    // Row-major scan for the first free cell at or after (x, y); returns
+    // false and leaves x, y untouched if the rest of the map is blocked.
+    bool findNextFree(int& x, int& y) const;
+
+    // True if every cell of row y in [x0, x1] (inclusive) is free, read
+    // 64 cells per word load
+    bool isRowSpanFree(int y, int x0, int x1) const {
+        for (int x = x0; x <= x1; x += BITS_PER_WORD) {
+            int len = std::min(BITS_PER_WORD, x1 - x + 1);
+            uint64_t mask = (len == BITS_PER_WORD) ? ~uint64_t(0) : (uint64_t(1) << len) - 1;
+            if (bitsAt(x, y) & mask)
+                return false;
+        }
+        return true;
+    }
+
+    uint64_t* rowWords(int y) { return &m_words[static_cast<size_t>(y + 1) * m_stride]; }
+    const uint64_t* rowWords(int y) const { return &m_words[static_cast<size_t>(y + 1) * m_stride]; }
+
+private:
+    static size_t wordOf(int x)   { return static_cast<size_t>(x + 1) / BITS_PER_WORD; }
+    static uint64_t maskOf(int x) { return uint64_t(1) << (static_cast<size_t>(x + 1) % BITS_PER_WORD); }
+
+    // Mask of padded bit positions [lo, hi) that fall inside word w
+    static uint64_t rangeMask(int w, int lo, int hi) {
+        int wordLo = w * BITS_PER_WORD;
+        int wordHi = wordLo + BITS_PER_WORD;
+
+        lo = std::max(lo, wordLo);
+        hi = std::min(hi, wordHi);
+        if (lo >= hi)
+            return 0;
+
+        uint64_t upper = (hi - wordLo == BITS_PER_WORD) ? ~uint64_t(0)
+                                                        : (uint64_t(1) << (hi - wordLo)) - 1;
+        return upper & ~((uint64_t(1) << (lo - wordLo)) - 1);
+    }
+
+    // Clamps the half-open rect to the map, false if nothing is left
+    bool clipRect(int& x0, int& y0, int& x1, int& y1) const {
+        x0 = std::max(x0, 0);  x1 = std::min(x1, m_width);
+        y0 = std::max(y0, 0);  y1 = std::min(y1, m_height);
+        return x0 < x1 && y0 < y1;
+    }
+
+    void assignRect(int x0, int y0, int x1, int y1, bool blocked);
+
+    int m_width, m_height;
+    int m_stride;
+
+    std::vector<uint64_t> m_words;
+    std::vector<uint64_t> m_rowMask;    // map cells (no guards) of one row
+};
+
+#endif /* A_STAR_OBSTACLE_BITMAP_HPP */
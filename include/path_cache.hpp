@@ -0,0 +1,115 @@
+#ifndef A_STAR_PATH_CACHE_HPP
+#define A_STAR_PATH_CACHE_HPP
+
+#include "grid_edit_listener.hpp"
+#include "node.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class NodeGrid;
+
+struct PathCacheStats {
+    uint64_t hits = 0;             // whole cached queries
+    uint64_t subpathHits = 0;      // part of a longer cached path
+    uint64_t misses = 0;
+    uint64_t evictions = 0;        // least recently used, to make room
+    uint64_t invalidations = 0;    // dropped because of an edit
+};
+
+// Bounded LRU cache of solved paths between cell-to-cell moves, keyed by
+// start and goal and valid for one map revision and one set of solver
+// settings; a lookup under any other drops everything cached.
+//
+// Optimal paths also answer queries between any two of their cells, as
+// every part of a shortest path is a shortest path too, so a miss looks
+// for a cached path through both cells before giving up.
+//
+// Edits move the cache to the new revision instead of flushing it. An
+// index from cells to the paths through them finds the paths a blocked
+// cell breaks, either by lying on them or by taking away a diagonal move
+// past it. An opened cell can only shorten paths whose cost is above the
+// octile distance through it (and, when it opens diagonals around it,
+// past it), so every other path stays. A terrain edit drops the paths
+// through a changed cell, whose cost may have gone up, and those a
+// cheaper cell may now beat, by the same test as an opened cell.
+class PathCache : public GridEditListener {
+public:
+    explicit PathCache(size_t capacity = 0);
+
+    // Largest number of paths kept, 0 to cache nothing
+    size_t capacity() const { return m_capacity; }
+    void setCapacity(size_t capacity);
+
+    // Path from goal back to start as solvePath stores it, with its cost
+    // and bound, if one is cached for the grid's current revision
+    bool lookup(const NodeGrid& grid, uint64_t settings, NodeId start, NodeId goal,
+                std::vector<NodeId>& path, Cost& cost, float& bound);
+
+    // Caches a path solved under settings, end to start, whose every step
+    // is a move to a neighbor cell
+    void insert(const NodeGrid& grid, uint64_t settings, NodeId start, NodeId goal,
+                const std::vector<NodeId>& path, Cost cost, float bound);
+
+    void clear();
+
+    size_t size() const { return m_index.size(); }
+    size_t memoryBytes() const;
+    const PathCacheStats& stats() const { return m_stats; }
+
+    void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onTerrainChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onMapReset(const NodeGrid& grid) override;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Entry {
+        NodeId start, goal;
+        std::vector<NodeId> path;      // goal first, start last
+        std::vector<Cost> costs;       // cost from the goal to each cell of path
+        Cost cost;
+        float bound;
+        uint32_t prev, next;           // recency list, most recent first
+    };
+
+    // Where a cell lies on a cached path
+    struct Posting {
+        uint32_t slot;
+        uint32_t position;
+    };
+
+    static uint64_t key(NodeId start, NodeId goal) { return (uint64_t(start) << 32) | goal; }
+
+    // Brings the cache to the grid's revision and the given settings
+    void validate(const NodeGrid& grid, uint64_t settings);
+
+    void unlink(uint32_t slot);
+    void pushFront(uint32_t slot);
+    void remove(uint32_t slot);
+
+    // Whether the step between two cells of a cached path is still a move
+    static bool isMove(const NodeGrid& grid, NodeId from, NodeId to);
+
+    // Adds the paths a detour through nid, within slack, may beat to stale
+    void findBeatable(const NodeGrid& grid, NodeId nid, Cost slack, std::vector<uint32_t>& stale) const;
+
+    // Drops the stale paths, each once
+    void removeStale(std::vector<uint32_t>& stale);
+
+    size_t m_capacity;
+    uint64_t m_settings;
+    uint32_t m_revision;
+
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_freeSlots;
+    uint32_t m_head, m_tail;
+
+    std::unordered_map<uint64_t, uint32_t> m_index;                    // by start and goal
+    std::unordered_map<NodeId, std::vector<Posting>> m_postings;       // by cell
+
+    PathCacheStats m_stats;
+};
+
+#endif /* A_STAR_PATH_CACHE_HPP */
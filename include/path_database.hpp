@@ -0,0 +1,109 @@
+#ifndef A_STAR_PATH_DATABASE_HPP
+#define A_STAR_PATH_DATABASE_HPP
+
+#include "grid_edit_listener.hpp"
+#include "node.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class NodeGrid;
+
+// Compressed path database (Botea; Strasser, Harabor & Botea): the first
+// move of an optimal path from every free cell to every other, so a path
+// is read off by one lookup per step instead of searched for.
+//
+// Targets are ranked along a Hilbert curve, which keeps nearby cells
+// together, and one Dijkstra per source finds the set of optimal first
+// moves to each of them. Consecutive targets that share a move collapse
+// into one run, cells with no path into whichever run is open, so each
+// source keeps only a short list of (first rank, move) runs packed into
+// 32 bits, and a lookup is a binary search in it.
+//
+// Building takes a Dijkstra per free cell, spread over a pool of threads,
+// so it is meant for maps that do not change: edits mark the database
+// stale. A database saved to a file is memory mapped by load, so a
+// program starting up pages in only the runs its queries touch.
+class PathDatabase : public GridEditListener {
+public:
+    static constexpr int NO_MOVE = -1;
+
+    PathDatabase();
+    ~PathDatabase();
+
+    PathDatabase(const PathDatabase&) = delete;
+    PathDatabase& operator=(const PathDatabase&) = delete;
+
+    // Runs one Dijkstra per free cell; numThreads = 0 uses one thread per
+    // hardware thread
+    void rebuild(const NodeGrid& grid, unsigned numThreads = 0);
+
+    // False once the map was edited, resized or its moves changed since
+    // the database was built or loaded
+    bool isCurrent(const NodeGrid& grid) const;
+
+    // Direction of the first move from one free cell towards another, or
+    // NO_MOVE if they are the same. Any move may come back for a goal that
+    // can not be reached.
+    int firstMove(NodeId from, NodeId goal) const;
+
+    // Optimal path from goal back to start, built by following first
+    // moves; false if there is none
+    bool extractPath(NodeId start, NodeId goal, std::vector<NodeId>& path, Cost& cost) const;
+
+    size_t runCount() const { return m_numRuns; }
+    size_t memoryBytes() const;
+    bool isMapped() const { return m_mapping != nullptr; }
+
+    // Binary file of the tables, tagged with the map they belong to and
+    // laid out to be used in place. load fails and leaves the database
+    // untouched if the file is for another map.
+    bool save(const char* path) const;
+    bool load(const NodeGrid& grid, const char* path);
+
+    void onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) override;
+    void onMapReset(const NodeGrid& grid) override;
+
+private:
+    static constexpr uint32_t MOVE_BITS = 3;
+    static constexpr uint32_t MOVE_MASK = (1u << MOVE_BITS) - 1;
+
+    // Fixed part of the file, followed by the run offsets, the ranks and
+    // the runs, each aligned to its element size
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t rows, columns;
+        uint32_t connectivity, cornerRule;
+        uint32_t reserved;
+        uint64_t fingerprint;
+        uint64_t numRuns;
+    };
+
+    // Rank of every cell along the Hilbert curve
+    static std::vector<uint32_t> rankCells(const NodeGrid& grid);
+
+    void unmap();
+
+    const NodeGrid* m_grid;
+    bool m_stale;
+    int m_rows, m_columns;
+    Connectivity m_connectivity;
+    CornerRule m_cornerRule;
+
+    // Views of the tables, held in the vectors below once built and in
+    // the mapped file once loaded
+    const uint64_t* m_runBegin;    // per source, one past the end for the last
+    const uint32_t* m_rank;        // per cell
+    const uint32_t* m_runs;        // rank << MOVE_BITS | move
+    size_t m_numRuns;
+
+    std::vector<uint64_t> m_ownRunBegin;
+    std::vector<uint32_t> m_ownRank;
+    std::vector<uint32_t> m_ownRuns;
+
+    void* m_mapping;
+    size_t m_mappingBytes;
+};
+
+#endif /* A_STAR_PATH_DATABASE_HPP */
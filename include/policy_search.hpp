@@ -0,0 +1,112 @@
+#ifndef A_STAR_POLICY_SEARCH_HPP
+#define A_STAR_POLICY_SEARCH_HPP
+
+#include "node_grid.hpp"
+#include "search_policies.hpp"
+#include "search_state.hpp"
+#include <algorithm>
+#include <deque>
+
+// A* over the cells of a NodeGrid with the move set fixed at compile time
+// by a Connectivity policy (FourConnected, EightConnected), a corner rule
+// (CornerCutting, NoSqueezing, NoCornerCutting) and a cost model
+// (FixedCost, FloatCost, TerrainCost). The heuristic and open list are
+// template arguments of solve, so each combination is its own loop
+// without indirect calls. Only the obstacles and terrain of the grid are
+// read: the grid's connectivity and corner rule settings do not apply
+// here, and only TerrainCost weighs moves by the terrain.
+//
+// A closed node that is reached more cheaply is reopened, so heuristics
+// that are admissible but not consistent (ALT) still give optimal paths.
+template <typename Connectivity, typename Corners, typename CostModel>
+class PolicySearch {
+public:
+    typedef typename CostModel::Value Value;
+    typedef BasicSearchState<Value> State;
+
+    PolicySearch(const NodeGrid& grid, State& state)
+        : m_grid(grid)
+        , m_state(state)
+        , m_terrain(grid.getTerrainData())
+    {
+        for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+            m_dirOffset[dir] = DIR_DY[dir] * grid.getColumns() + DIR_DX[dir];
+        }
+    }
+
+    // Search from start until goal is expanded; state must have been
+    // started with beginQuery(). Expanded nodes other than start are
+    // appended to trace if given. Returns false if goal is unreachable.
+    template <typename OpenList, typename Heuristic>
+    bool solve(NodeId start, NodeId goal, OpenList& openList, const Heuristic& heuristic,
+               SearchStats& stats, std::deque<TraceEntry>* trace = nullptr) {
+        const ObstacleBitmap& obstacles = m_grid.getObstacles();
+        openList.clear();
+
+        if (m_grid.isObstacle(start))
+            return false;
+
+        Value startH = heuristic(start);
+        m_state.open(start, 0, startH, INVALID_NODE);
+        openList.push(start, startH, startH);
+        ++stats.pushes;
+
+        while (!openList.empty()) {
+            NodeId current = openList.pop();
+            m_state.close(current);
+            ++stats.pops;
+
+            if (trace && current != start)
+                trace->push_back(TraceEntry{ current, m_state.parent(current), Frontier::FORWARD });
+
+            if (current == goal)
+                return true;
+
+            ++stats.expansions;
+            Value currentG = m_state.gRaw(current);
+
+            uint8_t blocked = obstacles.blockedNeighbors(m_grid.x(current), m_grid.y(current));
+            unsigned dirs = Connectivity::DIRECTIONS & ~blocked & Corners::allowed(blocked);
+
+            while (dirs) {
+                int dir = __builtin_ctz(dirs);
+                dirs &= dirs - 1;
+
+                NodeId adj = current + m_dirOffset[dir];
+                typename State::Status status = m_state.status(adj);
+                Value adjG = currentG + CostModel::step(dir, m_terrain, current, adj);
+
+                if (status == State::UNSEEN) {
+                    Value adjH = heuristic(adj);
+                    m_state.open(adj, adjG, adjH, current);
+                    openList.push(adj, adjG + adjH, adjH);
+                    ++stats.pushes;
+                }
+                else if (adjG < m_state.gRaw(adj)) {
+                    Value adjH = m_state.hRaw(adj);
+                    if (status == State::CLOSED) {
+                        m_state.open(adj, adjG, adjH, current);
+                        openList.push(adj, adjG + adjH, adjH);
+                        ++stats.pushes;
+                    }
+                    else {
+                        m_state.relax(adj, adjG, current);
+                        openList.decreaseKey(adj, adjG + adjH);
+                        ++stats.decreaseKeys;
+                    }
+                }
+            }
+
+            stats.maxOpenSize = std::max(stats.maxOpenSize, openList.size());
+        }
+        return false;
+    }
+
+private:
+    const NodeGrid& m_grid;
+    State& m_state;
+    const uint8_t* m_terrain;
+    int m_dirOffset[NUM_DIRECTIONS];
+};
+
+#endif /* A_STAR_POLICY_SEARCH_HPP */
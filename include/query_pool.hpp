@@ -0,0 +1,66 @@
+#ifndef A_STAR_QUERY_POOL_HPP
+#define A_STAR_QUERY_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool of persistent threads for batches of independent
+// tasks. The calling thread is worker 0 and takes part in every batch.
+//
+// A batch of count tasks is split into one contiguous range per worker.
+// Workers take tasks one at a time from the front of their own range;
+// one that runs dry steals the back half of the fullest range left. Each
+// range is a single atomic (begin, end) pair on its own cache line, so
+// owners and thieves agree through one compare-and-swap and never take
+// a lock. The mutex only wakes the workers and waits for them per batch.
+class QueryPool {
+public:
+    // numThreads = 0 uses one thread per hardware thread
+    explicit QueryPool(unsigned numThreads = 0);
+    ~QueryPool();
+
+    QueryPool(const QueryPool&) = delete;
+    QueryPool& operator=(const QueryPool&) = delete;
+
+    unsigned threadCount() const { return m_numThreads; }
+
+    // Calls task(worker, index) once for every index in [0, count) and
+    // returns when all calls have. worker is in [0, threadCount()) and
+    // unique among the calls running at the same time, so it can pick
+    // per-thread scratch. Returns the number of steals.
+    uint64_t run(size_t count, const std::function<void(unsigned, size_t)>& task);
+
+private:
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bounds;    // begin << 32 | end
+    };
+
+    static uint64_t pack(uint64_t begin, uint64_t end) { return (begin << 32) | end; }
+
+    bool takeOwn(unsigned worker, size_t& index);
+    bool steal(unsigned worker);
+    void work(unsigned worker);
+    void workerLoop(unsigned worker);
+
+    unsigned m_numThreads;
+    std::unique_ptr<Range[]> m_ranges;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_done;
+    uint64_t m_batch;
+    unsigned m_running;
+    bool m_stop;
+
+    const std::function<void(unsigned, size_t)>* m_task;
+    std::atomic<uint64_t> m_steals;
+};
+
+#endif /* A_STAR_QUERY_POOL_HPP */
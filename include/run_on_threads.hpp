@@ -0,0 +1,22 @@
+#ifndef A_STAR_RUN_ON_THREADS_HPP
+#define A_STAR_RUN_ON_THREADS_HPP
+
+#include <thread>
+#include <vector>
+
+// Calls fn(t) for every t in [0, numThreads), each on a thread of its own
+// but t = 0, which runs on the calling thread, and returns when all have.
+// For one-off parallel builds; batches of queries go to a QueryPool.
+template <typename Fn>
+void runOnThreads(unsigned numThreads, Fn&& fn) {
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < numThreads; ++t) {
+        threads.emplace_back(fn, t);
+    }
+    fn(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+#endif /* A_STAR_RUN_ON_THREADS_HPP */
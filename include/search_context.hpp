@@ -0,0 +1,91 @@
+#ifndef A_STAR_SEARCH_CONTEXT_HPP
+#define A_STAR_SEARCH_CONTEXT_HPP
+
+#include "bucket_queue.hpp"
+#include "indexed_heap.hpp"
+#include "search_state.hpp"
+#include <cmath>
+#include <deque>
+#include <vector>
+
+// Everything a query writes: the per-cell search arrays, the open lists
+// and the results. The grid itself is only read while solving into a
+// context (NodeGrid::solve), so threads may solve concurrently against
+// one map as long as each has a context of its own. A context is meant
+// to be reused: its arrays are sized on first use and every later query
+// on a grid of the same size starts in O(1).
+struct SearchContext {
+    SearchState       search;
+    IndexedHeap<Cost> heapOpenList;
+    BucketQueue       bucketOpenList;
+    SearchState       reverseSearch;      // backward half of the bidirectional search
+    IndexedHeap<Cost> reverseOpenList;
+
+    // Results of the last query
+    std::vector<NodeId>    path;          // end to start, empty if none was found
+    std::deque<TraceEntry> visited;
+    SearchStats            stats;
+    Cost                   pathCost  = COST_INFINITY;
+    float                  pathBound = INFINITY;
+
+    // Off to skip the visited trace, which only the GUI animates
+    bool recordTrace = true;
+
+    // Sizes the arrays a solver needs for numNodes cells: the search
+    // state always, the open lists and the backward half on request
+    void allocate(size_t numNodes, bool openLists, bool bidirectional) {
+        if (search.size() != numNodes)
+            search.resize(numNodes);
+        if (openLists && heapOpenList.capacity() != numNodes) {
+            heapOpenList.resize(numNodes);
+            bucketOpenList.resize(numNodes);
+        }
+        if (bidirectional && reverseSearch.size() != numNodes) {
+            reverseSearch.resize(numNodes);
+            reverseOpenList.resize(numNodes);
+        }
+    }
+
+    // Drops the results and invalidates the search state in O(1)
+    void reset() {
+        path.clear();
+        visited.clear();
+        stats = SearchStats();
+        pathCost = COST_INFINITY;
+        pathBound = INFINITY;
+        search.beginQuery();
+        reverseSearch.beginQuery();
+    }
+};
+
+// One query of a batch (NodeGrid::solveBatch) and its results. The path
+// goes, end to start like getShortestPath, into the caller's buffer; a
+// longer one is cut off at capacity, but length and cost are still those
+// of the whole path.
+struct BatchQuery {
+    NodeId start;
+    NodeId goal;
+    NodeId* path;             // may be null with capacity 0
+    uint32_t capacity;
+
+    uint32_t length;          // 0 if no path was found
+    Cost cost;                // COST_INFINITY if no path was found
+    float latencyUs;          // time from taking the query to its result
+};
+
+// Counters of one batch
+struct BatchStats {
+    size_t queries = 0;
+    size_t solved = 0;
+    unsigned threads = 0;
+    double wallMs = 0.0;
+    double queriesPerSecond = 0.0;
+    double meanLatencyUs = 0.0;
+    double p50LatencyUs = 0.0;
+    double p99LatencyUs = 0.0;
+    double maxLatencyUs = 0.0;
+    uint64_t expansions = 0;
+    uint64_t steals = 0;
+};
+
+#endif /* A_STAR_SEARCH_CONTEXT_HPP */
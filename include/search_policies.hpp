@@ -0,0 +1,176 @@
+#ifndef A_STAR_SEARCH_POLICIES_HPP
+#define A_STAR_SEARCH_POLICIES_HPP
+
+#include "node.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+// Compile-time policies for PolicySearch (policy_search.hpp). Each policy is
+// a stateless type with static members, so every combination compiles to
+// its own search loop with the move set, step costs and heuristic inlined.
+
+// Connectivity: which Direction bits may be expanded at all
+struct FourConnected {
+    static constexpr uint8_t DIRECTIONS = 0x0F;
+};
+
+struct EightConnected {
+    static constexpr uint8_t DIRECTIONS = 0xFF;
+};
+
+// Corner rules: the Direction bits still allowed given the blocked bits of
+// the 3x3 block around a node. Diagonal 4 + k lies between the straight
+// directions k and (k + 1) % 4, so rotating the straight bits by one lines
+// up the second straight neighbor of every diagonal.
+inline uint8_t secondStraightBlocked(uint8_t blocked) {
+    unsigned straight = blocked & 0x0F;
+    return static_cast<uint8_t>(((straight >> 1) | (straight << 3)) & 0x0F);
+}
+
+struct CornerCutting {
+    static constexpr CornerRule RULE = CornerRule::CUT_CORNERS;
+    static uint8_t allowed(uint8_t) { return 0xFF; }
+};
+
+struct NoSqueezing {
+    static constexpr CornerRule RULE = CornerRule::NO_SQUEEZE;
+    static uint8_t allowed(uint8_t blocked) {
+        return static_cast<uint8_t>(~(((blocked & 0x0F) & secondStraightBlocked(blocked)) << 4));
+    }
+};
+
+struct NoCornerCutting {
+    static constexpr CornerRule RULE = CornerRule::NO_CUTTING;
+    static uint8_t allowed(uint8_t blocked) {
+        return static_cast<uint8_t>(~(((blocked & 0x0F) | secondStraightBlocked(blocked)) << 4));
+    }
+};
+
+// Cost models: the value type of g, h and f and the cost of one step.
+// step() is handed the grid's terrain layer, null on plain maps, which
+// only TerrainCost reads.
+struct FixedCost {
+    typedef Cost Value;
+    static constexpr Value STRAIGHT = COST_STRAIGHT;
+    static constexpr Value DIAGONAL = COST_DIAGONAL;
+    static constexpr Value STEP[NUM_DIRECTIONS] = {
+        STRAIGHT, STRAIGHT, STRAIGHT, STRAIGHT, DIAGONAL, DIAGONAL, DIAGONAL, DIAGONAL,
+    };
+    static Value step(int dir, const uint8_t*, NodeId, NodeId) { return STEP[dir]; }
+
+    // Euclidean distance scaled so that a diagonal run never estimates more
+    // than the rounded-down COST_DIAGONAL steps it takes
+    static Value euclidean(unsigned dx, unsigned dy) {
+        static constexpr double SCALE = COST_DIAGONAL / 1.4142135623730951;
+        return static_cast<Value>(SCALE * std::sqrt(static_cast<double>(dx * dx + dy * dy)));
+    }
+    static float toFloat(Value value) { return costToFloat(value); }
+};
+
+struct FloatCost {
+    typedef float Value;
+    static constexpr Value STRAIGHT = 1.0f;
+    static constexpr Value DIAGONAL = 1.41421356f;
+    static constexpr Value STEP[NUM_DIRECTIONS] = {
+        STRAIGHT, STRAIGHT, STRAIGHT, STRAIGHT, DIAGONAL, DIAGONAL, DIAGONAL, DIAGONAL,
+    };
+
+    static Value step(int dir, const uint8_t*, NodeId, NodeId) { return STEP[dir]; }
+
+    static Value euclidean(unsigned dx, unsigned dy) {
+        return std::sqrt(static_cast<float>(dx * dx + dy * dy));
+    }
+    static float toFloat(Value value) { return value; }
+};
+
+// FixedCost weighed by the terrain multipliers of both cells of a move,
+// as NodeGrid::stepCost: one multiply-add per move, no division
+struct TerrainCost : FixedCost {
+    static Value step(int dir, const uint8_t* terrain, NodeId from, NodeId to) {
+        return HALF_DIR_COST[dir] * (Value(terrain[from]) + terrain[to]);
+    }
+};
+
+// Distance estimates over the absolute coordinate deltas. Only the
+// Euclidean one takes a square root, once per generated node since A*
+// caches h; the others are a few integer or float operations.
+struct ZeroDistance {
+    template <typename CostModel>
+    static typename CostModel::Value estimate(unsigned, unsigned) { return 0; }
+};
+
+struct ManhattanDistance {
+    template <typename CostModel>
+    static typename CostModel::Value estimate(unsigned dx, unsigned dy) {
+        return CostModel::STRAIGHT * static_cast<typename CostModel::Value>(dx + dy);
+    }
+};
+
+struct OctileDistance {
+    template <typename CostModel>
+    static typename CostModel::Value estimate(unsigned dx, unsigned dy) {
+        typedef typename CostModel::Value Value;
+        unsigned lo = (dx < dy) ? dx : dy;
+        unsigned hi = (dx < dy) ? dy : dx;
+        return CostModel::STRAIGHT * static_cast<Value>(hi) +
+               (CostModel::DIAGONAL - CostModel::STRAIGHT) * static_cast<Value>(lo);
+    }
+};
+
+struct EuclideanDistance {
+    template <typename CostModel>
+    static typename CostModel::Value estimate(unsigned dx, unsigned dy) {
+        return CostModel::euclidean(dx, dy);
+    }
+};
+
+// A distance policy bound to one goal cell of a grid with the given width,
+// times scale: the smallest terrain multiplier keeps it admissible
+template <typename Distance, typename CostModel>
+class GoalDistance {
+public:
+    typedef typename CostModel::Value Value;
+
+    GoalDistance(int columns, NodeId goal, Value scale = 1)
+        : m_columns(static_cast<NodeId>(columns))
+        , m_goalX(static_cast<int>(goal % m_columns))
+        , m_goalY(static_cast<int>(goal / m_columns))
+        , m_scale(scale)
+    {
+    }
+
+    Value operator()(NodeId nid) const {
+        unsigned dx = static_cast<unsigned>(std::abs(static_cast<int>(nid % m_columns) - m_goalX));
+        unsigned dy = static_cast<unsigned>(std::abs(static_cast<int>(nid / m_columns) - m_goalY));
+        return Distance::template estimate<CostModel>(dx, dy) * m_scale;
+    }
+
+private:
+    NodeId m_columns;
+    int m_goalX, m_goalY;
+    Value m_scale;
+};
+
+// A fixed-point heuristic inflated by weight / WEIGHT_ONE, for weighted A*
+template <typename Heuristic>
+class WeightedHeuristic {
+public:
+    static constexpr Cost WEIGHT_ONE = 1000;
+
+    WeightedHeuristic(const Heuristic& heuristic, Cost weight)
+        : m_heuristic(heuristic)
+        , m_weight(weight)
+    {
+    }
+
+    Cost operator()(NodeId nid) const {
+        return static_cast<Cost>(uint64_t(m_heuristic(nid)) * m_weight / WEIGHT_ONE);
+    }
+
+private:
+    const Heuristic& m_heuristic;
+    Cost m_weight;
+};
+
+#endif /* A_STAR_SEARCH_POLICIES_HPP */
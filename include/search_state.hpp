@@ -0,0 +1,108 @@
+#ifndef A_STAR_SEARCH_STATE_HPP
+#define A_STAR_SEARCH_STATE_HPP
+
+#include "node.hpp"
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Which search tree an expanded node belongs to
+enum class Frontier : uint8_t {
+    FORWARD,     // grown from the start node
+    BACKWARD,    // grown from the end node
+};
+
+// One expanded node of the visited trace, with the parent it was
+// expanded from at the time
+struct TraceEntry {
+    NodeId nid;
+    NodeId parent;
+    Frontier frontier;
+};
+
+// Work counters of the last query
+struct SearchStats {
+    uint64_t expansions   = 0;
+    uint64_t pushes       = 0;
+    uint64_t pops         = 0;
+    uint64_t decreaseKeys = 0;
+    size_t   maxOpenSize  = 0;
+};
+
+// Per-query search state (g, h, parent, open/closed) for every node.
+//
+// Each entry carries a stamp holding the generation of the query that last
+// wrote it plus its open/closed status. Entries from older queries read as
+// unseen, so starting a new query is O(1) regardless of the grid size.
+//
+// CostT is the fixed-point Cost of the solvers or float for the policy
+// search (policy_search.hpp); both are instantiated in search_state.cpp.
+template <typename CostT>
+class BasicSearchState {
+public:
+    enum Status : uint8_t {
+        UNSEEN = 0,
+        OPEN   = 1,
+        CLOSED = 2,
+    };
+
+    static constexpr CostT INFINITE_COST = std::numeric_limits<CostT>::has_infinity
+                                         ? std::numeric_limits<CostT>::infinity()
+                                         : std::numeric_limits<CostT>::max();
+
+    explicit BasicSearchState(size_t numNodes = 0);
+
+    void resize(size_t numNodes);
+    size_t size() const { return m_stamp.size(); }
+    void beginQuery();
+
+    uint32_t generation() const { return m_generation; }
+
+    bool isTouched(NodeId nid) const { return (m_stamp[nid] >> STATUS_BITS) == m_generation; }
+
+    Status status(NodeId nid) const {
+        return isTouched(nid) ? static_cast<Status>(m_stamp[nid] & STATUS_MASK) : UNSEEN;
+    }
+    bool isOpen(NodeId nid)   const { return status(nid) == OPEN;   }
+    bool isClosed(NodeId nid) const { return status(nid) == CLOSED; }
+
+    CostT g(NodeId nid)      const { return isTouched(nid) ? m_g[nid] : INFINITE_COST; }
+    CostT h(NodeId nid)      const { return isTouched(nid) ? m_h[nid] : INFINITE_COST; }
+    NodeId parent(NodeId nid) const { return isTouched(nid) ? m_parent[nid] : INVALID_NODE; }
+
+    // Unchecked reads for nodes already known to be touched by this query
+    CostT gRaw(NodeId nid) const { return m_g[nid]; }
+    CostT hRaw(NodeId nid) const { return m_h[nid]; }
+
+    void open(NodeId nid, CostT g, CostT h, NodeId parent) {
+        m_stamp[nid]  = (m_generation << STATUS_BITS) | OPEN;
+        m_g[nid]      = g;
+        m_h[nid]      = h;
+        m_parent[nid] = parent;
+    }
+
+    // Better path to an open node; h and status stay as they are
+    void relax(NodeId nid, CostT g, NodeId parent) {
+        m_g[nid]      = g;
+        m_parent[nid] = parent;
+    }
+
+    void close(NodeId nid) {
+        m_stamp[nid] = (m_generation << STATUS_BITS) | CLOSED;
+    }
+
+private:
+    static constexpr uint32_t STATUS_BITS = 2;
+    static constexpr uint32_t STATUS_MASK = (1u << STATUS_BITS) - 1;
+    static constexpr uint32_t MAX_GENERATION = UINT32_MAX >> STATUS_BITS;
+
+    uint32_t m_generation;
+
+    std::vector<uint32_t> m_stamp;
+    std::vector<CostT>    m_g, m_h;
+    std::vector<NodeId>   m_parent;
+};
+
+typedef BasicSearchState<Cost> SearchState;
+
+#endif /* A_STAR_SEARCH_STATE_HPP */
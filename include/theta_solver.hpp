@@ -0,0 +1,55 @@
+#ifndef A_STAR_THETA_SOLVER_HPP
+#define A_STAR_THETA_SOLVER_HPP
+
+#include "indexed_heap.hpp"
+#include "search_state.hpp"
+#include <deque>
+#include <vector>
+
+class NodeGrid;
+
+// Any-angle search over cell centers (Theta*, Nash, Daniel, Koenig &
+// Felner). It expands the grid like A*, but a neighbor may take the
+// parent of the expanded node as its own parent whenever the two are in
+// line of sight, so parents are path waypoints and the path runs in
+// straight segments between them instead of 45 degree steps. Costs are
+// Euclidean segment lengths, estimated by the Euclidean distance.
+//
+// The lazy variant (Lazy Theta*) assumes sight when a neighbor is
+// generated and checks it once, when the node is expanded, falling back
+// to its cheapest expanded neighbor if the check fails. Most generated
+// nodes are never expanded, so it runs far fewer sight checks.
+class ThetaSolver {
+public:
+    ThetaSolver(const NodeGrid& grid, SearchState& state, IndexedHeap<Cost>& openList, bool lazy);
+
+    // Searches from start to goal and appends every expanded node to
+    // trace. Returns false if goal is unreachable.
+    bool solve(NodeId start, NodeId goal, SearchStats& stats, std::deque<TraceEntry>& trace);
+
+    // Waypoints of the path found, ordered from goal to start
+    void buildPath(std::vector<NodeId>& path) const;
+
+    uint64_t sightChecks() const { return m_sightChecks; }
+
+    // Length of the straight segment between two cell centers
+    static Cost segmentCost(const NodeGrid& grid, NodeId from, NodeId to);
+
+private:
+    // Offers nid the path through parent at cost g
+    void relax(NodeId nid, NodeId parent, Cost g, SearchStats& stats);
+
+    // Lazy Theta*: confirms the assumed sight to the parent of a node
+    // about to be expanded, or reattaches it to its best expanded neighbor
+    void confirmParent(NodeId nid);
+
+    const NodeGrid& m_grid;
+    SearchState& m_state;
+    IndexedHeap<Cost>& m_openList;
+    bool m_lazy;
+
+    NodeId m_goal;
+    uint64_t m_sightChecks;
+};
+
+#endif /* A_STAR_THETA_SOLVER_HPP */
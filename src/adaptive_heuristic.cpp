@@ -0,0 +1,85 @@
+#include "adaptive_heuristic.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+AdaptiveHeuristic::AdaptiveHeuristic()
+    : m_grid(nullptr)
+    , m_goal(INVALID_NODE)
+    , m_connectivity(Connectivity::EIGHT)
+    , m_cornerRule(CornerRule::CUT_CORNERS)
+    , m_generation(1)
+    , m_learned(0)
+{
+}
+
+void AdaptiveHeuristic::invalidate() {
+    if (m_generation == UINT32_MAX) {
+        m_generation = 0;
+        std::fill(m_stamp.begin(), m_stamp.end(), 0);
+    }
+    ++m_generation;
+    m_learned = 0;
+}
+
+void AdaptiveHeuristic::setGoal(const NodeGrid& grid, NodeId goal) {
+    size_t numNodes = grid.getTotalNodes();
+
+    if (m_grid != &grid || m_stamp.size() != numNodes) {
+        m_grid = &grid;
+        m_stamp.assign(numNodes, 0);
+        m_h.resize(numNodes);
+        invalidate();
+    }
+    if (goal != m_goal || grid.getConnectivity() != m_connectivity ||
+        grid.getCornerRule() != m_cornerRule) {
+        invalidate();
+    }
+
+    m_goal = goal;
+    m_connectivity = grid.getConnectivity();
+    m_cornerRule = grid.getCornerRule();
+}
+
+Cost AdaptiveHeuristic::operator()(NodeId nid) const {
+    return (m_stamp[nid] == m_generation) ? m_h[nid] : m_grid->heuristicCost(nid, m_goal);
+}
+
+void AdaptiveHeuristic::learn(const SearchState& state, NodeId start,
+                              const std::deque<TraceEntry>& trace) {
+    if (!state.isClosed(m_goal))
+        return;
+
+    Cost goalCost = state.gRaw(m_goal);
+
+    // Both the old and the new value are lower bounds, keep the larger
+    auto raise = [&](NodeId nid) {
+        Cost learned = goalCost - state.gRaw(nid);
+        if (m_stamp[nid] != m_generation) {
+            m_stamp[nid] = m_generation;
+            m_h[nid] = learned;
+            ++m_learned;
+        }
+        else {
+            m_h[nid] = std::max(m_h[nid], learned);
+        }
+    };
+
+    raise(start);
+    for (const TraceEntry& entry : trace) {
+        raise(entry.nid);
+    }
+}
+
+void AdaptiveHeuristic::onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    // Only freed cells can shorten a distance
+    for (NodeId nid : cells) {
+        if (!grid.isObstacle(nid)) {
+            invalidate();
+            return;
+        }
+    }
+}
+
+void AdaptiveHeuristic::onMapReset(const NodeGrid&) {
+    invalidate();
+}
@@ -0,0 +1,174 @@
+#include "ara_solver.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+#include <cmath>
+
+static uint32_t toThousandths(float value) {
+    return static_cast<uint32_t>(std::lround(value * 1000.0f));
+}
+
+AraSolver::AraSolver(const NodeGrid& grid, SearchState& state, IndexedHeap<Cost>& openList,
+                     float epsilonStep)
+    : m_grid(grid)
+    , m_state(state)
+    , m_openList(openList)
+    , m_start(INVALID_NODE)
+    , m_goal(INVALID_NODE)
+    , m_epsilon(1000)
+    , m_epsilonStep(std::max<uint32_t>(1, toThousandths(epsilonStep)))
+    , m_resume(false)
+    , m_pass(0)
+{
+}
+
+Cost AraSolver::key(NodeId nid) const {
+    uint64_t f = m_state.gRaw(nid) + uint64_t(m_state.hRaw(nid)) * m_epsilon / 1000;
+    return static_cast<Cost>(std::min<uint64_t>(f, COST_INFINITY - 1));
+}
+
+bool AraSolver::solve(NodeId start, NodeId goal, float epsilon, SearchStats& stats,
+                      std::deque<TraceEntry>& trace) {
+    m_startTime = Clock::now();
+    m_start = start;
+    m_goal = goal;
+    m_epsilon = std::max<uint32_t>(1000, toThousandths(epsilon));
+    if (m_closed.size() != static_cast<size_t>(m_grid.getTotalNodes()) || m_pass >= MAX_PASS) {
+        m_closed.assign(m_grid.getTotalNodes(), 0);
+        m_pass = 0;
+    }
+    ++m_pass;
+    m_resume = false;
+    m_incons.clear();
+    m_solutions.clear();
+
+    m_openList.clear();
+    if (m_grid.isObstacle(start))
+        return false;
+
+    m_state.open(start, 0, m_grid.heuristicCost(start, goal), INVALID_NODE);
+    m_openList.push(start, key(start), m_state.hRaw(start));
+    ++stats.pushes;
+
+    // The first path is wanted however long it takes
+    improvePath(Clock::time_point::max(), stats, trace);
+    if (!m_state.isTouched(goal))
+        return false;
+
+    publish(stats);
+    return true;
+}
+
+bool AraSolver::improve(Clock::time_point deadline, SearchStats& stats,
+                        std::deque<TraceEntry>& trace) {
+    if (m_solutions.empty() || isOptimal() || Clock::now() > deadline)
+        return false;
+
+    if (!m_resume) {
+        // Next pass: every node counts as unexpanded again, the
+        // inconsistent ones rejoin the open list and all keys follow
+        // the lower epsilon
+        m_epsilon = std::max<uint32_t>(1000, m_epsilon - std::min(m_epsilon, m_epsilonStep));
+        ++m_pass;
+
+        for (NodeId nid : m_incons) {
+            m_openList.push(nid, key(nid), m_state.hRaw(nid));
+            ++stats.pushes;
+        }
+        m_incons.clear();
+        m_openList.rekey([this](NodeId nid) { return key(nid); });
+    }
+
+    m_resume = !improvePath(deadline, stats, trace);
+    if (m_resume)
+        return false;
+
+    publish(stats);
+    return true;
+}
+
+bool AraSolver::improvePath(Clock::time_point deadline, SearchStats& stats,
+                            std::deque<TraceEntry>& trace) {
+    static constexpr uint64_t CLOCK_INTERVAL = 256;
+
+    while (!m_openList.empty() && m_openList.topKey() < m_state.g(m_goal)) {
+        if (stats.expansions % CLOCK_INTERVAL == 0 && Clock::now() > deadline)
+            return false;
+
+        NodeId current = m_openList.pop();
+        m_state.close(current);
+        m_closed[current] = m_pass << 1;
+        ++stats.pops;
+        ++stats.expansions;
+
+        if (current != m_start)
+            trace.push_back(TraceEntry{ current, m_state.parent(current), Frontier::FORWARD });
+
+        Cost currentG = m_state.gRaw(current);
+
+        m_grid.forEachNeighbor(current, [&](NodeId adj, Direction dir) {
+            Cost adjG = currentG + m_grid.stepCost(current, adj, dir);
+
+            if (!m_state.isTouched(adj)) {
+                m_state.open(adj, adjG, m_grid.heuristicCost(adj, m_goal), current);
+                m_openList.push(adj, key(adj), m_state.hRaw(adj));
+                ++stats.pushes;
+                return;
+            }
+            if (adjG >= m_state.gRaw(adj))
+                return;
+
+            m_state.relax(adj, adjG, current);
+
+            if (isClosed(adj)) {
+                // Already expanded in this pass: repaired by the next one
+                if (!(m_closed[adj] & 1)) {
+                    m_closed[adj] |= 1;
+                    m_incons.push_back(adj);
+                }
+            }
+            else if (m_openList.contains(adj)) {
+                m_openList.decreaseKey(adj, key(adj));
+                ++stats.decreaseKeys;
+            }
+            else {
+                // Expanded in an earlier pass only
+                m_openList.push(adj, key(adj), m_state.hRaw(adj));
+                ++stats.pushes;
+            }
+        });
+
+        stats.maxOpenSize = std::max(stats.maxOpenSize, m_openList.size());
+    }
+    return true;
+}
+
+void AraSolver::publish(const SearchStats& stats) {
+    AnytimeSolution solution;
+
+    // Cost of the parent chain itself; it can undercut g(goal) when an
+    // ancestor improved after the goal was last relaxed
+    solution.cost = 0;
+    for (NodeId nid = m_goal; nid != INVALID_NODE; nid = m_state.parent(nid)) {
+        NodeId parent = m_state.parent(nid);
+        solution.path.push_back(nid);
+        if (parent != INVALID_NODE)
+            solution.cost += m_grid.stepCost(parent, nid);
+    }
+
+    // Unless the path is optimal, some node on an optimal path is still
+    // queued or inconsistent with its optimal g, so the least g + h among
+    // them is a lower bound on the optimal cost
+    Cost lower = COST_INFINITY;
+    auto lowerBound = [&](NodeId nid) {
+        lower = std::min(lower, m_state.gRaw(nid) + m_state.hRaw(nid));
+    };
+    m_openList.forEach(lowerBound);
+    std::for_each(m_incons.begin(), m_incons.end(), lowerBound);
+
+    float bound = std::min(epsilon(), static_cast<float>(solution.cost) / lower);
+    solution.bound = (lower >= solution.cost) ? 1.0f : std::max(1.0f, bound);
+
+    solution.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - m_startTime).count();
+    solution.expansions = stats.expansions;
+    m_solutions.push_back(std::move(solution));
+}
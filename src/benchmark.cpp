@@ -0,0 +1,1517 @@
+#include "benchmark.hpp"
+#include "bit_bfs.hpp"
+#include "node_grid.hpp"
+#include "policy_search.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <malloc.h>
+#include <queue>
+#include <random>
+#include <thread>
+#include <utility>
+
+static constexpr double BENCH_DENSITY = 0.25;
+static constexpr double BENCH_OPEN_DENSITY = 0.02;
+static constexpr int BENCH_QUERIES = 20;
+static constexpr int BENCH_POLICY_QUERIES = 5;    // zero heuristic rows are full Dijkstra
+static constexpr int BENCH_CPD_SIZE = 96;         // a Dijkstra per cell to preprocess
+static constexpr int BENCH_BFS_SIZE = 4096;       // 16M cells
+
+typedef std::vector<std::pair<NodeId, NodeId>> QueryList;
+
+template <typename Fn>
+static double timeMs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+static void fillRandomObstacles(NodeGrid& grid, double density, unsigned seed) {
+    std::mt19937 generator(seed);
+    std::bernoulli_distribution distribution(density);
+
+    grid.beginEdit();
+    for (NodeId nid = 0; nid < static_cast<NodeId>(grid.getTotalNodes()); ++nid) {
+        grid.setObstacle(nid, distribution(generator));
+    }
+    grid.commitEdit();
+}
+
+// Perfect maze carved by an iterative depth-first search over the odd
+// cells, so every pair of free cells is joined by exactly one corridor
+static void fillMaze(NodeGrid& grid, unsigned seed) {
+    std::mt19937 generator(seed);
+    int cols = grid.getColumns();
+    int rows = grid.getRows();
+
+    grid.beginEdit();
+    grid.setObstacleRect(0, 0, cols, rows, true);
+    grid.setObstacle(grid.nodeAt(1, 1), false);
+
+    std::vector<NodeId> stack = { grid.nodeAt(1, 1) };
+    while (!stack.empty()) {
+        int x = grid.x(stack.back());
+        int y = grid.y(stack.back());
+
+        int candidates[4];
+        int numCandidates = 0;
+        for (int dir = 0; dir < 4; ++dir) {
+            int nx = x + 2 * DIR_DX[dir];
+            int ny = y + 2 * DIR_DY[dir];
+            if (nx > 0 && nx < cols - 1 && ny > 0 && ny < rows - 1 &&
+                grid.isObstacle(grid.nodeAt(nx, ny)))
+                candidates[numCandidates++] = dir;
+        }
+
+        if (numCandidates == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        int dir = candidates[std::uniform_int_distribution<int>(0, numCandidates - 1)(generator)];
+        grid.setObstacle(grid.nodeAt(x + DIR_DX[dir], y + DIR_DY[dir]), false);
+        grid.setObstacle(grid.nodeAt(x + 2 * DIR_DX[dir], y + 2 * DIR_DY[dir]), false);
+        stack.push_back(grid.nodeAt(x + 2 * DIR_DX[dir], y + 2 * DIR_DY[dir]));
+    }
+    grid.commitEdit();
+}
+
+// Random pairs of free cells, far apart so every query does real work
+static QueryList makeQueries(const NodeGrid& grid, int count, unsigned seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<NodeId> pick(0, grid.getTotalNodes() - 1);
+    int minDist = (grid.getRows() + grid.getColumns()) / 4;
+    QueryList queries;
+
+    while (static_cast<int>(queries.size()) < count) {
+        NodeId start = pick(generator);
+        NodeId goal  = pick(generator);
+        int dist = std::abs(grid.x(start) - grid.x(goal)) + std::abs(grid.y(start) - grid.y(goal));
+
+        if (!grid.isObstacle(start) && !grid.isObstacle(goal) && dist >= minDist)
+            queries.emplace_back(start, goal);
+    }
+    return queries;
+}
+
+// The pre-indexed-heap open list: std::priority_queue with lazy deletion,
+// where an improved node is pushed again and stale copies are skipped.
+static SearchStats solveWithPriorityQueue(const NodeGrid& grid, NodeId start, NodeId goal) {
+    SearchStats stats;
+    std::vector<Cost> g(grid.getTotalNodes(), COST_INFINITY);
+    std::vector<bool> closed(grid.getTotalNodes(), false);
+
+    auto heuristic = [&](NodeId nid) {
+        return grid.heuristicCost(nid, goal);
+    };
+
+    typedef std::pair<Cost, NodeId> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pQueue;
+
+    g[start] = 0.0;
+    pQueue.emplace(heuristic(start), start);
+    ++stats.pushes;
+
+    while (!pQueue.empty()) {
+        NodeId current = pQueue.top().second;
+        pQueue.pop();
+        ++stats.pops;
+
+        if (closed[current])
+            continue;
+        closed[current] = true;
+
+        if (current == goal)
+            break;
+        ++stats.expansions;
+
+        grid.forEachNeighbor(current, [&](NodeId adj, Direction dir) {
+            Cost adjG = g[current] + DIR_COST[dir];
+            if (!closed[adj] && adjG < g[adj]) {
+                g[adj] = adjG;
+                pQueue.emplace(adjG + heuristic(adj), adj);
+                ++stats.pushes;
+            }
+        });
+        stats.maxOpenSize = std::max(stats.maxOpenSize, pQueue.size());
+    }
+    return stats;
+}
+
+static void printStatsRow(const char* name, double ms, const SearchStats& stats) {
+    double expansions = std::max<double>(1.0, static_cast<double>(stats.expansions));
+    double heapOps = static_cast<double>(stats.pushes + stats.pops + stats.decreaseKeys);
+
+    printf("  %-22s %10.2f ms %12llu exp %8.2f heap ops/exp %10zu max open\n",
+           name, ms, static_cast<unsigned long long>(stats.expansions),
+           heapOps / expansions, stats.maxOpenSize);
+}
+
+static void accumulate(SearchStats& total, const SearchStats& stats) {
+    total.expansions   += stats.expansions;
+    total.pushes       += stats.pushes;
+    total.pops         += stats.pops;
+    total.decreaseKeys += stats.decreaseKeys;
+    total.maxOpenSize   = std::max(total.maxOpenSize, stats.maxOpenSize);
+}
+
+// Runs every query through grid.solvePath with its current settings
+static double timeSolvePath(NodeGrid& grid, const QueryList& queries, SearchStats& total) {
+    return timeMs([&] {
+        for (auto& query : queries) {
+            grid.setStartNode(query.first);
+            grid.setEndNode(query.second);
+            grid.solvePath();
+            accumulate(total, grid.getSearchStats());
+        }
+    });
+}
+
+static void benchOpenLists(NodeGrid& grid, const QueryList& queries) {
+    printf("Open list: std::priority_queue vs indexed 4-ary heap vs bucket queue\n");
+
+    SearchStats queueTotal, heapTotal, bucketTotal;
+
+    double queueMs = timeMs([&] {
+        for (auto& query : queries) {
+            accumulate(queueTotal, solveWithPriorityQueue(grid, query.first, query.second));
+        }
+    });
+
+    grid.setOpenListType(OpenListType::HEAP);
+    double heapMs = timeSolvePath(grid, queries, heapTotal);
+
+    grid.setOpenListType(OpenListType::BUCKET);
+    double bucketMs = timeSolvePath(grid, queries, bucketTotal);
+    grid.setOpenListType(OpenListType::HEAP);
+
+    printStatsRow("priority_queue (lazy)", queueMs, queueTotal);
+    printStatsRow("indexed 4-ary heap", heapMs, heapTotal);
+    printStatsRow("bucket queue", bucketMs, bucketTotal);
+}
+
+// Runs the queries through each solver and checks path costs against the
+// first solver in the list
+static void benchSolvers(NodeGrid& grid, const QueryList& queries,
+                         const std::vector<SolverType>& solvers) {
+    std::vector<float> referenceCosts;
+
+    for (SolverType solver : solvers) {
+        grid.setSolverType(solver);
+        if (solver == SolverType::JPS_PLUS)
+            grid.getJpsPlusTable();    // preprocessing is timed separately
+        SearchStats total;
+        std::vector<float> costs;
+        int mismatches = 0;
+
+        double ms = timeMs([&] {
+            for (auto& query : queries) {
+                grid.setStartNode(query.first);
+                grid.setEndNode(query.second);
+                grid.solvePath();
+                accumulate(total, grid.getSearchStats());
+                costs.push_back(grid.getPathCost());
+            }
+        });
+
+        if (referenceCosts.empty()) {
+            referenceCosts = costs;
+        }
+        for (size_t q = 0; q < costs.size(); ++q) {
+            if (std::fabs(costs[q] - referenceCosts[q]) > 1e-3f)
+                ++mismatches;
+        }
+
+        printStatsRow(solverName(solver), ms, total);
+        if (mismatches)
+            printf("  %-22s %d of %zu path costs differ from %s\n",
+                   "", mismatches, costs.size(), solverName(solvers.front()));
+    }
+    grid.setSolverType(SolverType::ASTAR);
+}
+
+// A* with octile distance against A* with the ALT landmark bound, plus
+// the cost of building, saving and loading the tables
+static void benchLandmarks(NodeGrid& grid, const QueryList& queries) {
+    printf("ALT landmarks\n");
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    LandmarkTable serial;
+    double serialMs = timeMs([&] { serial.rebuild(grid, 1); });
+    double parallelMs = timeMs([&] { grid.getLandmarkTable(); });
+    const LandmarkTable& table = grid.getLandmarkTable();
+
+    printf("  %d landmarks, quantum %u, %zu KB: build %.2f ms on 1 thread, %.2f ms on %u\n",
+           table.landmarkCount(), table.quantum(), table.memoryBytes() / 1024,
+           serialMs, parallelMs, threads);
+
+    std::string path = (std::filesystem::temp_directory_path() / "a-star-bench.alt").string();
+    LandmarkTable loaded;
+    double saveMs = timeMs([&] { table.save(path.c_str()); });
+    double loadMs = timeMs([&] { loaded.load(grid, path.c_str()); });
+    std::remove(path.c_str());
+    printf("  save %.2f ms, load %.2f ms\n", saveMs, loadMs);
+
+    std::vector<float> plainCosts;
+    SearchStats plainTotal, altTotal;
+    int mismatches = 0;
+
+    double plainMs = timeMs([&] {
+        for (auto& query : queries) {
+            grid.setStartNode(query.first);
+            grid.setEndNode(query.second);
+            grid.solvePath();
+            accumulate(plainTotal, grid.getSearchStats());
+            plainCosts.push_back(grid.getPathCost());
+        }
+    });
+
+    grid.setUseLandmarks(true);
+    double altMs = timeMs([&] {
+        for (size_t q = 0; q < queries.size(); ++q) {
+            grid.setStartNode(queries[q].first);
+            grid.setEndNode(queries[q].second);
+            grid.solvePath();
+            accumulate(altTotal, grid.getSearchStats());
+            if (std::fabs(grid.getPathCost() - plainCosts[q]) > 1e-3f)
+                ++mismatches;
+        }
+    });
+    grid.setUseLandmarks(false);
+
+    printStatsRow("A* octile", plainMs, plainTotal);
+    printStatsRow("A* ALT", altMs, altTotal);
+    if (mismatches)
+        printf("  %-22s %d of %zu path costs differ\n", "", mismatches, queries.size());
+}
+
+// HPA* against flat A*: query time, path quality, per-query search state
+// and the first steps of a path, then the cost of keeping sectors current
+static void benchHpa(NodeGrid& grid, const QueryList& queries) {
+    const size_t FIRST_STEPS = 32;
+    printf("HPA* vs A*\n");
+
+    HpaMap* hpa = nullptr;
+    double buildMs = timeMs([&] { hpa = &grid.getHpaMap(); });
+    printf("  build %.2f ms, %d sectors of %dx%d, %zu transitions\n",
+           buildMs, hpa->sectorCount(), hpa->sectorSize(), hpa->sectorSize(), hpa->transitionCount());
+
+    SearchStats flatTotal, hpaTotal;
+    std::vector<float> flatCosts, hpaCosts;
+
+    grid.setSolverType(SolverType::ASTAR);
+    double flatMs = timeMs([&] {
+        for (auto& query : queries) {
+            grid.setStartNode(query.first);
+            grid.setEndNode(query.second);
+            grid.solvePath();
+            accumulate(flatTotal, grid.getSearchStats());
+            flatCosts.push_back(grid.getPathCost());
+        }
+    });
+
+    grid.setSolverType(SolverType::HPA);
+    double hpaMs = timeMs([&] {
+        for (auto& query : queries) {
+            grid.setStartNode(query.first);
+            grid.setEndNode(query.second);
+            grid.solvePath();
+            accumulate(hpaTotal, grid.getSearchStats());
+            hpaCosts.push_back(grid.getPathCost());
+        }
+    });
+    grid.setSolverType(SolverType::ASTAR);
+
+    // Abstract search plus refinement of only the first few steps
+    SearchStats firstTotal;
+    double firstMs = timeMs([&] {
+        for (auto& query : queries) {
+            HpaPath path;
+            std::vector<NodeId> steps;
+            if (hpa->findPath(query.first, query.second, path, firstTotal))
+                path.nextSteps(FIRST_STEPS, steps);
+        }
+    });
+
+    double excess = 0.0;
+    int solved = 0;
+    for (size_t q = 0; q < flatCosts.size(); ++q) {
+        if (!std::isinf(flatCosts[q]) && flatCosts[q] > 0.0f) {
+            excess += hpaCosts[q] / flatCosts[q] - 1.0;
+            ++solved;
+        }
+    }
+
+    // g, h, parent and stamp per state entry plus the open list slot
+    const size_t bytesPerEntry = 4 * sizeof(uint32_t) + sizeof(uint32_t);
+    size_t sectorCells = static_cast<size_t>(hpa->sectorSize()) * hpa->sectorSize();
+
+    printStatsRow("A*", flatMs, flatTotal);
+    printStatsRow("HPA* (full path)", hpaMs, hpaTotal);
+    printf("  %-22s %10.2f ms\n", "HPA* (first 32 steps)", firstMs);
+    printf("  HPA* paths %.2f%% longer on average, search state %zu KB vs %zu KB per query\n",
+           solved ? 100.0 * excess / solved : 0.0,
+           (hpa->transitionCount() + 2 + sectorCells) * bytesPerEntry / 1024,
+           static_cast<size_t>(grid.getTotalNodes()) * bytesPerEntry / 1024);
+
+    std::mt19937 generator(8);
+    std::uniform_int_distribution<NodeId> pick(0, grid.getTotalNodes() - 1);
+    const int edits = 200;
+
+    double editMs = timeMs([&] {
+        for (int i = 0; i < edits; ++i) {
+            NodeId nid = pick(generator);
+            if (!grid.isStartNode(nid) && !grid.isEndNode(nid))
+                grid.toggleObstacle(nid);
+        }
+    });
+    printf("  incremental update %.4f ms per toggle\n", editMs / edits);
+}
+
+// JPS+ preprocessing and the cost of keeping it current under edits
+static void benchJpsPlusUpdates(NodeGrid& grid) {
+    printf("JPS+ tables\n");
+
+    JpsPlusTable scratch;
+    double rebuildMs = timeMs([&] { scratch.rebuild(grid); });
+
+    std::mt19937 generator(5);
+    std::uniform_int_distribution<NodeId> pick(0, grid.getTotalNodes() - 1);
+    const int edits = 200;
+
+    double editMs = timeMs([&] {
+        for (int i = 0; i < edits; ++i) {
+            NodeId nid = pick(generator);
+            if (!grid.isStartNode(nid) && !grid.isEndNode(nid))
+                grid.toggleObstacle(nid);
+        }
+    });
+
+    printf("  full build %.2f ms, incremental update %.4f ms per toggle\n",
+           rebuildMs, editMs / edits);
+}
+
+// Weighted A* at a few weights and ARA* under a time budget, with path
+// costs relative to the optimal ones
+static void benchAnytime(NodeGrid& grid, const QueryList& queries) {
+    printf("Weighted A* and ARA*\n");
+
+    std::vector<float> optimal;
+    for (auto& query : queries) {
+        grid.setStartNode(query.first);
+        grid.setEndNode(query.second);
+        grid.solvePath();
+        optimal.push_back(grid.getPathCost());
+    }
+
+    // Mean ratio of the last solvePath cost to the optimal one, accumulated per query
+    auto excess = [&](size_t q) {
+        return (optimal[q] > 0.0f) ? grid.getPathCost() / optimal[q] : 1.0;
+    };
+
+    for (float weight : { 1.0f, 1.5f, 2.0f, 3.0f }) {
+        SearchStats total;
+        double ratio = 0.0;
+        grid.setWeight(weight);
+
+        double ms = timeMs([&] {
+            for (size_t q = 0; q < queries.size(); ++q) {
+                grid.setStartNode(queries[q].first);
+                grid.setEndNode(queries[q].second);
+                grid.solvePath();
+                accumulate(total, grid.getSearchStats());
+                ratio += excess(q);
+            }
+        });
+
+        char name[32];
+        snprintf(name, sizeof(name), "weighted A* w=%.1f", weight);
+        printStatsRow(name, ms, total);
+        printf("  %-22s %10.4f cost / optimal\n", "", ratio / queries.size());
+    }
+    grid.setWeight(1.0f);
+
+    grid.setSolverType(SolverType::ARA);
+    for (double budgetMs : { 0.0, 10.0, 100.0 }) {
+        double firstMs = 0.0, firstBound = 0.0, finalBound = 0.0, ratio = 0.0;
+        size_t passes = 0, optimalCount = 0;
+        SearchStats total;
+        grid.setAnytimeBudgetMs(budgetMs);
+
+        double ms = timeMs([&] {
+            for (size_t q = 0; q < queries.size(); ++q) {
+                grid.setStartNode(queries[q].first);
+                grid.setEndNode(queries[q].second);
+                grid.solvePath();
+                accumulate(total, grid.getSearchStats());
+
+                const auto& solutions = grid.getAnytimeSolutions();
+                if (solutions.empty())
+                    continue;
+                firstMs += solutions.front().elapsedMs;
+                firstBound += solutions.front().bound;
+                finalBound += solutions.back().bound;
+                passes += solutions.size();
+                optimalCount += (solutions.back().bound <= 1.0f);
+                ratio += excess(q);
+            }
+        });
+
+        char name[32];
+        snprintf(name, sizeof(name), "ARA* e=%.1f, %.0f ms", grid.getAnytimeEpsilon(), budgetMs);
+        printStatsRow(name, ms, total);
+        printf("  %-22s first path %.2f ms bound %.3f, final bound %.3f, %.4f cost / optimal, "
+               "%.1f passes, %zu optimal\n", "", firstMs / queries.size(), firstBound / queries.size(),
+               finalBound / queries.size(), ratio / queries.size(),
+               static_cast<double>(passes) / queries.size(), optimalCount);
+    }
+    grid.setSolverType(SolverType::ASTAR);
+}
+
+// Live replanning: each round blocks a cell on the current path, reopens
+// an older one and moves the start a step along the path, then D* Lite
+// repairs its search while A* starts over on the same map
+static void benchDStarLite(NodeGrid& grid, const QueryList& queries) {
+    static constexpr int ROUNDS = 20;
+    static constexpr size_t REOPEN_AFTER = 3;
+
+    printf("D* Lite replanning, %d rounds per query\n", ROUNDS);
+
+    std::mt19937 generator(8);
+    SearchStats firstTotal, repairTotal, freshTotal;
+    double firstMs = 0.0, repairMs = 0.0, freshMs = 0.0;
+    int rounds = 0, mismatches = 0;
+
+    for (int q = 0; q < BENCH_POLICY_QUERIES && q < static_cast<int>(queries.size()); ++q) {
+        grid.setStartNode(queries[q].first);
+        grid.setEndNode(queries[q].second);
+        grid.setSolverType(SolverType::DSTAR_LITE);
+        firstMs += timeSolvePath(grid, { queries[q] }, firstTotal);
+
+        std::deque<NodeId> blocked;
+        for (int round = 0; round < ROUNDS; ++round) {
+            std::vector<NodeId> path = grid.getShortestPath();
+            if (path.size() < 4)
+                break;
+
+            // Paths run goal to start; path[size - 2] is where the start moves
+            NodeId cell = path[1 + generator() % (path.size() - 3)];
+            grid.beginEdit();
+            grid.setObstacle(cell, true);
+            blocked.push_back(cell);
+            if (blocked.size() > REOPEN_AFTER) {
+                grid.setObstacle(blocked.front(), false);
+                blocked.pop_front();
+            }
+            grid.commitEdit();
+            grid.setStartNode(path[path.size() - 2]);
+
+            repairMs += timeMs([&] { grid.solvePath(); });
+            accumulate(repairTotal, grid.getSearchStats());
+            float repairCost = grid.getPathCost();
+
+            grid.setSolverType(SolverType::ASTAR);
+            freshMs += timeMs([&] { grid.solvePath(); });
+            accumulate(freshTotal, grid.getSearchStats());
+            if (std::fabs(grid.getPathCost() - repairCost) > 1e-3f)
+                ++mismatches;
+
+            grid.setSolverType(SolverType::DSTAR_LITE);
+            ++rounds;
+        }
+    }
+    grid.setSolverType(SolverType::ASTAR);
+
+    rounds = std::max(rounds, 1);
+    printStatsRow("D* Lite first plan", firstMs, firstTotal);
+    printf("  %-22s %10.3f ms %12.0f exp per replan\n", "D* Lite repair",
+           repairMs / rounds, static_cast<double>(repairTotal.expansions) / rounds);
+    printf("  %-22s %10.3f ms %12.0f exp per replan\n", "A* from scratch",
+           freshMs / rounds, static_cast<double>(freshTotal.expansions) / rounds);
+    if (mismatches)
+        printf("  %-22s %d of %d path costs differ\n", "", mismatches, rounds);
+}
+
+// A sequence of starts to one goal, A* with the octile heuristic against
+// Adaptive A*. Halfway through, an obstacle next to the goal is cleared
+// when clearHalfway is set, which drops everything learned so far.
+static void benchAdaptive(NodeGrid& grid, const QueryList& queries, bool clearHalfway) {
+    static constexpr int SEQUENCE = 20;
+
+    NodeId goal = queries[0].second;
+    QueryList starts = makeQueries(grid, SEQUENCE * 4, 9);
+    printf("Adaptive A*, %d starts to one goal\n", SEQUENCE);
+    printf("  %-8s %12s %12s %8s\n", "query", "A* exp", "adaptive exp", "learned");
+
+    grid.setSolverType(SolverType::ASTAR);
+    grid.setEndNode(goal);
+
+    SearchStats plainTotal, adaptiveTotal;
+    double plainMs = 0.0, adaptiveMs = 0.0;
+    int query = 0, mismatches = 0;
+
+    for (const auto& pair : starts) {
+        if (query == SEQUENCE)
+            break;
+        int dist = std::abs(grid.x(pair.first) - grid.x(goal)) +
+                   std::abs(grid.y(pair.first) - grid.y(goal));
+        if (dist < (grid.getRows() + grid.getColumns()) / 4)
+            continue;
+
+        if (clearHalfway && query == SEQUENCE / 2) {
+            for (int dx = -2; dx <= 2; ++dx) {
+                int cell_x = grid.x(goal) + dx;
+                if (cell_x >= 0 && cell_x < grid.getColumns() &&
+                    grid.isObstacle(grid.nodeAt(cell_x, grid.y(goal)))) {
+                    grid.setObstacle(grid.nodeAt(cell_x, grid.y(goal)), false);
+                    printf("  cleared an obstacle next to the goal\n");
+                    break;
+                }
+            }
+        }
+        grid.setStartNode(pair.first);
+
+        grid.setUseAdaptive(false);
+        plainMs += timeMs([&] { grid.solvePath(); });
+        SearchStats plain = grid.getSearchStats();
+        float plainCost = grid.getPathCost();
+
+        grid.setUseAdaptive(true);
+        adaptiveMs += timeMs([&] { grid.solvePath(); });
+        SearchStats adaptive = grid.getSearchStats();
+        if (std::fabs(grid.getPathCost() - plainCost) > 1e-3f)
+            ++mismatches;
+
+        printf("  %-8d %12llu %12llu %8zu\n", query,
+               static_cast<unsigned long long>(plain.expansions),
+               static_cast<unsigned long long>(adaptive.expansions),
+               grid.getAdaptiveHeuristic().learnedCount());
+        accumulate(plainTotal, plain);
+        accumulate(adaptiveTotal, adaptive);
+        ++query;
+    }
+    grid.setUseAdaptive(false);
+
+    printStatsRow("A* octile", plainMs, plainTotal);
+    printStatsRow("Adaptive A*", adaptiveMs, adaptiveTotal);
+    if (mismatches)
+        printf("  %-22s %d of %d path costs differ\n", "", mismatches, query);
+}
+
+// Line of sight by walking the cells the segment enters one at a time
+// (Amanatides & Woo), passing exact corners diagonally like the default
+// corner cutting rule
+static bool lineOfSightByCell(const NodeGrid& grid, NodeId from, NodeId to) {
+    int x = grid.x(from), y = grid.y(from);
+    int dx = grid.x(to) - x, dy = grid.y(to) - y;
+    int stepX = (dx > 0) - (dx < 0), stepY = (dy > 0) - (dy < 0);
+    int64_t adx = std::abs(dx), ady = std::abs(dy);
+    int64_t crossX = 1, crossY = 1;    // next boundary at crossX / (2 adx) and crossY / (2 ady)
+
+    while (!grid.isObstacle(grid.nodeAt(x, y))) {
+        if (x == grid.x(to) && y == grid.y(to))
+            return true;
+
+        int64_t order = crossX * ady - crossY * adx;
+        if (order <= 0 || ady == 0) { x += stepX; crossX += 2; }
+        if (order >= 0 || adx == 0) { y += stepY; crossY += 2; }
+    }
+    return false;
+}
+
+// Theta* and Lazy Theta* against A*, and the word-parallel line of sight
+// they spend their time in against a cell-by-cell walk
+static void benchAnyAngle(NodeGrid& grid, const QueryList& queries) {
+    printf("Any-angle paths\n");
+
+    double gridCost = 0.0;
+    for (SolverType solver : { SolverType::ASTAR, SolverType::THETA, SolverType::LAZY_THETA }) {
+        grid.setSolverType(solver);
+        SearchStats total;
+        double cost = 0.0;
+        size_t waypoints = 0;
+
+        double ms = timeMs([&] {
+            for (auto& query : queries) {
+                grid.setStartNode(query.first);
+                grid.setEndNode(query.second);
+                grid.solvePath();
+                accumulate(total, grid.getSearchStats());
+                cost += grid.getPathCost();
+                waypoints += grid.getShortestPath().size();
+            }
+        });
+        if (solver == SolverType::ASTAR)
+            gridCost = cost;
+
+        printStatsRow(solverName(solver), ms, total);
+        printf("  %-22s %10.2f%% shorter, %zu path entries\n", "", 100.0 * (1.0 - cost / gridCost),
+               waypoints);
+    }
+    grid.setSolverType(SolverType::ASTAR);
+
+    // Segments up to 256 cells long between random free cells
+    static constexpr int PAIRS = 200000;
+    std::mt19937 generator(10);
+    std::uniform_int_distribution<int> offset(-256, 256);
+    std::vector<std::pair<NodeId, NodeId>> pairs;
+
+    while (static_cast<int>(pairs.size()) < PAIRS) {
+        NodeId from = queries[pairs.size() % queries.size()].first;
+        int to_x = std::clamp(grid.x(from) + offset(generator), 0, grid.getColumns() - 1);
+        int to_y = std::clamp(grid.y(from) + offset(generator), 0, grid.getRows() - 1);
+        if (!grid.isObstacle(grid.nodeAt(to_x, to_y)))
+            pairs.emplace_back(from, grid.nodeAt(to_x, to_y));
+    }
+
+    int wordVisible = 0, disagree = 0;
+    std::vector<bool> wordResults(pairs.size());
+    double wordMs = timeMs([&] {
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            wordResults[i] = grid.hasLineOfSight(pairs[i].first, pairs[i].second);
+            wordVisible += wordResults[i];
+        }
+    });
+    double cellMs = timeMs([&] {
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            disagree += (lineOfSightByCell(grid, pairs[i].first, pairs[i].second) != wordResults[i]);
+        }
+    });
+
+    printf("  line of sight, %d segments: word-parallel %.2f ms, cell by cell %.2f ms (%d visible)\n",
+           PAIRS, wordMs, cellMs, wordVisible);
+    if (disagree)
+        printf("  %-22s %d of %d results differ\n", "", disagree, PAIRS);
+}
+
+// Many agents to one goal: one flow field and a lookup per step against
+// one A* search per agent, then the field repaired after each of a series
+// of edits against a full rebuild. Runs on its own copy of the map, so
+// the edits are timed with no other listeners attached.
+static void benchFlowField(int rows, int cols, double density, unsigned seed) {
+    static constexpr int AGENTS = 10000;
+    static constexpr int ASTAR_AGENTS = 100;
+    static constexpr int EDITS = 50;
+
+    NodeGrid grid(rows, cols);
+    grid.setVerbose(false);
+    grid.setUseComponents(false);
+    fillRandomObstacles(grid, density, seed);
+
+    QueryList agents = makeQueries(grid, AGENTS, 11);
+    NodeId goal = agents[0].second;
+    printf("Flow field, %d agents to one goal\n", AGENTS);
+
+    const FlowField* field = nullptr;
+    double buildMs = timeMs([&] { field = &grid.getFlowField(goal); });
+    printf("  %-22s %10.2f ms %12zu cells, %.2f bytes per cell\n", "build", buildMs,
+           field->updatedCells(), static_cast<double>(field->memoryBytes()) / grid.getTotalNodes());
+
+    size_t steps = 0;
+    int arrived = 0;
+    double walkMs = timeMs([&] {
+        for (const auto& agent : agents) {
+            NodeId nid = agent.first;
+            for (NodeId next = field->nextStep(nid); next != INVALID_NODE; next = field->nextStep(nid)) {
+                nid = next;
+                ++steps;
+            }
+            arrived += (nid == goal);
+        }
+    });
+    printf("  %-22s %10.2f ms %12zu steps, %d of %d arrive\n", "walk all agents", walkMs, steps,
+           arrived, AGENTS);
+
+    grid.setSolverType(SolverType::ASTAR);
+    grid.setEndNode(goal);
+    SearchStats total;
+    double astarMs = timeMs([&] {
+        for (int i = 0; i < ASTAR_AGENTS; ++i) {
+            grid.setStartNode(agents[i].first);
+            grid.solvePath();
+            accumulate(total, grid.getSearchStats());
+        }
+    });
+    printf("  %-22s %10.2f ms per agent, %.0f ms for all of them\n", "A* instead",
+           astarMs / ASTAR_AGENTS, astarMs / ASTAR_AGENTS * AGENTS);
+
+    // Small blocks of walls dropped and cleared around the map
+    std::mt19937 generator(12);
+    std::uniform_int_distribution<int> pickX(0, cols - 1), pickY(0, rows - 1);
+    FlowField rebuilt;
+    double repairMs = 0.0, rebuildMs = 0.0;
+    size_t repaired = 0;
+    int mismatches = 0;
+
+    for (int edit = 0; edit < EDITS; ++edit) {
+        int x = pickX(generator), y = pickY(generator);
+        repairMs += timeMs([&] { grid.setObstacleRect(x, y, x + 4, y + 4, edit % 2 == 0); });
+        repaired += field->updatedCells();
+
+        rebuildMs += timeMs([&] { rebuilt.rebuild(grid, goal); });
+        for (NodeId nid = 0; nid < static_cast<NodeId>(grid.getTotalNodes()); ++nid) {
+            if (field->distance(nid) != rebuilt.distance(nid)) {
+                ++mismatches;
+                break;
+            }
+        }
+    }
+    printf("  %-22s %10.3f ms per edit, %zu cells updated\n", "repair", repairMs / EDITS,
+           repaired / EDITS);
+    printf("  %-22s %10.3f ms per edit\n", "rebuild", rebuildMs / EDITS);
+    if (mismatches)
+        printf("  %-22s %d of %d repaired fields differ from a rebuild\n", "", mismatches, EDITS);
+}
+
+// Random queries on the half blocked map randomizeObstacles makes, where
+// many pairs have no path at all
+static void benchComponents(int rows, int cols) {
+    static constexpr double DENSITY = 0.5;
+    static constexpr int QUERIES = 200;
+    static constexpr int EDITS = 1000;
+
+    NodeGrid grid(rows, cols);
+    grid.setVerbose(false);
+    fillRandomObstacles(grid, DENSITY, 31);
+
+    std::mt19937 generator(32);
+    std::uniform_int_distribution<NodeId> pick(0, grid.getTotalNodes() - 1);
+    QueryList queries;
+    while (static_cast<int>(queries.size()) < QUERIES) {
+        NodeId start = pick(generator), goal = pick(generator);
+        if (!grid.isObstacle(start) && !grid.isObstacle(goal))
+            queries.emplace_back(start, goal);
+    }
+    printf("Connected regions, %.0f%% obstacles, %d random queries\n", DENSITY * 100, QUERIES);
+
+    // solve only checks the regions once they are built
+    SearchContext context;
+    context.recordTrace = false;
+    auto solveAll = [&](int& unreachable, uint64_t& expansions) {
+        unreachable = 0;
+        expansions = 0;
+        return timeMs([&] {
+            for (const auto& query : queries) {
+                unreachable += !grid.solve(query.first, query.second, context);
+                expansions += context.stats.expansions;
+            }
+        });
+    };
+
+    int unreachable;
+    uint64_t expansions;
+    double searchMs = solveAll(unreachable, expansions);
+    printf("  %-22s %10.2f ms %12llu exp, %d unreachable\n", "search only", searchMs,
+           static_cast<unsigned long long>(expansions), unreachable);
+
+    const ComponentMap* components = nullptr;
+    double buildMs = timeMs([&] { components = &grid.getComponentMap(); });
+    ComponentMap serial;
+    double serialMs = timeMs([&] { serial.rebuild(grid, 1); });
+    printf("  %-22s %10.2f ms on %u threads, %.2f ms on one\n", "label regions", buildMs,
+           std::max(1u, std::thread::hardware_concurrency()), serialMs);
+
+    double rejectMs = solveAll(unreachable, expansions);
+    printf("  %-22s %10.2f ms %12llu exp, %d unreachable\n", "regions checked first", rejectMs,
+           static_cast<unsigned long long>(expansions), unreachable);
+
+    std::vector<uint32_t> sizes = components->componentSizes();
+    printf("  %-22s %10zu regions, largest %.1f%% of the free cells, %zu of one cell\n", "",
+           sizes.size(), 100.0 * sizes[0] / components->updatedCells(),
+           static_cast<size_t>(std::count(sizes.begin(), sizes.end(), 1u)));
+
+    size_t relabeled = 0;
+    double editMs = timeMs([&] {
+        for (int edit = 0; edit < EDITS; ++edit) {
+            grid.toggleObstacle(pick(generator));
+            relabeled += components->updatedCells();
+        }
+    });
+    printf("  %-22s %10.4f ms per toggle, %zu cells relabeled\n", "update", editMs / EDITS,
+           relabeled / EDITS);
+}
+
+// Hops from the sources to every cell the node-by-node way solvePath
+// expands: a queue, popping one cell at a time and checking its neighbors.
+// Stops once stopAt has its hops.
+static size_t hopsByQueue(const NodeGrid& grid, const std::vector<NodeId>& sources,
+                          std::vector<uint32_t>& hops, NodeId stopAt = INVALID_NODE) {
+    hops.assign(grid.getTotalNodes(), BitBfs::UNREACHED);
+    std::vector<NodeId> queue;
+    queue.reserve(grid.getTotalNodes());
+
+    for (NodeId source : sources) {
+        if (!grid.isObstacle(source) && hops[source] == BitBfs::UNREACHED) {
+            hops[source] = 0;
+            queue.push_back(source);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        if (stopAt != INVALID_NODE && hops[stopAt] != BitBfs::UNREACHED)
+            break;
+        uint32_t next = hops[queue[head]] + 1;
+        grid.forEachNeighbor(queue[head], [&](NodeId adj, Direction) {
+            if (hops[adj] == BitBfs::UNREACHED) {
+                hops[adj] = next;
+                queue.push_back(adj);
+            }
+        });
+    }
+    return queue.size();
+}
+
+// Hop fields, multi-source floods and reachability on a large map, the
+// frontier moved a word at a time against a queue of cells
+static void benchBitBfs(int size, double density, unsigned seed) {
+    static constexpr int SOURCES = 256;
+    static constexpr int QUERIES = 10;
+
+    NodeGrid grid(size, size);
+    grid.setVerbose(false);
+    fillRandomObstacles(grid, density, seed);
+    printf("Bit-parallel BFS, %dx%d map\n", size, size);
+
+    std::mt19937 generator(seed + 1);
+    std::uniform_int_distribution<NodeId> pick(0, grid.getTotalNodes() - 1);
+    std::vector<NodeId> center = { grid.nodeAt(size / 2, size / 2) };
+    std::vector<NodeId> sources;
+    for (int i = 0; i < SOURCES; ++i) {
+        sources.push_back(pick(generator));
+    }
+
+    BitBfs bfs;
+    std::vector<uint32_t> queueHops, bitHops;
+    for (const auto* from : { &center, &sources }) {
+        size_t queueCells = 0, bitCells = 0, floodCells = 0;
+        double queueMs = timeMs([&] { queueCells = hopsByQueue(grid, *from, queueHops); });
+        double bitMs   = timeMs([&] { bitCells = bfs.hopDistances(grid, *from, bitHops); });
+        double floodMs = timeMs([&] { floodCells = bfs.floodFill(grid, *from); });
+
+        printf("  %zu source%s, %zu cells, %u levels, %zu frontier words\n", from->size(),
+               from->size() == 1 ? "" : "s", queueCells, bfs.levels(), bfs.expandedWords());
+        printf("  %-22s %10.2f ms\n", "queue of cells", queueMs);
+        printf("  %-22s %10.2f ms hop field, %.2f ms flood fill\n", "bit-parallel", bitMs, floodMs);
+        if (queueHops != bitHops || bitCells != queueCells || floodCells != queueCells)
+            printf("  %-22s hop fields differ\n", "");
+    }
+
+    int queueReached = 0, bitReached = 0;
+    QueryList queries = makeQueries(grid, QUERIES, seed + 2);
+    double queueMs = timeMs([&] {
+        for (const auto& query : queries) {
+            hopsByQueue(grid, { query.first }, queueHops, query.second);
+            queueReached += (queueHops[query.second] != BitBfs::UNREACHED);
+        }
+    });
+    double bitMs = timeMs([&] {
+        for (const auto& query : queries) {
+            bitReached += bfs.reachable(grid, query.first, query.second);
+        }
+    });
+    printf("  %-22s %10.2f ms queue, %.2f ms bit-parallel, %d of %d reachable\n", "reachability",
+           queueMs, bitMs, bitReached, QUERIES);
+    if (queueReached != bitReached)
+        printf("  %-22s %d reachable by the queue\n", "", queueReached);
+}
+
+// The same few routes asked for again and again, with a wall toggled now
+// and then, once without and once with the path cache
+static void benchPathCache(int rows, int cols) {
+    static constexpr int ROUTES = 50;
+    static constexpr int QUERIES = 1000;
+    static constexpr int QUERIES_PER_EDIT = 20;
+    static constexpr size_t CAPACITY = 64;
+
+    auto printRow = [](size_t capacity, double ms, const SearchStats& total, const NodeGrid& grid) {
+        if (capacity == 0) {
+            printf("  %-22s %10.2f ms %12llu exp\n", "no cache", ms,
+                   static_cast<unsigned long long>(total.expansions));
+            return;
+        }
+        const PathCacheStats& stats = grid.getPathCache().stats();
+        char name[64];
+        snprintf(name, sizeof(name), "%zu paths cached", capacity);
+        printf("  %-22s %10.2f ms %12llu exp, %llu hits, %llu subpath hits, %llu misses, "
+               "%llu evicted, %llu invalidated, %zu KB\n", name, ms,
+               static_cast<unsigned long long>(total.expansions),
+               static_cast<unsigned long long>(stats.hits),
+               static_cast<unsigned long long>(stats.subpathHits),
+               static_cast<unsigned long long>(stats.misses),
+               static_cast<unsigned long long>(stats.evictions),
+               static_cast<unsigned long long>(stats.invalidations),
+               grid.getPathCache().memoryBytes() / 1024);
+    };
+
+    printf("Path cache, %d queries over %d routes, a toggle every %d queries\n", QUERIES, ROUTES,
+           QUERIES_PER_EDIT);
+
+    for (size_t capacity : { size_t(0), CAPACITY }) {
+        NodeGrid grid(rows, cols);
+        grid.setVerbose(false);
+        grid.setUseComponents(false);
+        fillRandomObstacles(grid, BENCH_DENSITY, 1);
+        grid.setPathCacheCapacity(capacity);
+
+        QueryList routes = makeQueries(grid, ROUTES, 41);
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> pickRoute(0, ROUTES - 1);
+        std::uniform_int_distribution<NodeId> pickCell(0, grid.getTotalNodes() - 1);
+        SearchStats total;
+
+        double ms = timeMs([&] {
+            for (int q = 0; q < QUERIES; ++q) {
+                if (q % QUERIES_PER_EDIT == QUERIES_PER_EDIT - 1)
+                    grid.toggleObstacle(pickCell(generator));
+
+                const auto& route = routes[pickRoute(generator)];
+                grid.setStartNode(route.first);
+                grid.setEndNode(route.second);
+                grid.solvePath();
+                accumulate(total, grid.getSearchStats());
+            }
+        });
+        printRow(capacity, ms, total, grid);
+    }
+
+    // Nested and overlapping routes: queries between two cells of a route,
+    // either way round, which the cached route answers without a search
+    printf("  then %d queries between cells of the %d routes, in both directions\n", QUERIES,
+           ROUTES);
+
+    std::vector<float> astarCosts;
+    for (size_t capacity : { size_t(0), CAPACITY }) {
+        NodeGrid grid(rows, cols);
+        grid.setVerbose(false);
+        grid.setUseComponents(false);
+        fillRandomObstacles(grid, BENCH_DENSITY, 1);
+        grid.setPathCacheCapacity(capacity);
+
+        std::vector<std::vector<NodeId>> routeCells;
+        for (const auto& route : makeQueries(grid, ROUTES, 41)) {
+            grid.setStartNode(route.first);
+            grid.setEndNode(route.second);
+            grid.solvePath();
+            if (grid.getShortestPath().size() >= 2)
+                routeCells.push_back(grid.getShortestPath());
+        }
+
+        std::mt19937 generator(43);
+        std::uniform_int_distribution<size_t> pickRoute(0, routeCells.size() - 1);
+        QueryList queries;
+        while (static_cast<int>(queries.size()) < QUERIES) {
+            const auto& cells = routeCells[pickRoute(generator)];
+            std::uniform_int_distribution<size_t> pickCell(0, cells.size() - 1);
+            NodeId start = cells[pickCell(generator)], goal = cells[pickCell(generator)];
+            if (start != goal)
+                queries.emplace_back(start, goal);
+        }
+
+        SearchStats total;
+        std::vector<float> costs;
+        double ms = timeMs([&] {
+            for (const auto& query : queries) {
+                grid.setStartNode(query.first);
+                grid.setEndNode(query.second);
+                grid.solvePath();
+                accumulate(total, grid.getSearchStats());
+                costs.push_back(grid.getPathCost());
+            }
+        });
+        printRow(capacity, ms, total, grid);
+
+        if (capacity == 0) {
+            astarCosts = costs;
+            continue;
+        }
+        int mismatches = 0;
+        for (size_t q = 0; q < costs.size(); ++q) {
+            mismatches += (costs[q] != astarCosts[q]);
+        }
+        printf("  %-22s %d of %d path costs differ from A*\n", "", mismatches, QUERIES);
+    }
+}
+
+// Grass (3) crossed by a road (1) every ROAD_SPACING rows and columns,
+// with square mud patches (12) dropped at random
+static void fillTerrain(NodeGrid& grid, unsigned seed) {
+    static constexpr int ROAD_SPACING = 50;
+    static constexpr int MUD_PATCHES = 400;
+    static constexpr int MUD_SIZE = 24;
+
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> pickX(0, grid.getColumns() - 1), pickY(0, grid.getRows() - 1);
+    int cols = grid.getColumns();
+    int rows = grid.getRows();
+
+    grid.beginEdit();
+    grid.setTerrainRect(0, 0, cols, rows, 3);
+    for (int i = 0; i < MUD_PATCHES; ++i) {
+        int x = pickX(generator), y = pickY(generator);
+        grid.setTerrainRect(x, y, x + MUD_SIZE, y + MUD_SIZE, 12);
+    }
+    for (int y = ROAD_SPACING / 2; y < rows; y += ROAD_SPACING) {
+        grid.setTerrainRect(0, y, cols, y + 1, 1);
+    }
+    for (int x = ROAD_SPACING / 2; x < cols; x += ROAD_SPACING) {
+        grid.setTerrainRect(x, 0, x + 1, rows, 1);
+    }
+    grid.commitEdit();
+}
+
+// The solvers on a weighted map against the same map plain and weighted
+// the same everywhere, where the heuristic scales along, and bulk terrain
+// edits with a flow field and path cache to keep current
+static void benchTerrain(int rows, int cols) {
+    static constexpr int EDITS = 50;
+    static constexpr int EDIT_SIZE = 32;
+
+    NodeGrid grid(rows, cols);
+    grid.setVerbose(false);
+    grid.setUseComponents(false);
+    fillRandomObstacles(grid, BENCH_DENSITY, 1);
+    QueryList queries = makeQueries(grid, BENCH_QUERIES, 2);
+
+    printf("Terrain, grass with roads and mud patches\n");
+    SearchStats plainTotal;
+    double plainMs = timeSolvePath(grid, queries, plainTotal);
+    printStatsRow("A*, plain map", plainMs, plainTotal);
+
+    grid.setTerrainRect(0, 0, cols, rows, 3);
+    SearchStats uniformTotal;
+    double uniformMs = timeSolvePath(grid, queries, uniformTotal);
+    printStatsRow("A*, all grass", uniformMs, uniformTotal);
+
+    double fillMs = timeMs([&] { fillTerrain(grid, 51); });
+    printf("  %-22s %10.2f ms, multipliers %d to %d\n", "terrain layer", fillMs,
+           grid.getMinTerrain(), grid.getMaxTerrain());
+
+    // Fringe walks its whole list for each of thousands of thresholds here
+    benchSolvers(grid, queries, { SolverType::ASTAR, SolverType::JPS, SolverType::BIDIRECTIONAL,
+                                  SolverType::DSTAR_LITE });
+
+    // Landmark distances follow the roads the scaled octile bound ignores
+    grid.getLandmarkTable();
+    grid.setUseLandmarks(true);
+    SearchStats landmarkTotal;
+    double landmarkMs = timeSolvePath(grid, queries, landmarkTotal);
+    grid.setUseLandmarks(false);
+    printStatsRow("A*, landmarks", landmarkMs, landmarkTotal);
+
+    // Patches toggled between mud and grass under a live flow field and cache
+    grid.setPathCacheCapacity(64);
+    NodeId goal = queries[0].second;
+    const FlowField& field = grid.getFlowField(goal);
+    std::mt19937 generator(52);
+    std::uniform_int_distribution<int> pickX(0, cols - EDIT_SIZE), pickY(0, rows - EDIT_SIZE);
+    FlowField rebuilt;
+    double editMs = 0.0, rebuildMs = 0.0;
+    size_t repaired = 0;
+    int mismatches = 0;
+
+    for (int edit = 0; edit < EDITS; ++edit) {
+        int x = pickX(generator), y = pickY(generator);
+        editMs += timeMs([&] {
+            grid.setTerrainRect(x, y, x + EDIT_SIZE, y + EDIT_SIZE, (edit % 2 == 0) ? 12 : 3);
+        });
+        repaired += field.updatedCells();
+
+        rebuildMs += timeMs([&] { rebuilt.rebuild(grid, goal); });
+        for (NodeId nid = 0; nid < static_cast<NodeId>(grid.getTotalNodes()); ++nid) {
+            if (field.distance(nid) != rebuilt.distance(nid)) {
+                ++mismatches;
+                break;
+            }
+        }
+    }
+    printf("  %-22s %10.3f ms per edit of %dx%d cells, %zu field cells updated\n", "bulk edit",
+           editMs / EDITS, EDIT_SIZE, EDIT_SIZE, repaired / EDITS);
+    printf("  %-22s %10.3f ms per edit\n", "field rebuild", rebuildMs / EDITS);
+    if (mismatches)
+        printf("  %-22s %d of %d repaired fields differ from a rebuild\n", "", mismatches, EDITS);
+}
+
+// Path lookups in the grid's database against A* on the same queries
+static void timePathDatabase(NodeGrid& grid, const QueryList& queries) {
+    SearchContext context;
+    context.recordTrace = false;
+    std::vector<Cost> astarCosts;
+    SearchStats total;
+    size_t steps = 0;
+    int mismatches = 0;
+
+    grid.setSolverType(SolverType::ASTAR);
+    double astarMs = timeMs([&] {
+        for (const auto& query : queries) {
+            grid.solve(query.first, query.second, context);
+            accumulate(total, context.stats);
+            astarCosts.push_back(context.pathCost);
+        }
+    });
+
+    grid.setSolverType(SolverType::CPD);
+    double cpdMs = timeMs([&] {
+        for (size_t q = 0; q < queries.size(); ++q) {
+            grid.solve(queries[q].first, queries[q].second, context);
+            steps += context.path.size();
+            mismatches += (context.pathCost != astarCosts[q]);
+        }
+    });
+    grid.setSolverType(SolverType::ASTAR);
+
+    printStatsRow("A*", astarMs, total);
+    printf("  %-22s %10.2f ms %12zu lookups, %.3f us per step\n", "CPD", cpdMs, steps,
+           cpdMs * 1000.0 / std::max<size_t>(steps, 1));
+    if (mismatches)
+        printf("  %-22s %d of %zu path costs differ\n", "", mismatches, queries.size());
+}
+
+// Build, file round trip and queries of a compressed path database on a
+// map small enough to preprocess as part of the benchmarks
+static void benchPathDatabase(int size) {
+    static constexpr int QUERIES = 1000;
+
+    NodeGrid grid(size, size);
+    grid.setVerbose(false);
+    fillRandomObstacles(grid, BENCH_DENSITY, 51);
+    printf("Compressed path database, %dx%d map, %.0f%% obstacles, %d queries\n", size, size,
+           BENCH_DENSITY * 100, QUERIES);
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const PathDatabase* database = nullptr;
+    double buildMs = timeMs([&] { database = &grid.buildPathDatabase(); });
+    size_t freeCells = grid.getComponentMap().updatedCells();
+    printf("  build %.0f ms on %u threads, %zu runs (%.1f per source), %.2f bytes per cell pair\n",
+           buildMs, threads, database->runCount(), static_cast<double>(database->runCount()) / freeCells,
+           static_cast<double>(database->memoryBytes()) / (double(freeCells) * freeCells));
+
+    std::string path = (std::filesystem::temp_directory_path() / "a-star-bench.cpd").string();
+    double saveMs = timeMs([&] { database->save(path.c_str()); });
+    NodeGrid mapped(size, size);
+    mapped.setVerbose(false);
+    fillRandomObstacles(mapped, BENCH_DENSITY, 51);
+    bool loaded = false;
+    double loadMs = timeMs([&] { loaded = mapped.loadPathDatabase(path.c_str()); });
+    std::remove(path.c_str());
+    printf("  save %.2f ms, %s %.3f ms\n", saveMs, loaded ? "mapped" : "failed to map", loadMs);
+
+    timePathDatabase(mapped, makeQueries(mapped, QUERIES, 52));
+}
+
+int runPathDatabaseTool(int rows, int cols, const char* path) {
+    static constexpr int QUERIES = 1000;
+
+    NodeGrid grid(rows, cols);
+    grid.setVerbose(false);
+    grid.randomizeObstacles();
+
+    bool loaded = false;
+    double loadMs = timeMs([&] { loaded = grid.loadPathDatabase(path); });
+    if (loaded) {
+        printf("Mapped the path database in %s in %.3f ms\n", path, loadMs);
+    }
+    else {
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        printf("Building the path database on %u threads...\n", threads);
+
+        const PathDatabase* database = nullptr;
+        double buildMs = timeMs([&] { database = &grid.buildPathDatabase(); });
+        printf("Built %zu runs, %zu KB in %.0f ms\n", database->runCount(),
+               database->memoryBytes() / 1024, buildMs);
+
+        if (!database->save(path)) {
+            printf("Could not write %s\n", path);
+            return -1;
+        }
+        printf("Saved to %s\n", path);
+    }
+
+    timePathDatabase(grid, makeQueries(grid, QUERIES, 53));
+    return 0;
+}
+
+// Many short queries at once, as a crowd of units ordered about would ask
+static void benchBatch(NodeGrid& grid) {
+    static constexpr int QUERIES = 20000;
+    static constexpr int RADIUS = 64;
+    static constexpr int PATH_CAPACITY = 256;
+
+    std::mt19937 generator(21);
+    std::uniform_int_distribution<NodeId> pick(0, grid.getTotalNodes() - 1);
+    std::uniform_int_distribution<int> offset(-RADIUS, RADIUS);
+    std::vector<BatchQuery> queries;
+
+    while (static_cast<int>(queries.size()) < QUERIES) {
+        NodeId start = pick(generator);
+        int x = grid.x(start) + offset(generator);
+        int y = grid.y(start) + offset(generator);
+        if (x < 0 || y < 0 || x >= grid.getColumns() || y >= grid.getRows())
+            continue;
+        if (grid.isObstacle(start) || grid.isObstacle(grid.nodeAt(x, y)))
+            continue;
+        queries.push_back(BatchQuery{ start, grid.nodeAt(x, y), nullptr, PATH_CAPACITY, 0, 0, 0.0f });
+    }
+    std::vector<NodeId> paths(queries.size() * PATH_CAPACITY);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        queries[i].path = &paths[i * PATH_CAPACITY];
+    }
+
+    grid.setSolverType(SolverType::ASTAR);
+    printf("Batch queries, %d goals within %d cells, %u hardware threads\n", QUERIES, RADIUS,
+           std::thread::hardware_concurrency());
+
+    double serialMs = timeMs([&] {
+        for (auto& query : queries) {
+            grid.setStartNode(query.start);
+            grid.setEndNode(query.goal);
+            grid.solvePath();
+        }
+    });
+    printf("  %-22s %10.2f ms %10.0f queries/s\n", "solvePath loop", serialMs,
+           QUERIES / (serialMs / 1000.0));
+
+    std::vector<unsigned> threadCounts = { 1, 2, 4 };
+    if (std::thread::hardware_concurrency() > 4)
+        threadCounts.push_back(std::thread::hardware_concurrency());
+
+    char name[32];
+    for (unsigned threads : threadCounts) {
+        BatchStats stats = grid.solveBatch(queries.data(), queries.size(), threads);
+        snprintf(name, sizeof(name), "solveBatch, %u threads", threads);
+        printf("  %-22s %10.2f ms %10.0f queries/s %6.2fx, latency p50 %.1f us p99 %.1f us, "
+               "%zu solved, %lu steals\n", name, stats.wallMs, stats.queriesPerSecond,
+               serialMs / stats.wallMs, stats.p50LatencyUs, stats.p99LatencyUs, stats.solved,
+               static_cast<unsigned long>(stats.steals));
+    }
+}
+
+// A field of /proc/self/status in KB, 0 where it is not available
+static long readStatusKb(const char* field) {
+    FILE* file = std::fopen("/proc/self/status", "r");
+    if (!file)
+        return 0;
+
+    char line[256];
+    long value = 0;
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::strncmp(line, field, std::strlen(field)) == 0)
+            value = std::atol(line + std::strlen(field));
+    }
+    std::fclose(file);
+    return value;
+}
+
+// Returns freed heap to the system and restarts the peak RSS (VmHWM) at
+// the current RSS, which it returns
+static long resetPeakRssKb() {
+    malloc_trim(0);
+    if (FILE* file = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", file);
+        std::fclose(file);
+    }
+    return readStatusKb("VmRSS:");
+}
+
+// Peak RSS and time of the default A* and the memory-bounded solvers.
+// Each runs on a fresh copy of the map, and the peak counts everything
+// allocated since just before that copy was made: the map itself and
+// every per-cell array and table the solver allocates on first use.
+static void benchMemoryBounded(int rows, int cols, double density, unsigned seed,
+                               const QueryList& queries) {
+    struct Config {
+        const char* name;
+        SolverType solver;
+        size_t memoryLimit;
+    };
+    static const Config configs[] = {
+        { "A*",           SolverType::ASTAR,    NodeGrid::DEFAULT_MEMORY_LIMIT },
+        { "Fringe 16 MB", SolverType::FRINGE,   NodeGrid::DEFAULT_MEMORY_LIMIT },
+        { "Fringe 1 MB",  SolverType::FRINGE,   size_t(1) << 20 },
+        { "IDA* 16 MB",   SolverType::IDA_STAR, NodeGrid::DEFAULT_MEMORY_LIMIT },
+        { "IDA* 1 MB",    SolverType::IDA_STAR, size_t(1) << 20 },
+    };
+
+    printf("Memory-bounded search, %zu queries\n", queries.size());
+    for (const Config& config : configs) {
+        long baseKb = resetPeakRssKb();
+
+        NodeGrid grid(rows, cols);
+        grid.setVerbose(false);
+        grid.setUseComponents(false);    // its labels would count toward every peak
+        fillRandomObstacles(grid, density, seed);
+        grid.setSolverType(config.solver);
+        grid.setMemoryLimit(config.memoryLimit);
+
+        SearchStats total;
+        double ms = timeSolvePath(grid, queries, total);
+        long peakKb = readStatusKb("VmHWM:");
+
+        printf("  %-22s %10.2f ms %12llu exp %10ld KB peak RSS\n", config.name, ms,
+               static_cast<unsigned long long>(total.expansions), std::max(0L, peakKb - baseKb));
+    }
+}
+
+// One cell of the policy matrix: PolicySearch with the given policies on
+// the first queries, reporting time, expansions and the mean path cost
+template <typename Connectivity, typename Corners, typename CostModel, typename Distance>
+static void benchPolicy(const NodeGrid& grid, const QueryList& queries,
+                        const char* moves, const char* costName, const char* heuristicName) {
+    typedef typename CostModel::Value Value;
+
+    BasicSearchState<Value> state(grid.getTotalNodes());
+    IndexedHeap<Value> openList(grid.getTotalNodes());
+    PolicySearch<Connectivity, Corners, CostModel> search(grid, state);
+
+    SearchStats total;
+    double totalCost = 0.0;
+    int found = 0;
+
+    double ms = timeMs([&] {
+        for (int q = 0; q < BENCH_POLICY_QUERIES && q < static_cast<int>(queries.size()); ++q) {
+            NodeId goal = queries[q].second;
+            GoalDistance<Distance, CostModel> heuristic(grid.getColumns(), goal);
+            SearchStats stats;
+
+            state.beginQuery();
+            if (search.solve(queries[q].first, goal, openList, heuristic, stats)) {
+                totalCost += CostModel::toFloat(state.gRaw(goal));
+                ++found;
+            }
+            accumulate(total, stats);
+        }
+    });
+
+    printf("  %-20s %-6s %-10s %10.2f ms %12llu exp %10.2f mean cost\n",
+           moves, costName, heuristicName, ms, static_cast<unsigned long long>(total.expansions),
+           found ? totalCost / found : 0.0);
+}
+
+template <typename Connectivity, typename Corners, typename CostModel>
+static void benchPolicyHeuristics(const NodeGrid& grid, const QueryList& queries,
+                                  const char* moves, const char* costName) {
+    benchPolicy<Connectivity, Corners, CostModel, OctileDistance>(grid, queries, moves, costName, "octile");
+    benchPolicy<Connectivity, Corners, CostModel, ManhattanDistance>(grid, queries, moves, costName, "manhattan");
+    benchPolicy<Connectivity, Corners, CostModel, EuclideanDistance>(grid, queries, moves, costName, "euclidean");
+    benchPolicy<Connectivity, Corners, CostModel, ZeroDistance>(grid, queries, moves, costName, "zero");
+}
+
+template <typename Connectivity, typename Corners>
+static void benchPolicyCosts(const NodeGrid& grid, const QueryList& queries, const char* moves) {
+    benchPolicyHeuristics<Connectivity, Corners, FixedCost>(grid, queries, moves, "fixed");
+    benchPolicyHeuristics<Connectivity, Corners, FloatCost>(grid, queries, moves, "float");
+}
+
+// Every connectivity / corner rule / cost model / heuristic combination,
+// each compiled to its own search loop
+static void benchPolicies(const NodeGrid& grid, const QueryList& queries) {
+    printf("Search policies, %d queries\n", std::min(BENCH_POLICY_QUERIES, static_cast<int>(queries.size())));
+
+    benchPolicyCosts<FourConnected, CornerCutting>(grid, queries, "4-connected");
+    benchPolicyCosts<EightConnected, CornerCutting>(grid, queries, "8, cut corners");
+    benchPolicyCosts<EightConnected, NoSqueezing>(grid, queries, "8, no squeeze");
+    benchPolicyCosts<EightConnected, NoCornerCutting>(grid, queries, "8, no cutting");
+}
+
+int runBenchmarks(int rows, int cols) {
+    // The region check has a benchmark of its own. On these maps it would
+    // add the labeling to the first query timed and its upkeep to the
+    // timed edits.
+    NodeGrid grid(rows, cols);
+    grid.setVerbose(false);
+    grid.setUseComponents(false);
+    fillRandomObstacles(grid, BENCH_DENSITY, 1);
+
+    QueryList queries = makeQueries(grid, BENCH_QUERIES, 2);
+    printf("Benchmark map %dx%d, %.0f%% obstacles, %d queries\n\n",
+           rows, cols, BENCH_DENSITY * 100, BENCH_QUERIES);
+
+    benchOpenLists(grid, queries);
+
+    printf("\nSolvers, %.0f%% obstacles\n", BENCH_DENSITY * 100);
+    benchSolvers(grid, queries, { SolverType::ASTAR, SolverType::JPS, SolverType::JPS_PLUS,
+                                  SolverType::BIDIRECTIONAL });
+
+    printf("\n");
+    benchPolicies(grid, queries);
+
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchAnytime(grid, queries);
+
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchAnyAngle(grid, queries);
+
+    // On a copy of the map, the edits would skew the benchmarks below
+    NodeGrid liveGrid(rows, cols);
+    liveGrid.setVerbose(false);
+    liveGrid.setUseComponents(false);
+    fillRandomObstacles(liveGrid, BENCH_DENSITY, 1);
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchDStarLite(liveGrid, queries);
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchAdaptive(liveGrid, queries, true);
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchFlowField(rows, cols, BENCH_DENSITY, 1);
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchBatch(grid);
+    printf("\n");
+    benchComponents(rows, cols);
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchBitBfs(BENCH_BFS_SIZE, BENCH_DENSITY, 41);
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchPathCache(rows, cols);
+    printf("\n");
+    benchPathDatabase(BENCH_CPD_SIZE);
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchTerrain(rows, cols);
+
+    NodeGrid openGrid(rows, cols);
+    openGrid.setVerbose(false);
+    openGrid.setUseComponents(false);
+    fillRandomObstacles(openGrid, BENCH_OPEN_DENSITY, 3);
+    QueryList openQueries = makeQueries(openGrid, BENCH_QUERIES, 4);
+
+    printf("\nSolvers, %.0f%% obstacles\n", BENCH_OPEN_DENSITY * 100);
+    benchSolvers(openGrid, openQueries, { SolverType::ASTAR, SolverType::JPS, SolverType::JPS_PLUS,
+                                          SolverType::BIDIRECTIONAL });
+
+    NodeGrid mazeGrid(rows, cols);
+    mazeGrid.setVerbose(false);
+    mazeGrid.setUseComponents(false);
+    fillMaze(mazeGrid, 6);
+    QueryList mazeQueries = makeQueries(mazeGrid, BENCH_QUERIES, 7);
+
+    printf("\n%.0f%% obstacles: ", BENCH_OPEN_DENSITY * 100);
+    benchMemoryBounded(rows, cols, BENCH_OPEN_DENSITY, 3, openQueries);
+    printf("\n%.0f%% obstacles: ", BENCH_OPEN_DENSITY * 100);
+    benchAnyAngle(openGrid, openQueries);
+    printf("\n%.0f%% obstacles: ", BENCH_OPEN_DENSITY * 100);
+    benchFlowField(rows, cols, BENCH_OPEN_DENSITY, 3);
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchMemoryBounded(rows, cols, BENCH_DENSITY, 1,
+                       QueryList(queries.begin(), queries.begin() + BENCH_POLICY_QUERIES));
+
+    printf("\nSolvers, maze\n");
+    benchSolvers(mazeGrid, mazeQueries, { SolverType::ASTAR, SolverType::BIDIRECTIONAL });
+
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchLandmarks(grid, queries);
+    printf("\nMaze: ");
+    benchLandmarks(mazeGrid, mazeQueries);
+    printf("\nMaze: ");
+    benchAdaptive(mazeGrid, mazeQueries, false);
+
+    printf("\n");
+    benchJpsPlusUpdates(openGrid);
+
+    // After the JPS+ updates, so those are timed without the HPA* listener
+    printf("\n%.0f%% obstacles: ", BENCH_DENSITY * 100);
+    benchHpa(grid, queries);
+    printf("\n%.0f%% obstacles: ", BENCH_OPEN_DENSITY * 100);
+    benchHpa(openGrid, openQueries);
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "bidirectional_solver.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+BidirectionalSolver::BidirectionalSolver(const NodeGrid& grid,
+                                         SearchState& forward,  IndexedHeap<Cost>& forwardOpen,
+                                         SearchState& backward, IndexedHeap<Cost>& backwardOpen)
+    : m_grid(grid)
+    , m_forward{ forward, forwardOpen, INVALID_NODE, INVALID_NODE, Frontier::FORWARD }
+    , m_backward{ backward, backwardOpen, INVALID_NODE, INVALID_NODE, Frontier::BACKWARD }
+    , m_shift(0)
+    , m_bestCost(COST_INFINITY)
+    , m_meet(INVALID_NODE)
+{
+}
+
+bool BidirectionalSolver::solve(NodeId start, NodeId goal, SearchStats& stats,
+                                std::deque<TraceEntry>& trace) {
+    m_bestCost = COST_INFINITY;
+    m_meet = INVALID_NODE;
+    m_forward.source = m_backward.target = start;
+    m_forward.target = m_backward.source = goal;
+    m_shift = m_grid.heuristicCost(start, goal);
+
+    for (Side* side : { &m_forward, &m_backward }) {
+        NodeId root = side->source;
+        Cost rootH = m_grid.heuristicCost(root, side->target);
+
+        side->openList.clear();
+        side->state.open(root, 0, rootH, INVALID_NODE);
+        side->openList.push(root, key(*side, root, 0), rootH);
+        ++stats.pushes;
+    }
+    updateMeet(start, 0, m_backward.state);
+
+    while (!m_forward.openList.empty() && !m_backward.openList.empty()) {
+        // No path through the unexpanded nodes can beat mu any more. Keys
+        // are doubled and each carries the shift, so compare 64-bit sums.
+        uint64_t frontierBound = uint64_t(m_forward.openList.topKey()) + m_backward.openList.topKey();
+        if (m_bestCost != COST_INFINITY && frontierBound >= 2 * (uint64_t(m_bestCost) + m_shift))
+            break;
+
+        if (m_forward.openList.size() <= m_backward.openList.size())
+            expand(m_forward, m_backward.state, stats, trace);
+        else
+            expand(m_backward, m_forward.state, stats, trace);
+
+        stats.maxOpenSize = std::max(stats.maxOpenSize,
+                                     m_forward.openList.size() + m_backward.openList.size());
+    }
+
+    return m_meet != INVALID_NODE;
+}
+
+void BidirectionalSolver::expand(Side& side, const SearchState& other, SearchStats& stats,
+                                 std::deque<TraceEntry>& trace) {
+    SearchState& state = side.state;
+    NodeId current = side.openList.pop();
+    state.close(current);
+    ++stats.pops;
+
+    NodeId parent = state.parent(current);
+    if (parent != INVALID_NODE)
+        trace.push_back(TraceEntry{ current, parent, side.frontier });
+
+    ++stats.expansions;
+    Cost currentG = state.gRaw(current);
+
+    m_grid.forEachNeighbor(current, [&](NodeId adj, Direction dir) {
+        SearchState::Status status = state.status(adj);
+        if (status == SearchState::CLOSED)
+            return;
+
+        Cost adjG = currentG + m_grid.stepCost(current, adj, dir);
+
+        if (status == SearchState::UNSEEN) {
+            Cost adjH = m_grid.heuristicCost(adj, side.target);
+            state.open(adj, adjG, adjH, current);
+            side.openList.push(adj, key(side, adj, adjG), adjH);
+            ++stats.pushes;
+        }
+        else if (adjG < state.gRaw(adj)) {
+            state.relax(adj, adjG, current);
+            side.openList.decreaseKey(adj, key(side, adj, adjG));
+            ++stats.decreaseKeys;
+        }
+        else {
+            return;
+        }
+
+        updateMeet(adj, adjG, other);
+    });
+}
+
+Cost BidirectionalSolver::key(const Side& side, NodeId nid, Cost g) const {
+    // h(v, source) <= h(v, target) + h(source, target), so this never wraps
+    return 2 * g + m_grid.heuristicCost(nid, side.target) + m_shift
+                 - m_grid.heuristicCost(nid, side.source);
+}
+
+void BidirectionalSolver::updateMeet(NodeId nid, Cost g, const SearchState& other) {
+    if (!other.isTouched(nid))
+        return;
+
+    Cost joined = g + other.gRaw(nid);
+    if (joined < m_bestCost) {
+        m_bestCost = joined;
+        m_meet = nid;
+    }
+}
+
+void BidirectionalSolver::buildPath(std::vector<NodeId>& path) const {
+    path.clear();
+    if (m_meet == INVALID_NODE)
+        return;
+
+    // Goal half from the backward tree, then the start half from the forward tree
+    for (NodeId nid = m_meet; nid != INVALID_NODE; nid = m_backward.state.parent(nid)) {
+        path.push_back(nid);
+    }
+    std::reverse(path.begin(), path.end());
+
+    for (NodeId nid = m_forward.state.parent(m_meet); nid != INVALID_NODE;
+         nid = m_forward.state.parent(nid)) {
+        path.push_back(nid);
+    }
+}
@@ -0,0 +1,216 @@
+#include "bit_bfs.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+// Row words moved one column east or west, carrying the edge bit of the
+// word next to them
+static uint64_t shiftEast(uint64_t left, uint64_t word) {
+    return (word << 1) | (left >> 63);
+}
+
+static uint64_t shiftWest(uint64_t word, uint64_t right) {
+    return (word >> 1) | (right << 63);
+}
+
+BitBfs::BitBfs()
+    : m_rows(0)
+    , m_columns(0)
+    , m_stride(0)
+    , m_connectivity(Connectivity::EIGHT)
+    , m_cornerRule(CornerRule::CUT_CORNERS)
+    , m_visited(nullptr)
+    , m_frontier(nullptr)
+    , m_next(nullptr)
+    , m_stamp(0)
+    , m_levels(0)
+    , m_expandedWords(0)
+{
+}
+
+size_t BitBfs::wordOf(NodeId nid) const {
+    size_t row = nid / m_columns;
+    size_t bit = nid % m_columns + 1;
+    return (row + 1) * m_stride + bit / 64;
+}
+
+bool BitBfs::reached(NodeId nid) const {
+    return m_visited && (m_visited[wordOf(nid)] & bitOf(nid, m_columns));
+}
+
+uint64_t BitBfs::reach(const uint64_t* obstacles, size_t word) const {
+    const uint64_t* f = m_frontier;
+    size_t up = word - m_stride, down = word + m_stride;
+
+    uint64_t cells = shiftEast(f[word - 1], f[word]) | shiftWest(f[word], f[word + 1]) | f[up] | f[down];
+    if (m_connectivity == Connectivity::FOUR)
+        return cells;
+
+    uint64_t fromUp   = shiftEast(f[up - 1], f[up]) | shiftWest(f[up], f[up + 1]);
+    uint64_t fromDown = shiftEast(f[down - 1], f[down]) | shiftWest(f[down], f[down + 1]);
+    if (m_cornerRule == CornerRule::CUT_CORNERS)
+        return cells | fromUp | fromDown;
+
+    // A diagonal passes the cell beside its start in the target's row and
+    // the one beside its target in the start's row
+    uint64_t freeLeft = ~obstacles[word - 1], freeMid = ~obstacles[word], freeRight = ~obstacles[word + 1];
+    uint64_t besideUp = shiftEast(f[up - 1] & freeLeft, f[up] & freeMid) |
+                        shiftWest(f[up] & freeMid, f[up + 1] & freeRight);
+    uint64_t besideDown = shiftEast(f[down - 1] & freeLeft, f[down] & freeMid) |
+                          shiftWest(f[down] & freeMid, f[down + 1] & freeRight);
+
+    if (m_cornerRule == CornerRule::NO_CUTTING)
+        return cells | (besideUp & ~obstacles[up]) | (besideDown & ~obstacles[down]);
+    return cells | besideUp | (fromUp & ~obstacles[up]) | besideDown | (fromDown & ~obstacles[down]);
+}
+
+void BitBfs::begin(const NodeGrid& grid) {
+    m_rows         = grid.getRows();
+    m_columns      = grid.getColumns();
+    m_connectivity = grid.getConnectivity();
+    m_cornerRule   = grid.getCornerRule();
+    m_stride       = grid.getObstacles().wordsPerRow();
+    m_levels = 0;
+    m_expandedWords = 0;
+
+    // The next level's words are zero between levels and the frontier's
+    // are listed in m_active, so only a resize clears them all
+    size_t numWords = static_cast<size_t>(m_rows + 2) * m_stride;
+    if (m_visitedWords.size() != numWords + 2) {
+        m_visitedWords.assign(numWords + 2, 0);
+        m_frontierWords.assign(numWords + 2, 0);
+        m_nextWords.assign(numWords + 2, 0);
+        m_visited  = m_visitedWords.data() + 1;
+        m_frontier = m_frontierWords.data() + 1;
+        m_next     = m_nextWords.data() + 1;
+        m_seen.assign(numWords, 0);
+        m_stamp = 0;
+    }
+    else {
+        std::fill(m_visitedWords.begin(), m_visitedWords.end(), 0);
+        for (uint32_t word : m_active) {
+            m_frontier[word] = 0;
+        }
+    }
+    m_active.clear();
+
+    if (m_stamp >= UINT32_MAX - 1) {
+        std::fill(m_seen.begin(), m_seen.end(), 0);
+        m_stamp = 0;
+    }
+}
+
+template <typename Fn>
+void BitBfs::search(const NodeGrid& grid, const std::vector<NodeId>& sources, uint32_t maxHops,
+                    Fn&& onLevel) {
+    const uint64_t* obstacles = grid.getObstacles().rowWords(-1);
+
+    for (NodeId source : sources) {
+        if (source >= static_cast<NodeId>(grid.getTotalNodes()) || grid.isObstacle(source))
+            continue;
+
+        size_t word = wordOf(source);
+        uint64_t bit = bitOf(source, m_columns);
+        if (m_visited[word] & bit)
+            continue;
+
+        if (!m_frontier[word])
+            m_active.push_back(static_cast<uint32_t>(word));
+        m_frontier[word] |= bit;
+        m_visited[word] |= bit;
+    }
+    for (uint32_t word : m_active) {
+        if (onLevel(0u, word, m_frontier[word]))
+            return;
+    }
+
+    // Guard rows, guard columns and the spare word at the end of each row
+    // are blocked, so their words end the search there without bounds
+    // checks, and frontier bits are never guard columns
+    for (uint32_t level = 1; level <= maxHops && !m_active.empty(); ++level) {
+        ++m_stamp;
+        m_nextActive.clear();
+        m_expandedWords += m_active.size();
+        bool stop = false;
+
+        for (uint32_t active : m_active) {
+            // The words left and right only get cells from the edge bits
+            size_t first = active - m_stride - (m_frontier[active] & 1);
+            size_t last  = active - m_stride + (m_frontier[active] >> 63);
+
+            for (int row = 0; row < 3; ++row, first += m_stride, last += m_stride) {
+                for (size_t word = first; word <= last; ++word) {
+                    if (m_seen[word] == m_stamp)
+                        continue;
+                    m_seen[word] = m_stamp;
+
+                    uint64_t open = ~obstacles[word] & ~m_visited[word];
+                    if (!open)
+                        continue;
+                    uint64_t cells = reach(obstacles, word) & open;
+                    if (!cells)
+                        continue;
+
+                    m_next[word] = cells;
+                    m_visited[word] |= cells;
+                    m_nextActive.push_back(static_cast<uint32_t>(word));
+                    stop = onLevel(level, word, cells) || stop;
+                }
+            }
+        }
+
+        for (uint32_t word : m_active) {
+            m_frontier[word] = 0;
+        }
+        std::swap(m_frontier, m_next);
+        m_active.swap(m_nextActive);
+        m_levels = level;
+        if (stop)
+            return;
+    }
+}
+
+bool BitBfs::reachable(const NodeGrid& grid, NodeId start, NodeId goal) {
+    if (grid.isObstacle(start) || grid.isObstacle(goal))
+        return false;
+
+    begin(grid);
+    size_t goalWord = wordOf(goal);
+    uint64_t goalBit = bitOf(goal, m_columns);
+    bool found = false;
+
+    search(grid, { start }, UNREACHED, [&](uint32_t, size_t word, uint64_t cells) {
+        found = found || (word == goalWord && (cells & goalBit));
+        return found;
+    });
+    return found;
+}
+
+size_t BitBfs::floodFill(const NodeGrid& grid, const std::vector<NodeId>& sources, uint32_t maxHops) {
+    begin(grid);
+    size_t count = 0;
+    search(grid, sources, maxHops, [&](uint32_t, size_t, uint64_t cells) {
+        count += __builtin_popcountll(cells);
+        return false;
+    });
+    return count;
+}
+
+size_t BitBfs::hopDistances(const NodeGrid& grid, const std::vector<NodeId>& sources,
+                            std::vector<uint32_t>& hops) {
+    hops.assign(grid.getTotalNodes(), UNREACHED);
+    begin(grid);
+    size_t count = 0;
+
+    search(grid, sources, UNREACHED, [&](uint32_t level, size_t word, uint64_t cells) {
+        count += __builtin_popcountll(cells);
+        // Cell of bit 0, the left border in a row's first word; unsigned
+        // NodeId arithmetic wraps it back onto the cells that are set
+        NodeId first = cellAt(word, 0);
+        while (cells) {
+            hops[first + __builtin_ctzll(cells)] = level;
+            cells &= cells - 1;
+        }
+        return false;
+    });
+    return count;
+}
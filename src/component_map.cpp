@@ -0,0 +1,351 @@
+#include "component_map.hpp"
+#include "node_grid.hpp"
+#include "run_on_threads.hpp"
+#include <algorithm>
+#include <thread>
+
+ComponentMap::ComponentMap()
+    : m_grid(nullptr)
+    , m_rows(0)
+    , m_columns(0)
+    , m_connectivity(Connectivity::EIGHT)
+    , m_cornerRule(CornerRule::CUT_CORNERS)
+    , m_count(0)
+    , m_updatedCells(0)
+    , m_stamp(0)
+{
+}
+
+bool ComponentMap::isCurrent(const NodeGrid& grid) const {
+    return m_grid == &grid && m_rows == grid.getRows() && m_columns == grid.getColumns() &&
+           m_connectivity == grid.getConnectivity() && m_cornerRule == grid.getCornerRule();
+}
+
+void ComponentMap::rebuild(const NodeGrid& grid, unsigned numThreads) {
+    m_grid         = &grid;
+    m_rows         = grid.getRows();
+    m_columns      = grid.getColumns();
+    m_connectivity = grid.getConnectivity();
+    m_cornerRule   = grid.getCornerRule();
+
+    size_t numNodes = grid.getTotalNodes();
+    m_label.assign(numNodes, NO_COMPONENT);
+    m_sizes.clear();
+    m_freeLabels.clear();
+    m_visitStamp.clear();
+    m_visitOwner.clear();
+    m_stamp = 0;
+    m_count = 0;
+    m_updatedCells = 0;
+
+    if (numNodes == 0)
+        return;
+
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::max(1u, std::min(numThreads, static_cast<unsigned>(m_rows)));
+
+    // Union-find forest, each tree rooted at its smallest cell
+    std::vector<NodeId> parent(numNodes);
+    auto find = [&](NodeId nid) {
+        while (parent[nid] != nid) {
+            parent[nid] = parent[parent[nid]];
+            nid = parent[nid];
+        }
+        return nid;
+    };
+    auto unite = [&](NodeId a, NodeId b) {
+        a = find(a);
+        b = find(b);
+        if (a < b)
+            parent[b] = a;
+        else if (b < a)
+            parent[a] = b;
+    };
+    auto stripBegin = [&](unsigned strip) {
+        return static_cast<NodeId>(static_cast<size_t>(m_rows) * strip / numThreads * m_columns);
+    };
+
+    // Moves within a strip of rows only touch its own trees
+    runOnThreads(numThreads, [&](unsigned strip) {
+        NodeId begin = stripBegin(strip), end = stripBegin(strip + 1);
+
+        for (NodeId nid = begin; nid < end; ++nid) {
+            if (grid.isObstacle(nid)) {
+                parent[nid] = INVALID_NODE;
+                continue;
+            }
+            parent[nid] = nid;
+            grid.forEachNeighbor(nid, [&](NodeId adj, Direction) {
+                if (adj < nid && adj >= begin)
+                    unite(nid, adj);
+            });
+        }
+    });
+
+    // Moves across the seams between strips
+    for (unsigned strip = 1; strip < numThreads; ++strip) {
+        NodeId begin = stripBegin(strip);
+
+        for (NodeId nid = begin; nid < begin + static_cast<NodeId>(m_columns); ++nid) {
+            grid.forEachNeighbor(nid, [&](NodeId adj, Direction) {
+                if (adj < begin)
+                    unite(nid, adj);
+            });
+        }
+    }
+
+    // Roots are numbered in cell order, then every cell reads its root's
+    // label without compressing paths, so the strips share nothing
+    for (NodeId nid = 0; nid < numNodes; ++nid) {
+        if (parent[nid] == nid)
+            m_label[nid] = static_cast<uint32_t>(m_count++);
+    }
+    runOnThreads(numThreads, [&](unsigned strip) {
+        NodeId begin = stripBegin(strip), end = stripBegin(strip + 1);
+
+        for (NodeId nid = begin; nid < end; ++nid) {
+            NodeId root = parent[nid];
+            if (root == INVALID_NODE || root == nid)
+                continue;
+            while (parent[root] != root) {
+                root = parent[root];
+            }
+            m_label[nid] = m_label[root];
+        }
+    });
+
+    m_sizes.assign(m_count, 0);
+    for (uint32_t label : m_label) {
+        if (label != NO_COMPONENT) {
+            ++m_sizes[label];
+            ++m_updatedCells;
+        }
+    }
+}
+
+uint32_t ComponentMap::largestComponent() const {
+    auto largest = std::max_element(m_sizes.begin(), m_sizes.end());
+    if (largest == m_sizes.end() || *largest == 0)
+        return NO_COMPONENT;
+    return static_cast<uint32_t>(largest - m_sizes.begin());
+}
+
+std::vector<uint32_t> ComponentMap::componentSizes() const {
+    std::vector<uint32_t> sizes;
+    sizes.reserve(m_count);
+    for (uint32_t size : m_sizes) {
+        if (size)
+            sizes.push_back(size);
+    }
+    std::sort(sizes.begin(), sizes.end(), [](uint32_t a, uint32_t b) { return a > b; });
+    return sizes;
+}
+
+uint32_t ComponentMap::newLabel() {
+    ++m_count;
+    if (!m_freeLabels.empty()) {
+        uint32_t label = m_freeLabels.back();
+        m_freeLabels.pop_back();
+        return label;
+    }
+    m_sizes.push_back(0);
+    return static_cast<uint32_t>(m_sizes.size() - 1);
+}
+
+void ComponentMap::freeLabel(uint32_t label) {
+    --m_count;
+    m_sizes[label] = 0;
+    m_freeLabels.push_back(label);
+}
+
+NodeId ComponentMap::neighborAt(NodeId nid, int dir) const {
+    int x = static_cast<int>(nid % m_columns) + DIR_DX[dir];
+    int y = static_cast<int>(nid / m_columns) + DIR_DY[dir];
+
+    if (x < 0 || y < 0 || x >= m_columns || y >= m_rows)
+        return INVALID_NODE;
+    return static_cast<NodeId>(y * m_columns + x);
+}
+
+void ComponentMap::relabel(NodeId nid, uint32_t from, uint32_t to) {
+    m_queue.clear();
+    m_label[nid] = to;
+    m_queue.push_back(nid);
+
+    for (size_t head = 0; head < m_queue.size(); ++head) {
+        m_grid->forEachNeighbor(m_queue[head], [&](NodeId adj, Direction) {
+            if (m_label[adj] == from) {
+                m_label[adj] = to;
+                m_queue.push_back(adj);
+            }
+        });
+    }
+
+    m_sizes[to] += m_sizes[from];
+    m_updatedCells += m_sizes[from];
+    freeLabel(from);
+}
+
+void ComponentMap::join(NodeId a, NodeId b) {
+    if (m_sizes[m_label[a]] < m_sizes[m_label[b]])
+        std::swap(a, b);
+    relabel(b, m_label[b], m_label[a]);
+}
+
+void ComponentMap::split(uint32_t label, const std::vector<NodeId>& seeds) {
+    if (m_visitStamp.size() != m_label.size() || ++m_stamp == 0) {
+        m_visitStamp.assign(m_label.size(), 0);
+        m_visitOwner.resize(m_label.size());
+        m_stamp = 1;
+    }
+
+    // One breadth-first search per seed; the cells it reached double as
+    // its queue. Searches that meet are merged into one group.
+    size_t numSeeds = seeds.size();
+    std::vector<std::vector<NodeId>> reached(numSeeds);
+    std::vector<size_t> head(numSeeds, 0);
+    std::vector<uint32_t> group(numSeeds), active(numSeeds, 1);
+    size_t openGroups = numSeeds;
+
+    for (uint32_t i = 0; i < numSeeds; ++i) {
+        group[i] = i;
+        m_visitStamp[seeds[i]] = m_stamp;
+        m_visitOwner[seeds[i]] = i;
+        reached[i].push_back(seeds[i]);
+    }
+
+    auto findGroup = [&](uint32_t i) {
+        while (group[i] != i) {
+            group[i] = group[group[i]];
+            i = group[i];
+        }
+        return i;
+    };
+    auto meet = [&](uint32_t a, uint32_t b) {
+        a = findGroup(a);
+        b = findGroup(b);
+        if (a != b) {
+            group[b] = a;
+            active[a] += active[b];
+            --openGroups;
+        }
+    };
+
+    while (openGroups > 1) {
+        for (uint32_t i = 0; i < numSeeds && openGroups > 1; ++i) {
+            if (head[i] == reached[i].size())
+                continue;
+
+            m_grid->forEachNeighbor(reached[i][head[i]++], [&](NodeId adj, Direction) {
+                if (m_label[adj] != label)
+                    return;
+                if (m_visitStamp[adj] != m_stamp) {
+                    m_visitStamp[adj] = m_stamp;
+                    m_visitOwner[adj] = i;
+                    reached[i].push_back(adj);
+                }
+                else {
+                    meet(i, m_visitOwner[adj]);
+                }
+            });
+
+            // A group whose searches all ran dry holds a whole region
+            uint32_t g = findGroup(i);
+            if (head[i] < reached[i].size() || --active[g] > 0)
+                continue;
+
+            uint32_t part = newLabel();
+            for (uint32_t j = 0; j < numSeeds; ++j) {
+                if (findGroup(j) != g)
+                    continue;
+                for (NodeId nid : reached[j]) {
+                    m_label[nid] = part;
+                }
+                m_sizes[part] += static_cast<uint32_t>(reached[j].size());
+            }
+            m_sizes[label] -= m_sizes[part];
+            m_updatedCells += m_sizes[part];
+            --openGroups;
+        }
+    }
+}
+
+void ComponentMap::onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    if (!isCurrent(grid)) {
+        rebuild(grid);
+        return;
+    }
+    m_updatedCells = 0;
+
+    // Blocked cells leave their regions first, so the seeds below are
+    // only cells that stay free
+    for (NodeId nid : cells) {
+        uint32_t label = m_label[nid];
+        if (!grid.isObstacle(nid) || label == NO_COMPONENT)
+            continue;
+
+        m_label[nid] = NO_COMPONENT;
+        if (--m_sizes[label] == 0)
+            freeLabel(label);
+    }
+
+    // Every move a blocked cell took away ran between cells around it, so
+    // any part cut off holds one of them
+    std::vector<std::pair<uint32_t, NodeId>> seeds;
+    for (NodeId nid : cells) {
+        if (!grid.isObstacle(nid))
+            continue;
+        for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+            NodeId adj = neighborAt(nid, dir);
+            if (adj != INVALID_NODE && m_label[adj] != NO_COMPONENT)
+                seeds.emplace_back(m_label[adj], adj);
+        }
+    }
+    std::sort(seeds.begin(), seeds.end());
+    seeds.erase(std::unique(seeds.begin(), seeds.end()), seeds.end());
+
+    std::vector<NodeId> group;
+    for (size_t i = 0; i < seeds.size();) {
+        group.clear();
+        size_t j = i;
+        for (; j < seeds.size() && seeds[j].first == seeds[i].first; ++j) {
+            group.push_back(seeds[j].second);
+        }
+        if (group.size() > 1)
+            split(seeds[i].first, group);
+        i = j;
+    }
+
+    // Opened cells start as regions of their own and join every region
+    // they, or the diagonals across them, now reach
+    for (NodeId nid : cells) {
+        if (grid.isObstacle(nid) || m_label[nid] != NO_COMPONENT)
+            continue;
+
+        uint32_t label = newLabel();
+        m_label[nid] = label;
+        m_sizes[label] = 1;
+        ++m_updatedCells;
+    }
+    for (NodeId nid : cells) {
+        if (grid.isObstacle(nid))
+            continue;
+
+        for (int dir = -1; dir < NUM_DIRECTIONS; ++dir) {
+            NodeId cell = (dir < 0) ? nid : neighborAt(nid, dir);
+            if (cell == INVALID_NODE || m_label[cell] == NO_COMPONENT)
+                continue;
+
+            grid.forEachNeighbor(cell, [&](NodeId adj, Direction) {
+                if (m_label[adj] != m_label[cell])
+                    join(cell, adj);
+            });
+        }
+    }
+}
+
+void ComponentMap::onMapReset(const NodeGrid& grid) {
+    if (m_grid)
+        rebuild(grid);
+}
@@ -0,0 +1,215 @@
+#include "dstar_lite.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+static Cost addCost(Cost a, Cost b) {
+    return (a == COST_INFINITY || b == COST_INFINITY) ? COST_INFINITY : a + b;
+}
+
+DStarLite::DStarLite()
+    : m_grid(nullptr)
+    , m_connectivity(Connectivity::EIGHT)
+    , m_cornerRule(CornerRule::CUT_CORNERS)
+    , m_minTerrain(TERRAIN_PLAIN)
+    , m_stale(true)
+    , m_start(INVALID_NODE)
+    , m_goal(INVALID_NODE)
+    , m_km(0)
+    , m_pathCost(COST_INFINITY)
+{
+}
+
+void DStarLite::initialize(NodeId start, NodeId goal) {
+    size_t numNodes = m_grid->getTotalNodes();
+
+    m_connectivity = m_grid->getConnectivity();
+    m_cornerRule   = m_grid->getCornerRule();
+    m_minTerrain   = m_grid->getMinTerrain();
+    m_stale = false;
+    m_start = start;
+    m_goal  = goal;
+    m_km    = 0;
+
+    m_g.assign(numNodes, COST_INFINITY);
+    m_rhs.assign(numNodes, COST_INFINITY);
+    m_queue.resize(numNodes);
+
+    m_rhs[goal] = 0;
+    m_queue.push(goal, key(goal), 0);
+}
+
+uint64_t DStarLite::key(NodeId nid) const {
+    Cost best = std::min(m_g[nid], m_rhs[nid]);
+    if (best == COST_INFINITY)
+        return UINT64_MAX;
+
+    uint64_t primary = uint64_t(best) + m_grid->heuristicCost(m_start, nid) + m_km;
+    return (std::min<uint64_t>(primary, UINT32_MAX) << 32) | best;
+}
+
+Cost DStarLite::lookahead(NodeId nid) const {
+    Cost best = COST_INFINITY;
+    m_grid->forEachNeighbor(nid, [&](NodeId adj, Direction dir) {
+        best = std::min(best, addCost(m_grid->stepCost(nid, adj, dir), m_g[adj]));
+    });
+    return best;
+}
+
+void DStarLite::updateVertex(NodeId nid) {
+    bool queued = m_queue.contains(nid);
+
+    if (m_g[nid] != m_rhs[nid]) {
+        if (queued)
+            m_queue.update(nid, key(nid));
+        else
+            m_queue.push(nid, key(nid), 0);
+    }
+    else if (queued) {
+        m_queue.remove(nid);
+    }
+}
+
+void DStarLite::computeShortestPath(SearchStats& stats, std::deque<TraceEntry>& trace) {
+    while (!m_queue.empty() &&
+           (m_queue.topKey() < key(m_start) || m_rhs[m_start] > m_g[m_start])) {
+        NodeId current = m_queue.top();
+        uint64_t oldKey = m_queue.topKey();
+        uint64_t newKey = key(current);
+        ++stats.pops;
+
+        // Queued before the start moved: requeue under its current key
+        if (oldKey < newKey) {
+            m_queue.update(current, newKey);
+            continue;
+        }
+
+        ++stats.expansions;
+        trace.push_back(TraceEntry{ current, INVALID_NODE, Frontier::BACKWARD });
+
+        if (m_g[current] > m_rhs[current]) {
+            // Overconsistent: settle and offer the new distance to the neighbors
+            m_g[current] = m_rhs[current];
+            m_queue.remove(current);
+
+            m_grid->forEachNeighbor(current, [&](NodeId adj, Direction dir) {
+                Cost viaCurrent = m_g[current] + m_grid->stepCost(current, adj, dir);
+                if (adj != m_goal && viaCurrent < m_rhs[adj]) {
+                    m_rhs[adj] = viaCurrent;
+                    updateVertex(adj);
+                    ++stats.pushes;
+                }
+            });
+        }
+        else {
+            // Underconsistent: forget g, then every neighbor that relied on
+            // it looks for another way
+            Cost oldG = m_g[current];
+            m_g[current] = COST_INFINITY;
+
+            m_grid->forEachNeighbor(current, [&](NodeId adj, Direction dir) {
+                if (adj != m_goal && m_rhs[adj] == addCost(m_grid->stepCost(current, adj, dir), oldG)) {
+                    m_rhs[adj] = lookahead(adj);
+                    updateVertex(adj);
+                    ++stats.pushes;
+                }
+            });
+            if (current != m_goal)
+                m_rhs[current] = lookahead(current);
+            updateVertex(current);
+        }
+
+        stats.maxOpenSize = std::max(stats.maxOpenSize, m_queue.size());
+    }
+}
+
+bool DStarLite::plan(const NodeGrid& grid, NodeId start, NodeId goal, SearchStats& stats,
+                     std::deque<TraceEntry>& trace) {
+    if (m_grid != &grid || m_stale || goal != m_goal ||
+        grid.getConnectivity() != m_connectivity || grid.getCornerRule() != m_cornerRule ||
+        grid.getMinTerrain() != m_minTerrain) {
+        m_grid = &grid;
+        initialize(start, goal);
+    }
+    else if (start != m_start) {
+        // Every queued key is now too high by at most h(old, new)
+        m_km += grid.heuristicCost(m_start, start);
+        m_start = start;
+    }
+
+    computeShortestPath(stats, trace);
+
+    m_pathCost = m_rhs[m_start];
+    return m_pathCost != COST_INFINITY;
+}
+
+void DStarLite::buildPath(std::vector<NodeId>& path) const {
+    if (m_pathCost == COST_INFINITY)
+        return;
+
+    // Greedy descent on step + g from the start, one cell at a time
+    std::vector<NodeId> forward{ m_start };
+    NodeId current = m_start;
+
+    while (current != m_goal && forward.size() <= m_g.size()) {
+        NodeId next = INVALID_NODE;
+        Cost best = COST_INFINITY;
+
+        m_grid->forEachNeighbor(current, [&](NodeId adj, Direction dir) {
+            Cost viaAdj = addCost(m_grid->stepCost(current, adj, dir), m_g[adj]);
+            if (viaAdj < best) {
+                best = viaAdj;
+                next = adj;
+            }
+        });
+        if (next == INVALID_NODE)
+            return;
+
+        forward.push_back(next);
+        current = next;
+    }
+
+    path.insert(path.end(), forward.rbegin(), forward.rend());
+}
+
+void DStarLite::onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    if (m_stale || m_grid != &grid)
+        return;
+
+    // Large batches change most of the tree anyway
+    if (cells.size() > m_g.size() / 64) {
+        m_stale = true;
+        return;
+    }
+
+    // A flipped cell changes its own moves, the moves of its neighbors into
+    // it and, under the corner rules, diagonals between its neighbors, so
+    // those cells' lookahead is recomputed
+    for (NodeId nid : cells) {
+        int cell_x = grid.x(nid);
+        int cell_y = grid.y(nid);
+
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                int nx = cell_x + dx;
+                int ny = cell_y + dy;
+                if (nx < 0 || ny < 0 || nx >= grid.getColumns() || ny >= grid.getRows())
+                    continue;
+
+                NodeId adj = grid.nodeAt(nx, ny);
+                if (adj != m_goal) {
+                    m_rhs[adj] = lookahead(adj);
+                    updateVertex(adj);
+                }
+            }
+        }
+    }
+}
+
+void DStarLite::onTerrainChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    // A cell's multiplier weighs its own moves and its neighbors' into it
+    onObstaclesChanged(grid, cells);
+}
+
+void DStarLite::onMapReset(const NodeGrid&) {
+    m_stale = true;
+}
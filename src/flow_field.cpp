@@ -0,0 +1,225 @@
+#include "flow_field.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+static Direction opposite(int dir) {
+    return stepDirection(-DIR_DX[dir], -DIR_DY[dir]);
+}
+
+// Field steps per terrain multiplier of each cell of a move
+static constexpr uint32_t HALF_STEP[NUM_DIRECTIONS] = {
+    FlowField::STEP_STRAIGHT / 2, FlowField::STEP_STRAIGHT / 2,
+    FlowField::STEP_STRAIGHT / 2, FlowField::STEP_STRAIGHT / 2,
+    FlowField::STEP_DIAGONAL / 2, FlowField::STEP_DIAGONAL / 2,
+    FlowField::STEP_DIAGONAL / 2, FlowField::STEP_DIAGONAL / 2,
+};
+
+FlowField::FlowField()
+    : m_grid(nullptr)
+    , m_rows(0)
+    , m_columns(0)
+    , m_connectivity(Connectivity::EIGHT)
+    , m_cornerRule(CornerRule::CUT_CORNERS)
+    , m_dirOffset()
+    , m_goal(INVALID_NODE)
+    , m_updatedCells(0)
+{
+}
+
+bool FlowField::isCurrent(const NodeGrid& grid) const {
+    return m_grid == &grid && m_rows == grid.getRows() && m_columns == grid.getColumns() &&
+           m_connectivity == grid.getConnectivity() && m_cornerRule == grid.getCornerRule();
+}
+
+void FlowField::rebuild(const NodeGrid& grid, NodeId goal) {
+    m_grid         = &grid;
+    m_rows         = grid.getRows();
+    m_columns      = grid.getColumns();
+    m_connectivity = grid.getConnectivity();
+    m_cornerRule   = grid.getCornerRule();
+    m_goal         = goal;
+
+    for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+        m_dirOffset[dir] = DIR_DY[dir] * m_columns + DIR_DX[dir];
+    }
+
+    size_t numNodes = grid.getTotalNodes();
+    m_dist.assign(numNodes, UNREACHABLE);
+    m_dirs.assign((numNodes + DIRS_PER_WORD - 1) / DIRS_PER_WORD, 0);
+    m_updatedCells = 0;
+
+    std::vector<std::pair<uint16_t, NodeId>> sources;
+    if (goal < numNodes && !grid.isObstacle(goal)) {
+        m_dist[goal] = 0;
+        ++m_updatedCells;
+        sources.emplace_back(0, goal);
+    }
+    propagate(sources);
+}
+
+NodeId FlowField::neighborAt(NodeId nid, int dir) const {
+    int x = static_cast<int>(nid % m_columns) + DIR_DX[dir];
+    int y = static_cast<int>(nid / m_columns) + DIR_DY[dir];
+
+    if (x < 0 || y < 0 || x >= m_columns || y >= m_rows)
+        return INVALID_NODE;
+    return nid + m_dirOffset[dir];
+}
+
+void FlowField::invalidate(NodeId nid) {
+    if (m_dist[nid] == UNREACHABLE || nid == m_goal)
+        return;
+
+    m_dist[nid] = UNREACHABLE;
+    size_t head = m_invalid.size();
+    m_invalid.push_back(nid);
+
+    // Everything stepping into an invalid cell routed through it
+    while (head < m_invalid.size()) {
+        NodeId current = m_invalid[head++];
+
+        for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+            NodeId adj = neighborAt(current, dir);
+            if (adj == INVALID_NODE || m_dist[adj] == UNREACHABLE || adj == m_goal ||
+                direction(adj) != opposite(dir))
+                continue;
+
+            m_dist[adj] = UNREACHABLE;
+            m_invalid.push_back(adj);
+        }
+    }
+}
+
+void FlowField::propagate(std::vector<std::pair<uint16_t, NodeId>>& sources) {
+    std::sort(sources.begin(), sources.end());
+    sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+
+    const uint8_t* terrain = m_grid->getTerrainData();
+    size_t numBuckets = 16;
+    while (numBuckets <= 2 * HALF_STEP[DIR_SOUTH_EAST] * m_grid->getMaxTerrain()) {
+        numBuckets *= 2;
+    }
+    m_buckets.resize(numBuckets);
+    for (auto& bucket : m_buckets) {
+        bucket.clear();
+    }
+    size_t ring = numBuckets - 1;
+
+    size_t queued = 0;
+    auto expand = [&](NodeId nid, uint32_t dist) {
+        m_grid->forEachNeighbor(nid, [&](NodeId adj, Direction dir) {
+            uint32_t step = terrain ? HALF_STEP[dir] * (uint32_t(terrain[nid]) + terrain[adj])
+                                    : ((dir < DIR_SOUTH_EAST) ? STEP_STRAIGHT : STEP_DIAGONAL);
+            uint32_t viaNid = dist + step;
+            if (viaNid >= m_dist[adj] || viaNid > MAX_DISTANCE)
+                return;
+
+            m_dist[adj] = static_cast<uint16_t>(viaNid);
+            setDirection(adj, opposite(dir));
+            m_buckets[viaNid & ring].push_back(adj);
+            ++queued;
+            ++m_updatedCells;
+        });
+    };
+
+    // Entries are left behind when a cell is lowered again; they no
+    // longer match its distance when their bucket comes up
+    size_t next = 0;
+    uint32_t cursor = 0;
+    while (queued > 0 || next < sources.size()) {
+        if (queued == 0)
+            cursor = sources[next].first;
+
+        for (; next < sources.size() && sources[next].first == cursor; ++next) {
+            if (m_dist[sources[next].second] == cursor)
+                expand(sources[next].second, cursor);
+        }
+
+        auto& bucket = m_buckets[cursor & ring];
+        while (!bucket.empty()) {
+            NodeId nid = bucket.back();
+            bucket.pop_back();
+            --queued;
+
+            if (m_dist[nid] == cursor)
+                expand(nid, cursor);
+        }
+        ++cursor;
+    }
+}
+
+void FlowField::onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    if (m_goal == INVALID_NODE)
+        return;
+    if (!isCurrent(grid) || std::binary_search(cells.begin(), cells.end(), m_goal)) {
+        rebuild(grid, m_goal);
+        return;
+    }
+
+    m_invalid.clear();
+    m_updatedCells = 0;
+
+    // Blocked cells, and cells whose step is no longer a move, e.g. a
+    // diagonal past a cell blocked under no corner cutting
+    for (NodeId nid : cells) {
+        if (grid.isObstacle(nid))
+            invalidate(nid);
+    }
+    for (NodeId nid : cells) {
+        for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+            NodeId adj = neighborAt(nid, dir);
+            if (adj != INVALID_NODE && m_dist[adj] != UNREACHABLE && adj != m_goal &&
+                !(grid.freeNeighbors(adj) & (1u << direction(adj))))
+                invalidate(adj);
+        }
+    }
+
+    // Next to an opened cell every valid cell may have new moves,
+    // diagonals across it included, so they all propagate again
+    std::vector<std::pair<uint16_t, NodeId>> sources;
+    for (NodeId nid : cells) {
+        if (grid.isObstacle(nid))
+            continue;
+        for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+            NodeId adj = neighborAt(nid, dir);
+            if (adj != INVALID_NODE && m_dist[adj] != UNREACHABLE)
+                sources.emplace_back(m_dist[adj], adj);
+        }
+    }
+    refill(sources);
+}
+
+void FlowField::onTerrainChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    if (m_goal == INVALID_NODE)
+        return;
+    if (!isCurrent(grid) || std::binary_search(cells.begin(), cells.end(), m_goal)) {
+        rebuild(grid, m_goal);
+        return;
+    }
+
+    m_invalid.clear();
+    m_updatedCells = 0;
+
+    // Every move into or out of a changed cell costs something else now.
+    // Once refilled, a cheaper cell lowers the cells around it in turn.
+    for (NodeId nid : cells) {
+        invalidate(nid);
+    }
+    std::vector<std::pair<uint16_t, NodeId>> sources;
+    refill(sources);
+}
+
+void FlowField::refill(std::vector<std::pair<uint16_t, NodeId>>& sources) {
+    for (NodeId nid : m_invalid) {
+        m_grid->forEachNeighbor(nid, [&](NodeId adj, Direction) {
+            if (m_dist[adj] != UNREACHABLE)
+                sources.emplace_back(m_dist[adj], adj);
+        });
+    }
+    propagate(sources);
+}
+
+void FlowField::onMapReset(const NodeGrid& grid) {
+    if (m_goal != INVALID_NODE)
+        rebuild(grid, m_goal);
+}
@@ -0,0 +1,173 @@
+#include "fringe_solver.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+FringeSolver::FringeSolver()
+    : m_capacity(0)
+    , m_sentinel(0)
+    , m_query(0)
+    , m_size(0)
+    , m_maxSize(0)
+    , m_outOfMemory(false)
+    , m_iterations(0)
+    , m_goal(INVALID_NODE)
+    , m_pathCost(COST_INFINITY)
+{
+}
+
+uint32_t FringeSolver::slotOf(NodeId nid) const {
+    // Fibonacci hashing scaled to the capacity, so rows and columns spread
+    // evenly over a table of any size
+    uint32_t slot = static_cast<uint32_t>((uint64_t(nid * 2654435769u) * m_capacity) >> 32);
+    while (m_table[slot].query == m_query && m_table[slot].nid != nid) {
+        if (++slot == m_capacity)
+            slot = 0;
+    }
+    return slot;
+}
+
+void FringeSolver::insertAfter(uint32_t pos, uint32_t slot) {
+    uint32_t next = m_table[pos].next;
+    m_table[slot].next = next;
+    m_table[slot].prev = pos;
+    m_table[next].prev = slot;
+    m_table[pos].next = slot;
+}
+
+void FringeSolver::unlink(uint32_t slot) {
+    m_table[m_table[slot].prev].next = m_table[slot].next;
+    m_table[m_table[slot].next].prev = m_table[slot].prev;
+}
+
+bool FringeSolver::solve(const NodeGrid& grid, NodeId start, NodeId goal, size_t tableBytes,
+                         size_t traceLimit, SearchStats& stats, std::deque<TraceEntry>& trace) {
+    // As many entries as fit, but no more than every cell needs
+    size_t numNodes = grid.getTotalNodes();
+    size_t capacity = std::min(tableBytes / sizeof(Entry), numNodes + numNodes / 3 + 2);
+    capacity = std::min<size_t>(std::max<size_t>(capacity, 3) - 1, UINT32_MAX - 1);
+
+    if (m_capacity != capacity) {
+        m_capacity = static_cast<uint32_t>(capacity);
+        m_table.assign(m_capacity + 1, Entry{ INVALID_NODE, 0, 0, INVALID_NODE, NONE, NONE, 0 });
+        m_sentinel = m_capacity;
+        m_query = 0;
+    }
+    if (m_query == UINT32_MAX) {
+        for (Entry& entry : m_table) {
+            entry.query = 0;
+        }
+        m_query = 0;
+    }
+    ++m_query;
+
+    m_size = 0;
+    m_maxSize = std::max<uint32_t>(1, m_capacity / 4 * 3);
+    m_table[m_sentinel].next = m_table[m_sentinel].prev = m_sentinel;
+    m_outOfMemory = false;
+    m_iterations = 0;
+    m_goal = goal;
+    m_pathCost = COST_INFINITY;
+
+    if (grid.isObstacle(start))
+        return false;
+
+    uint32_t startSlot = slotOf(start);
+    m_table[startSlot] = Entry{ start, 0, grid.heuristicCost(start, goal), INVALID_NODE, NONE, NONE,
+                                m_query };
+    insertAfter(m_sentinel, startSlot);
+    ++m_size;
+    ++stats.pushes;
+
+    Cost limit = m_table[startSlot].h;
+    size_t fringeSize = 1;
+    size_t recorded = 0;
+
+    while (m_table[m_sentinel].next != m_sentinel) {
+        ++m_iterations;
+        Cost nextLimit = COST_INFINITY;
+        uint32_t current = m_table[m_sentinel].next;
+
+        while (current != m_sentinel) {
+            ++stats.pops;
+            NodeId nid = m_table[current].nid;
+            Cost g = m_table[current].g;
+            Cost f = g + m_table[current].h;
+
+            // Left in place for a later iteration
+            if (f > limit) {
+                nextLimit = std::min(nextLimit, f);
+                current = m_table[current].next;
+                continue;
+            }
+
+            // f <= limit <= optimal cost, so the first visit is optimal
+            if (nid == goal) {
+                m_pathCost = g;
+                return true;
+            }
+
+            ++stats.expansions;
+            if (recorded < traceLimit) {
+                trace.push_back(TraceEntry{ nid, m_table[current].parent, Frontier::FORWARD });
+                ++recorded;
+            }
+
+            // Children go right behind current, so this iteration still
+            // visits the ones within the limit
+            grid.forEachNeighbor(nid, [&](NodeId adj, Direction dir) {
+                Cost viaCurrent = g + grid.stepCost(nid, adj, dir);
+                uint32_t slot = slotOf(adj);
+                Entry& entry = m_table[slot];
+
+                if (entry.query != m_query) {
+                    if (m_size == m_maxSize) {
+                        m_outOfMemory = true;
+                        return;
+                    }
+                    entry = Entry{ adj, viaCurrent, grid.heuristicCost(adj, goal), nid, NONE, NONE,
+                                   m_query };
+                    ++m_size;
+                    ++fringeSize;
+                }
+                else if (viaCurrent >= entry.g) {
+                    return;
+                }
+                else if (entry.prev != NONE) {
+                    unlink(slot);
+                    entry.g = viaCurrent;
+                    entry.parent = nid;
+                    ++stats.decreaseKeys;
+                }
+                else {
+                    // Expanded too early, reopened with the cheaper g
+                    entry.g = viaCurrent;
+                    entry.parent = nid;
+                    ++fringeSize;
+                }
+
+                insertAfter(current, slot);
+                ++stats.pushes;
+            });
+            if (m_outOfMemory)
+                return false;
+
+            uint32_t next = m_table[current].next;
+            unlink(current);
+            m_table[current].prev = NONE;
+            --fringeSize;
+            stats.maxOpenSize = std::max(stats.maxOpenSize, fringeSize);
+            current = next;
+        }
+        limit = nextLimit;
+    }
+    return false;
+}
+
+void FringeSolver::buildPath(std::vector<NodeId>& path) const {
+    if (m_pathCost == COST_INFINITY)
+        return;
+
+    for (NodeId nid = m_goal; nid != INVALID_NODE; nid = m_table[slotOf(nid)].parent) {
+        path.push_back(nid);
+    }
+}
@@ -1,5 +1,9 @@
 
 #include "game_engine.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 
 GameEngine::GameEngine(int rows, int cols)
     : m_rows(rows)
@@ -7,7 +11,8 @@ GameEngine::GameEngine(int rows, int cols)
     , m_NodeGrid(rows, cols)
     , m_totalFrames(0)
     , m_frameCount(0)
-    , m_nodePtr(nullptr)
+    , m_isAnimating(false)
+    , m_showFlowField(false)
 {
     // Game Engine Consttructor
     sAppName = "A* algorithm demo";
@@ -34,26 +39,57 @@ bool GameEngine::OnUserUpdate(float fElapsedTime) {
         if      (GetKey(olc::Key::SHIFT).bHeld) { m_NodeGrid.setStartNode(nid); }
         else if (GetKey(olc::Key::CTRL ).bHeld) { m_NodeGrid.setEndNode(nid); }
         else {
-            auto pNode = m_NodeGrid.getNodes()[nid];
-            if (!pNode->isStartNode() && !pNode->isEndNode()) {
-                m_NodeGrid.getNodes()[nid]->toggleObstacle();
-            } 
+            if (!m_NodeGrid.isStartNode(nid) && !m_NodeGrid.isEndNode(nid)) {
+                m_NodeGrid.toggleObstacle(nid);
+            }
         }
 
         Clear(getPixelColor(BACKGROUND));
-        m_NodeGrid.updateNodeAdjacency();
+        m_NodeGrid.resetSearch();
         // m_NodeGrid.solvePath();
         DrawNodeGrid();
-        m_nodePtr = nullptr;
+        m_isAnimating = false;
+
+        // D* Lite only repairs its last search, cheap enough to replan live
+        if (m_NodeGrid.getSolverType() == SolverType::DSTAR_LITE)
+            replanLive();
+    }
+
+    if (GetMouse(1).bReleased) {
+        // Toggles mud, which costs MUD_TERRAIN times as much to cross
+        int nid = selectedNodeY * m_cols + selectedNodeX;
+        bool isMud = m_NodeGrid.getTerrain(nid) != TERRAIN_PLAIN;
+        m_NodeGrid.setTerrain(nid, isMud ? TERRAIN_PLAIN : MUD_TERRAIN);
+        printf("Terrain of [%d] : %d\n", nid, m_NodeGrid.getTerrain(nid));
+
+        Clear(getPixelColor(BACKGROUND));
+        m_NodeGrid.resetSearch();
+        DrawNodeGrid();
+        m_isAnimating = false;
+
+        if (m_NodeGrid.getSolverType() == SolverType::DSTAR_LITE)
+            replanLive();
+    }
+
+    if (GetKey(olc::Key::N).bReleased) {
+        // Walk the start node one cell along the current path and replan
+        const auto& path = m_NodeGrid.getShortestPath();
+        if (path.size() >= 2) {
+            m_NodeGrid.setStartNode(path[path.size() - 2]);
+            Clear(getPixelColor(BACKGROUND));
+            m_NodeGrid.resetSearch();
+            DrawNodeGrid();
+            replanLive();
+        }
     }
 
     if (GetKey(olc::Key::SPACE).bReleased) {
         Clear(getPixelColor(BACKGROUND));
-        m_NodeGrid.updateNodeAdjacency();
+        m_NodeGrid.resetSearch();
         DrawNodeGrid();
 
         m_NodeGrid.solvePath();
-        m_nodePtr = m_NodeGrid.getVisitedNodes().front();
+        m_isAnimating = true;
 
         m_frameCount = 1;
         m_totalFrames = m_NodeGrid.getVisitedNodes().size();
@@ -61,40 +97,107 @@ bool GameEngine::OnUserUpdate(float fElapsedTime) {
         // DrawNodeGrid();
     }
 
+    if (GetKey(olc::Key::C).bReleased) {
+        bool isEight = m_NodeGrid.getConnectivity() == Connectivity::EIGHT;
+        m_NodeGrid.setConnectivity(isEight ? Connectivity::FOUR : Connectivity::EIGHT);
+        printf("Connectivity : %d\n", static_cast<int>(m_NodeGrid.getConnectivity()));
+
+        Clear(getPixelColor(BACKGROUND));
+        m_NodeGrid.resetSearch();
+        DrawNodeGrid();
+        m_isAnimating = false;
+    }
+
+    if (GetKey(olc::Key::TAB).bReleased) {
+        static const SolverType solvers[] = {
+            SolverType::ASTAR, SolverType::JPS, SolverType::JPS_PLUS,
+            SolverType::BIDIRECTIONAL, SolverType::HPA, SolverType::ARA,
+            SolverType::DSTAR_LITE, SolverType::FRINGE, SolverType::IDA_STAR,
+            SolverType::THETA, SolverType::LAZY_THETA, SolverType::CPD,
+        };
+        static constexpr int numSolvers = sizeof(solvers) / sizeof(solvers[0]);
+
+        int next = 0;
+        while (next < numSolvers && solvers[next] != m_NodeGrid.getSolverType()) {
+            ++next;
+        }
+        m_NodeGrid.setSolverType(solvers[(next + 1) % numSolvers]);
+        printf("Solver : %s\n", solverName(m_NodeGrid.getSolverType()));
+    }
+
+    if (GetKey(olc::Key::L).bReleased) {
+        m_NodeGrid.setUseLandmarks(!m_NodeGrid.getUseLandmarks());
+        printf("Landmark heuristic : %s\n", m_NodeGrid.getUseLandmarks() ? "on" : "off");
+    }
+
+    if (GetKey(olc::Key::A).bReleased) {
+        m_NodeGrid.setUseAdaptive(!m_NodeGrid.getUseAdaptive());
+        printf("Adaptive A* : %s\n", m_NodeGrid.getUseAdaptive() ? "on" : "off");
+    }
+
+    if (GetKey(olc::Key::G).bReleased) {
+        m_NodeGrid.setUseComponents(!m_NodeGrid.getUseComponents());
+        printf("Region check : %s\n", m_NodeGrid.getUseComponents() ? "on" : "off");
+    }
+
+    if (GetKey(olc::Key::W).bReleased) {
+        static const float weights[] = { 1.0f, 1.5f, 2.0f, 3.0f, 5.0f };
+        static constexpr int numWeights = sizeof(weights) / sizeof(weights[0]);
+
+        int next = 0;
+        while (next < numWeights && weights[next] != m_NodeGrid.getWeight()) {
+            ++next;
+        }
+        m_NodeGrid.setWeight(weights[(next + 1) % numWeights]);
+        printf("A* weight : %.1f\n", m_NodeGrid.getWeight());
+    }
+
+    if (GetKey(olc::Key::H).bReleased) {
+        int next = (static_cast<int>(m_NodeGrid.getHeuristicType()) + 1) % 4;
+        m_NodeGrid.setHeuristicType(static_cast<HeuristicType>(next));
+        printf("Heuristic : %s\n", heuristicName(m_NodeGrid.getHeuristicType()));
+    }
+
+    if (GetKey(olc::Key::K).bReleased) {
+        int next = (static_cast<int>(m_NodeGrid.getCornerRule()) + 1) % 3;
+        m_NodeGrid.setCornerRule(static_cast<CornerRule>(next));
+        printf("Corner rule : %s\n", cornerRuleName(m_NodeGrid.getCornerRule()));
+
+        Clear(getPixelColor(BACKGROUND));
+        m_NodeGrid.resetSearch();
+        DrawNodeGrid();
+        m_isAnimating = false;
+    }
+
+    if (GetKey(olc::Key::F).bReleased) {
+        m_showFlowField = !m_showFlowField;
+        printf("Flow field view : %s\n", m_showFlowField ? "on" : "off");
+
+        Clear(getPixelColor(BACKGROUND));
+        m_NodeGrid.resetSearch();
+        DrawNodeGrid();
+        m_isAnimating = false;
+    }
+
+    if (GetKey(olc::Key::P).bReleased) {
+        auto start = std::chrono::steady_clock::now();
+        const PathDatabase& database = m_NodeGrid.buildPathDatabase();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printf("Path database : %zu runs, %zu KB in %.0f ms\n", database.runCount(),
+               database.memoryBytes() / 1024, ms);
+    }
+
     if (GetKey(olc::Key::R).bReleased) {
         Clear(getPixelColor(BACKGROUND));
         m_NodeGrid.randomizeObstacles();
-        m_NodeGrid.updateNodeAdjacency();
+        m_NodeGrid.resetSearch();
         DrawNodeGrid();
     }
 
-    if (m_nodePtr != nullptr && !m_NodeGrid.getVisitedNodes().empty()) {
-        // printf("Drawing visited node [%d]\n", m_nodePtr->nid());
-        if (isLargerThanFPS) {
-            for (int fr = 0; fr < getStdDistVal(m_frameCount, 30, 11, m_totalFrames); ++fr) {
-                if (m_nodePtr != nullptr && !m_NodeGrid.getVisitedNodes().empty()) {
-                    if (m_nodePtr == m_NodeGrid.getEndNode()) {
-                        // DrawNodeGrid();
-                        DrawShortestPath();
-                    }
-                    else {
-                        DrawVisitedNode(m_nodePtr);
-                        m_NodeGrid.popFrontVisitedNode();
-                        m_nodePtr = m_NodeGrid.getVisitedNodes().front();
-                    }
-                }
-            }
-        } 
-        else {
-            DrawVisitedNode(m_nodePtr);
-            m_NodeGrid.popFrontVisitedNode();
-            m_nodePtr = m_NodeGrid.getVisitedNodes().front();
-            
-
-            if (m_nodePtr == m_NodeGrid.getEndNode()) {
-                // DrawNodeGrid();
-                DrawShortestPath();
-            }
+    if (m_isAnimating) {
+        int steps = isLargerThanFPS ? getStdDistVal(m_frameCount, 30, 11, m_totalFrames) : 1;
+        for (int fr = 0; fr < steps && m_isAnimating; ++fr) {
+            advanceVisitedNode();
         }
 
         ++m_frameCount;
@@ -120,20 +223,46 @@ int GameEngine::getStdDistVal(int x, int mean, float std_dev, int size) {
     return ret_val;
 }
 
-void GameEngine::DrawVisitedNode(const NodePtr& nodePtr) {
+// Solves without animating the trace and draws the path right away
+void GameEngine::replanLive() {
+    m_NodeGrid.solvePath();
+    DrawShortestPath();
+    m_isAnimating = false;
+}
+
+// Draws the next entry of the visited trace. Once the trace reaches the
+// end node or runs dry the shortest path is drawn and the animation stops.
+void GameEngine::advanceVisitedNode() {
+    const auto& visited = m_NodeGrid.getVisitedNodes();
+
+    if (visited.empty() || visited.front().nid == m_NodeGrid.getEndNode()) {
+        DrawShortestPath();
+        m_isAnimating = false;
+        return;
+    }
+
+    DrawVisitedNode(visited.front());
+    m_NodeGrid.popFrontVisitedNode();
+}
+
+void GameEngine::DrawVisitedNode(const TraceEntry& entry) {
     constexpr int nodeRadius = 2;
 
     // Visited Node center x,y coordinates
-    int visit_x = getX_pixelSpace(nodePtr->x());
-    int visit_y = getY_pixelSpace(nodePtr->y());
-    
-    // Parent Node center x,y coordinates
-    int parent_x = getX_pixelSpace(nodePtr->parent->x());
-    int parent_y = getY_pixelSpace(nodePtr->parent->y());
+    int visit_x = getX_pixelSpace(m_NodeGrid.x(entry.nid));
+    int visit_y = getY_pixelSpace(m_NodeGrid.y(entry.nid));
 
+    olc::Pixel color = (entry.frontier == Frontier::BACKWARD) ? getPixelColor(VISITED_BACK)
+                                                              : getPixelColor(VISITED_NODE);
 
-    DrawLine(visit_x, visit_y, parent_x, parent_y, getPixelColor(VISITED_NODE));
-    FillCircle(visit_x, visit_y, nodeRadius, getPixelColor(VISITED_NODE));
+    // Parent Node center x,y coordinates, as recorded when the node was expanded
+    if (entry.parent != INVALID_NODE) {
+        int parent_x = getX_pixelSpace(m_NodeGrid.x(entry.parent));
+        int parent_y = getY_pixelSpace(m_NodeGrid.y(entry.parent));
+        DrawLine(visit_x, visit_y, parent_x, parent_y, color);
+    }
+
+    FillCircle(visit_x, visit_y, nodeRadius, color);
 }
 
 olc::Pixel GameEngine::getPixelColor(GameEngine::ColorEnums color) {
@@ -154,52 +283,111 @@ int GameEngine::getY_pixelSpace(int y) {
 }
 
 void GameEngine::DrawNodeGrid() {
-    DrawNodeConnections();
+    if (m_showFlowField)
+        DrawFlowField();
+    else
+        DrawNodeConnections();
     // DrawShortestPath();
     DrawNodes();
 }
 
 void GameEngine::DrawNodeConnections() {
-    for(auto node : m_NodeGrid.getNodes()) {
-        int xpos = getX_pixelSpace(node->x());
-        int ypos = getY_pixelSpace(node->y());
+    for (NodeId nid = 0; nid < static_cast<NodeId>(m_NodeGrid.getTotalNodes()); ++nid) {
+        int xpos = getX_pixelSpace(m_NodeGrid.x(nid));
+        int ypos = getY_pixelSpace(m_NodeGrid.y(nid));
 
-        for (auto adj : node->adjNodes) {
-            int adj_xpos = getX_pixelSpace(adj->x());
-            int adj_ypos = getY_pixelSpace(adj->y());
+        m_NodeGrid.forEachNeighbor(nid, [&](NodeId adj, Direction) {
+            int adj_xpos = getX_pixelSpace(m_NodeGrid.x(adj));
+            int adj_ypos = getY_pixelSpace(m_NodeGrid.y(adj));
 
-            olc::Pixel line_color = adj->isVisited() ? getPixelColor(VISITED_NODE) : getPixelColor(NEUTRAL_NODE);
+            olc::Pixel line_color = m_NodeGrid.isVisited(adj) ? getPixelColor(VISITED_NODE) : getPixelColor(NEUTRAL_NODE);
             DrawLine(xpos, ypos, adj_xpos, adj_ypos, line_color);
-        }
+        });
     }
 }
 
+// The step every cell takes towards the end node, shaded from near to
+// far along its distance
+void GameEngine::DrawFlowField() {
+    const FlowField& field = m_NodeGrid.getFlowField(m_NodeGrid.getEndNode());
+
+    uint16_t maxDist = 1;
+    for (NodeId nid = 0; nid < static_cast<NodeId>(m_NodeGrid.getTotalNodes()); ++nid) {
+        if (field.distance(nid) != FlowField::UNREACHABLE)
+            maxDist = std::max(maxDist, field.distance(nid));
+    }
+
+    olc::Pixel near = getPixelColor(FLOW_NEAR);
+    olc::Pixel far  = getPixelColor(FLOW_FAR);
+
+    for (NodeId nid = 0; nid < static_cast<NodeId>(m_NodeGrid.getTotalNodes()); ++nid) {
+        NodeId next = field.nextStep(nid);
+        if (next == INVALID_NODE)
+            continue;
+
+        float t = static_cast<float>(field.distance(nid)) / maxDist;
+        olc::Pixel color(static_cast<uint8_t>(near.r + t * (far.r - near.r)),
+                         static_cast<uint8_t>(near.g + t * (far.g - near.g)),
+                         static_cast<uint8_t>(near.b + t * (far.b - near.b)));
+
+        DrawLine(getX_pixelSpace(m_NodeGrid.x(nid)), getY_pixelSpace(m_NodeGrid.y(nid)),
+                 getX_pixelSpace(m_NodeGrid.x(next)), getY_pixelSpace(m_NodeGrid.y(next)), color);
+    }
+}
+
+// One straight segment per pair of consecutive path entries: a step
+// between neighbors, or a whole leg between any-angle waypoints, which
+// are marked as well
 void GameEngine::DrawShortestPath() {
-    auto current = m_NodeGrid.getEndNode();
+    const auto& path = m_NodeGrid.getShortestPath();
+    SolverType solver = m_NodeGrid.getSolverType();
+    bool anyAngle = (solver == SolverType::THETA || solver == SolverType::LAZY_THETA) &&
+                    !m_NodeGrid.hasTerrain();
 
-    while (current->parent != nullptr) {
-        int x_A = getX_pixelSpace(current->x());
-        int y_A = getY_pixelSpace(current->y());
+    for (size_t i = 1; i < path.size(); ++i) {
+        int x_A = getX_pixelSpace(m_NodeGrid.x(path[i - 1]));
+        int y_A = getY_pixelSpace(m_NodeGrid.y(path[i - 1]));
 
-        int x_B = getX_pixelSpace(current->parent->x());
-        int y_B = getY_pixelSpace(current->parent->y());
+        int x_B = getX_pixelSpace(m_NodeGrid.x(path[i]));
+        int y_B = getY_pixelSpace(m_NodeGrid.y(path[i]));
 
         DrawLine(x_A, y_A, x_B, y_B, getPixelColor(PATH_LINE));
-        current = current->parent;
+        if (anyAngle && i + 1 < path.size())
+            DrawCircle(x_B, y_B, 3, getPixelColor(PATH_LINE));
     }
+
+    if (!path.empty())
+        DrawPathInfo();
+}
+
+// Cost of the drawn path and its proven bound, e.g. the latest ARA* one
+void GameEngine::DrawPathInfo() {
+    char text[64];
+    float bound = m_NodeGrid.getPathBound();
+
+    if (std::isinf(bound))
+        snprintf(text, sizeof(text), "%s cost %.2f", solverName(m_NodeGrid.getSolverType()),
+                 m_NodeGrid.getPathCost());
+    else
+        snprintf(text, sizeof(text), "%s cost %.2f <= %.3f x optimal",
+                 solverName(m_NodeGrid.getSolverType()), m_NodeGrid.getPathCost(), bound);
+
+    FillRect(0, 0, 8 * static_cast<int>(strlen(text)) + 4, 12, getPixelColor(BACKGROUND));
+    DrawString(2, 2, text, getPixelColor(PATH_LINE));
 }
 
 void GameEngine::DrawNodes() {
     constexpr int nodeRadius = 2;
 
-    for(auto node : m_NodeGrid.getNodes()) {
-        int xpos = getX_pixelSpace(node->x());
-        int ypos = getY_pixelSpace(node->y());
+    for (NodeId nid = 0; nid < static_cast<NodeId>(m_NodeGrid.getTotalNodes()); ++nid) {
+        int xpos = getX_pixelSpace(m_NodeGrid.x(nid));
+        int ypos = getY_pixelSpace(m_NodeGrid.y(nid));
 
-        olc::Pixel nodeColor = (node->isStartNode()) ? getPixelColor(START_NODE)
-                                : (node->isEndNode())   ? getPixelColor(END_NODE)
-                                : (node->isObstacle())  ? getPixelColor(OBSTACLE_NODE)
-                                : (node->isVisited())   ? getPixelColor(VISITED_NODE)
+        olc::Pixel nodeColor = (m_NodeGrid.isStartNode(nid)) ? getPixelColor(START_NODE)
+                                : (m_NodeGrid.isEndNode(nid))   ? getPixelColor(END_NODE)
+                                : (m_NodeGrid.isObstacle(nid))  ? getPixelColor(OBSTACLE_NODE)
+                                : (m_NodeGrid.isVisited(nid))   ? getPixelColor(VISITED_NODE)
+                                : (m_NodeGrid.getTerrain(nid) != TERRAIN_PLAIN) ? getPixelColor(MUD_NODE)
                                 : getPixelColor(NEUTRAL_NODE);
 
         FillCircle(xpos, ypos, nodeRadius, nodeColor);
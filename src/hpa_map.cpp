@@ -0,0 +1,604 @@
+#include "hpa_map.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+// Runs of free cell pairs at least this long get a transition at each end
+static constexpr int ENTRANCE_SPLIT_LENGTH = 6;
+
+HpaPath::HpaPath()
+    : m_map(nullptr)
+    , m_nextLeg(0)
+    , m_pendingPos(0)
+    , m_cost(COST_INFINITY)
+{
+}
+
+bool HpaPath::finished() const {
+    return m_pendingPos == m_pending.size() && m_nextLeg + 1 >= m_waypoints.size();
+}
+
+size_t HpaPath::nextSteps(size_t count, std::vector<NodeId>& steps) {
+    size_t appended = 0;
+
+    while (appended < count) {
+        if (m_pendingPos < m_pending.size()) {
+            steps.push_back(m_pending[m_pendingPos++]);
+            ++appended;
+            continue;
+        }
+        if (m_nextLeg + 1 >= m_waypoints.size())
+            break;
+
+        m_pending.clear();
+        m_pendingPos = 0;
+        if (!m_map->refineLeg(m_waypoints[m_nextLeg], m_waypoints[m_nextLeg + 1], m_pending)) {
+            m_nextLeg = m_waypoints.size();
+            break;
+        }
+        ++m_nextLeg;
+    }
+    return appended;
+}
+
+HpaMap::HpaMap(int sectorSize)
+    : m_grid(nullptr)
+    , m_sectorSize(sectorSize)
+    , m_rows(0)
+    , m_columns(0)
+    , m_sectorsX(0)
+    , m_sectorsY(0)
+    , m_connectivity(Connectivity::EIGHT)
+    , m_cornerRule(CornerRule::CUT_CORNERS)
+    , m_indexDirty(true)
+    , m_localX0(0)
+    , m_localY0(0)
+    , m_localState(static_cast<size_t>(sectorSize) * sectorSize)
+    , m_localOpen(static_cast<size_t>(sectorSize) * sectorSize)
+{
+}
+
+size_t HpaMap::transitionCount() const {
+    size_t total = 0;
+    for (auto& sector : m_sectors) {
+        total += sector.transitions.size();
+    }
+    return total;
+}
+
+int HpaMap::sectorOf(NodeId nid) const {
+    return (m_grid->y(nid) / m_sectorSize) * m_sectorsX + m_grid->x(nid) / m_sectorSize;
+}
+
+void HpaMap::sectorRect(int sector, int& x0, int& y0, int& x1, int& y1) const {
+    x0 = (sector % m_sectorsX) * m_sectorSize;
+    y0 = (sector / m_sectorsX) * m_sectorSize;
+    x1 = std::min(x0 + m_sectorSize, m_columns);
+    y1 = std::min(y0 + m_sectorSize, m_rows);
+}
+
+int HpaMap::neighborSector(int sector, int dx, int dy) const {
+    int sx = sector % m_sectorsX + dx;
+    int sy = sector / m_sectorsX + dy;
+
+    if (sx < 0 || sx >= m_sectorsX || sy < 0 || sy >= m_sectorsY)
+        return -1;
+    return sy * m_sectorsX + sx;
+}
+
+bool HpaMap::isFree(int x, int y) const {
+    return !m_grid->getObstacles().test(x, y);
+}
+
+// Whether the grid's moves include the step (dx, dy) from free cell (x, y)
+bool HpaMap::canStep(int x, int y, int dx, int dy) const {
+    return (m_grid->freeNeighbors(m_grid->nodeAt(x, y)) >> stepDirection(dx, dy)) & 1;
+}
+
+HpaMap::Crossing HpaMap::crossing(NodeId inside, NodeId outside) const {
+    return Crossing{ inside, outside, m_grid->stepCost(inside, outside) };
+}
+
+void HpaMap::rebuild(const NodeGrid& grid) {
+    m_grid         = &grid;
+    m_rows         = grid.getRows();
+    m_columns      = grid.getColumns();
+    m_connectivity = grid.getConnectivity();
+    m_cornerRule   = grid.getCornerRule();
+    m_sectorsX     = (m_columns + m_sectorSize - 1) / m_sectorSize;
+    m_sectorsY     = (m_rows + m_sectorSize - 1) / m_sectorSize;
+
+    m_sectors.assign(static_cast<size_t>(m_sectorsX) * m_sectorsY, Sector());
+
+    for (int sector = 0; sector < sectorCount(); ++sector) {
+        for (int border = 0; border < NUM_BORDERS; ++border) {
+            computeBorder(sector, static_cast<Border>(border));
+        }
+    }
+    for (int sector = 0; sector < sectorCount(); ++sector) {
+        computeSectorGraph(sector);
+    }
+    m_indexDirty = true;
+}
+
+void HpaMap::computeBorderLine(int ax, int ay, int stepX, int stepY, int crossX, int crossY,
+                               int length, std::vector<Crossing>& crossings) const {
+    auto inside  = [&](int i) { return m_grid->nodeAt(ax + i * stepX, ay + i * stepY); };
+    auto outside = [&](int i) { return m_grid->nodeAt(ax + i * stepX + crossX, ay + i * stepY + crossY); };
+    auto insideFree  = [&](int i) { return isFree(ax + i * stepX, ay + i * stepY); };
+    auto outsideFree = [&](int i) { return isFree(ax + i * stepX + crossX, ay + i * stepY + crossY); };
+
+    std::vector<uint8_t> straight(length);
+    for (int i = 0; i < length; ++i) {
+        straight[i] = insideFree(i) && outsideFree(i);
+    }
+
+    // One entrance per maximal run of straight crossings
+    for (int i = 0; i < length; ) {
+        if (!straight[i]) {
+            ++i;
+            continue;
+        }
+
+        int lo = i;
+        while (i < length && straight[i]) {
+            ++i;
+        }
+        int hi = i - 1;
+
+        if (hi - lo + 1 >= ENTRANCE_SPLIT_LENGTH) {
+            crossings.push_back(crossing(inside(lo), outside(lo)));
+            crossings.push_back(crossing(inside(hi), outside(hi)));
+        }
+        else {
+            int mid = (lo + hi) / 2;
+            crossings.push_back(crossing(inside(mid), outside(mid)));
+        }
+    }
+
+    if (m_connectivity != Connectivity::EIGHT)
+        return;
+
+    // A diagonal crossing next to a straight one is reachable through that
+    // run's cells; only diagonals with no straight pair beside them are new.
+    // Those squeeze past two blocked cells, so only cutting corners allows them.
+    if (m_cornerRule != CornerRule::CUT_CORNERS)
+        return;
+
+    for (int i = 0; i + 1 < length; ++i) {
+        if (straight[i] || straight[i + 1])
+            continue;
+        if (insideFree(i) && outsideFree(i + 1))
+            crossings.push_back(crossing(inside(i), outside(i + 1)));
+        if (insideFree(i + 1) && outsideFree(i))
+            crossings.push_back(crossing(inside(i + 1), outside(i)));
+    }
+}
+
+bool HpaMap::computeBorder(int sector, Border border) {
+    int x0, y0, x1, y1;
+    sectorRect(sector, x0, y0, x1, y1);
+
+    bool hasEast  = neighborSector(sector, 1, 0) >= 0;
+    bool hasSouth = neighborSector(sector, 0, 1) >= 0;
+    bool hasWest  = neighborSector(sector, -1, 0) >= 0;
+    bool isEight  = (m_connectivity == Connectivity::EIGHT);
+
+    std::vector<Crossing> crossings;
+
+    switch (border) {
+        case BORDER_EAST:
+            if (hasEast)
+                computeBorderLine(x1 - 1, y0, 0, 1, 1, 0, y1 - y0, crossings);
+            break;
+        case BORDER_SOUTH:
+            if (hasSouth)
+                computeBorderLine(x0, y1 - 1, 1, 0, 0, 1, x1 - x0, crossings);
+            break;
+        case CORNER_SOUTH_EAST:
+            if (isEight && hasEast && hasSouth && isFree(x1 - 1, y1 - 1) && canStep(x1 - 1, y1 - 1, 1, 1))
+                crossings.push_back(crossing(m_grid->nodeAt(x1 - 1, y1 - 1), m_grid->nodeAt(x1, y1)));
+            break;
+        case CORNER_SOUTH_WEST:
+            if (isEight && hasWest && hasSouth && isFree(x0, y1 - 1) && canStep(x0, y1 - 1, -1, 1))
+                crossings.push_back(crossing(m_grid->nodeAt(x0, y1 - 1), m_grid->nodeAt(x0 - 1, y1)));
+            break;
+        default:
+            break;
+    }
+
+    auto& current = m_sectors[sector].borders[border];
+    if (crossings == current)
+        return false;
+
+    current.swap(crossings);
+    return true;
+}
+
+bool HpaMap::computeSectorGraph(int sector) {
+    Sector& data = m_sectors[sector];
+    std::vector<Crossing> inter;
+
+    for (auto& crossings : data.borders) {
+        inter.insert(inter.end(), crossings.begin(), crossings.end());
+    }
+
+    // Crossings owned by the sectors west and north, seen from this side
+    auto addIncoming = [&](int dx, int dy, Border border) {
+        int neighbor = neighborSector(sector, dx, dy);
+        if (neighbor < 0)
+            return;
+        for (auto& crossing : m_sectors[neighbor].borders[border]) {
+            inter.push_back(Crossing{ crossing.outside, crossing.inside, crossing.cost });
+        }
+    };
+    addIncoming(-1,  0, BORDER_EAST);
+    addIncoming( 0, -1, BORDER_SOUTH);
+    addIncoming(-1, -1, CORNER_SOUTH_EAST);
+    addIncoming( 1, -1, CORNER_SOUTH_WEST);
+
+    std::sort(inter.begin(), inter.end(), [](const Crossing& a, const Crossing& b) {
+        return a.inside < b.inside || (a.inside == b.inside && a.outside < b.outside);
+    });
+
+    std::vector<NodeId> transitions;
+    std::vector<uint32_t> interBegin;
+    for (size_t k = 0; k < inter.size(); ++k) {
+        if (transitions.empty() || transitions.back() != inter[k].inside) {
+            transitions.push_back(inter[k].inside);
+            interBegin.push_back(static_cast<uint32_t>(k));
+        }
+    }
+    interBegin.push_back(static_cast<uint32_t>(inter.size()));
+
+    bool changed = (transitions != data.transitions);
+    data.transitions.swap(transitions);
+    data.interBegin.swap(interBegin);
+    data.inter.swap(inter);
+
+    // Distances are symmetric, so each Dijkstra only has to settle the
+    // transitions after its own
+    size_t n = data.transitions.size();
+    data.dist.assign(n * n, COST_INFINITY);
+
+    for (size_t i = 0; i < n; ++i) {
+        data.dist[i * n + i] = 0;
+        if (i + 1 == n)
+            break;
+
+        std::vector<NodeId> targets(data.transitions.begin() + i + 1, data.transitions.end());
+        searchSector(sector, data.transitions[i], INVALID_NODE, targets);
+
+        for (size_t j = i + 1; j < n; ++j) {
+            Cost dist = localDistance(data.transitions[j]);
+            data.dist[i * n + j] = dist;
+            data.dist[j * n + i] = dist;
+        }
+    }
+    return changed;
+}
+
+int HpaMap::localIndex(NodeId nid) const {
+    return (m_grid->y(nid) - m_localY0) * m_sectorSize + (m_grid->x(nid) - m_localX0);
+}
+
+Cost HpaMap::localDistance(NodeId nid) const {
+    int local = localIndex(nid);
+    return m_localState.isClosed(local) ? m_localState.gRaw(local) : COST_INFINITY;
+}
+
+void HpaMap::searchSector(int sector, NodeId source, NodeId goal,
+                          const std::vector<NodeId>& targets) {
+    int x0, y0, x1, y1;
+    sectorRect(sector, x0, y0, x1, y1);
+    m_localX0 = x0;
+    m_localY0 = y0;
+
+    m_localState.beginQuery();
+    m_localOpen.clear();
+
+    size_t remaining = targets.size();
+    if (goal == INVALID_NODE && remaining == 0)
+        return;
+
+    Cost sourceH = (goal != INVALID_NODE) ? m_grid->heuristicCost(source, goal) : 0;
+    int sourceLocal = localIndex(source);
+    m_localState.open(sourceLocal, 0, sourceH, INVALID_NODE);
+    m_localOpen.push(sourceLocal, sourceH, sourceH);
+
+    int width  = x1 - x0;
+    int height = y1 - y0;
+
+    while (!m_localOpen.empty()) {
+        int current = m_localOpen.pop();
+        m_localState.close(current);
+
+        // Neighbors are stepped in local coordinates, which keeps the
+        // divisions of NodeId <-> (x, y) out of the inner loop
+        int local_x = current % m_sectorSize;
+        int local_y = current / m_sectorSize;
+        NodeId cell = m_grid->nodeAt(x0 + local_x, y0 + local_y);
+
+        if (cell == goal)
+            break;
+        if (goal == INVALID_NODE && std::binary_search(targets.begin(), targets.end(), cell) &&
+            --remaining == 0)
+            break;
+
+        Cost currentG = m_localState.gRaw(current);
+        unsigned dirs = m_grid->freeNeighbors(cell);
+
+        while (dirs) {
+            int dir = __builtin_ctz(dirs);
+            dirs &= dirs - 1;
+
+            int adj_x = local_x + DIR_DX[dir];
+            int adj_y = local_y + DIR_DY[dir];
+            if (adj_x < 0 || adj_x >= width || adj_y < 0 || adj_y >= height)
+                continue;
+
+            int local = adj_y * m_sectorSize + adj_x;
+            SearchState::Status status = m_localState.status(local);
+            if (status == SearchState::CLOSED)
+                continue;
+
+            NodeId adjCell = m_grid->nodeAt(x0 + adj_x, y0 + adj_y);
+            Cost adjG = currentG + m_grid->stepCost(cell, adjCell, static_cast<Direction>(dir));
+
+            if (status == SearchState::UNSEEN) {
+                Cost adjH = (goal != INVALID_NODE) ? m_grid->heuristicCost(adjCell, goal) : 0;
+                m_localState.open(local, adjG, adjH, current);
+                m_localOpen.push(local, adjG + adjH, adjH);
+            }
+            else if (adjG < m_localState.gRaw(local)) {
+                m_localState.relax(local, adjG, current);
+                m_localOpen.decreaseKey(local, adjG + m_localState.hRaw(local));
+            }
+        }
+    }
+}
+
+bool HpaMap::refineLeg(NodeId from, NodeId to, std::vector<NodeId>& cells) {
+    if (from == to)
+        return true;
+
+    // Legs between sectors are single crossing moves
+    int sector = sectorOf(from);
+    if (sectorOf(to) != sector) {
+        if (m_grid->isObstacle(from) || m_grid->isObstacle(to))
+            return false;
+        cells.push_back(to);
+        return true;
+    }
+
+    searchSector(sector, from, to, std::vector<NodeId>());
+    int local = localIndex(to);
+    if (!m_localState.isClosed(local))
+        return false;
+
+    size_t first = cells.size();
+    for (int sourceLocal = localIndex(from); local != sourceLocal;
+         local = static_cast<int>(m_localState.parent(local))) {
+        cells.push_back(m_grid->nodeAt(m_localX0 + local % m_sectorSize,
+                                       m_localY0 + local / m_sectorSize));
+    }
+    std::reverse(cells.begin() + first, cells.end());
+    return true;
+}
+
+void HpaMap::buildIndex() {
+    m_sectorBase.resize(m_sectors.size() + 1);
+    m_abstractCell.clear();
+    m_abstractSector.clear();
+
+    for (int sector = 0; sector < sectorCount(); ++sector) {
+        m_sectorBase[sector] = static_cast<uint32_t>(m_abstractCell.size());
+        for (NodeId cell : m_sectors[sector].transitions) {
+            m_abstractCell.push_back(cell);
+            m_abstractSector.push_back(sector);
+        }
+    }
+    m_sectorBase[m_sectors.size()] = static_cast<uint32_t>(m_abstractCell.size());
+
+    // Two extra ids for the start and goal of a query
+    m_abstractState.resize(m_abstractCell.size() + 2);
+    m_abstractOpen.resize(m_abstractCell.size() + 2);
+    m_indexDirty = false;
+}
+
+uint32_t HpaMap::abstractId(int sector, NodeId cell) const {
+    const auto& transitions = m_sectors[sector].transitions;
+    auto it = std::lower_bound(transitions.begin(), transitions.end(), cell);
+    return m_sectorBase[sector] + static_cast<uint32_t>(it - transitions.begin());
+}
+
+bool HpaMap::findPath(NodeId start, NodeId goal, HpaPath& path, SearchStats& stats,
+                      std::deque<TraceEntry>* trace) {
+    path = HpaPath();
+    path.m_map = this;
+
+    if (m_grid->getConnectivity() != m_connectivity || m_grid->getCornerRule() != m_cornerRule)
+        rebuild(*m_grid);
+    if (m_indexDirty)
+        buildIndex();
+    if (m_grid->isObstacle(start) || m_grid->isObstacle(goal))
+        return false;
+
+    const uint32_t START = static_cast<uint32_t>(m_abstractCell.size());
+    const uint32_t GOAL  = START + 1;
+    int startSector = sectorOf(start);
+    int goalSector  = sectorOf(goal);
+
+    // Link start and goal to the transitions of their sectors
+    const auto& startTransitions = m_sectors[startSector].transitions;
+    std::vector<NodeId> targets = startTransitions;
+    if (goalSector == startSector && !std::binary_search(targets.begin(), targets.end(), goal))
+        targets.insert(std::lower_bound(targets.begin(), targets.end(), goal), goal);
+
+    searchSector(startSector, start, INVALID_NODE, targets);
+    std::vector<Cost> startLinks;
+    for (NodeId cell : startTransitions) {
+        startLinks.push_back(localDistance(cell));
+    }
+    Cost direct = (goalSector == startSector) ? localDistance(goal) : COST_INFINITY;
+
+    const auto& goalTransitions = m_sectors[goalSector].transitions;
+    searchSector(goalSector, goal, INVALID_NODE, goalTransitions);
+    std::vector<Cost> goalLinks;
+    for (NodeId cell : goalTransitions) {
+        goalLinks.push_back(localDistance(cell));
+    }
+
+    auto cellOf = [&](uint32_t id) {
+        return (id == START) ? start : (id == GOAL) ? goal : m_abstractCell[id];
+    };
+
+    m_abstractState.beginQuery();
+    m_abstractOpen.clear();
+
+    Cost startH = m_grid->heuristicCost(start, goal);
+    m_abstractState.open(START, 0, startH, INVALID_NODE);
+    m_abstractOpen.push(START, startH, startH);
+    ++stats.pushes;
+
+    auto relax = [&](uint32_t current, uint32_t adj, Cost edge) {
+        SearchState::Status status = m_abstractState.status(adj);
+        if (status == SearchState::CLOSED)
+            return;
+
+        Cost adjG = m_abstractState.gRaw(current) + edge;
+
+        if (status == SearchState::UNSEEN) {
+            Cost adjH = m_grid->heuristicCost(cellOf(adj), goal);
+            m_abstractState.open(adj, adjG, adjH, current);
+            m_abstractOpen.push(adj, adjG + adjH, adjH);
+            ++stats.pushes;
+        }
+        else if (adjG < m_abstractState.gRaw(adj)) {
+            m_abstractState.relax(adj, adjG, current);
+            m_abstractOpen.decreaseKey(adj, adjG + m_abstractState.hRaw(adj));
+            ++stats.decreaseKeys;
+        }
+    };
+
+    while (!m_abstractOpen.empty()) {
+        uint32_t current = m_abstractOpen.pop();
+        m_abstractState.close(current);
+        ++stats.pops;
+
+        if (trace && current != START)
+            trace->push_back(TraceEntry{ cellOf(current), cellOf(m_abstractState.parent(current)),
+                                         Frontier::FORWARD });
+        if (current == GOAL)
+            break;
+        ++stats.expansions;
+
+        if (current == START) {
+            for (size_t i = 0; i < startLinks.size(); ++i) {
+                if (startLinks[i] != COST_INFINITY)
+                    relax(START, m_sectorBase[startSector] + static_cast<uint32_t>(i), startLinks[i]);
+            }
+            if (direct != COST_INFINITY)
+                relax(START, GOAL, direct);
+        }
+        else {
+            int sector = m_abstractSector[current];
+            const Sector& data = m_sectors[sector];
+            uint32_t base = m_sectorBase[sector];
+            size_t n = data.transitions.size();
+            size_t i = current - base;
+
+            for (size_t j = 0; j < n; ++j) {
+                Cost dist = data.dist[i * n + j];
+                if (j != i && dist != COST_INFINITY)
+                    relax(current, base + static_cast<uint32_t>(j), dist);
+            }
+            for (uint32_t k = data.interBegin[i]; k < data.interBegin[i + 1]; ++k) {
+                const Crossing& crossing = data.inter[k];
+                relax(current, abstractId(sectorOf(crossing.outside), crossing.outside), crossing.cost);
+            }
+            if (sector == goalSector && goalLinks[i] != COST_INFINITY)
+                relax(current, GOAL, goalLinks[i]);
+        }
+
+        stats.maxOpenSize = std::max(stats.maxOpenSize, m_abstractOpen.size());
+    }
+
+    if (!m_abstractState.isClosed(GOAL))
+        return false;
+
+    for (uint32_t id = GOAL; id != INVALID_NODE; id = m_abstractState.parent(id)) {
+        path.m_waypoints.push_back(cellOf(id));
+    }
+    std::reverse(path.m_waypoints.begin(), path.m_waypoints.end());
+    path.m_cost = m_abstractState.gRaw(GOAL);
+    return true;
+}
+
+void HpaMap::onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    // Large batches touch most sectors anyway
+    if (m_grid != &grid || grid.getConnectivity() != m_connectivity ||
+        grid.getCornerRule() != m_cornerRule || cells.size() > m_sectors.size()) {
+        rebuild(grid);
+        return;
+    }
+
+    std::vector<int> dirtySectors;
+    std::vector<std::pair<int, int>> dirtyBorders;
+
+    for (NodeId nid : cells) {
+        int sector = sectorOf(nid);
+        dirtySectors.push_back(sector);
+
+        int x0, y0, x1, y1;
+        sectorRect(sector, x0, y0, x1, y1);
+        int cell_x = grid.x(nid);
+        int cell_y = grid.y(nid);
+        if (cell_x != x0 && cell_x != x1 - 1 && cell_y != y0 && cell_y != y1 - 1)
+            continue;
+
+        // A border cell can change every entrance around its sector,
+        // including those owned by the sectors west and north of it
+        for (int border = 0; border < NUM_BORDERS; ++border) {
+            dirtyBorders.emplace_back(sector, border);
+        }
+        static const int OWNER_DX[NUM_BORDERS] = { -1,  0, -1,  1 };
+        static const int OWNER_DY[NUM_BORDERS] = {  0, -1, -1, -1 };
+        for (int border = 0; border < NUM_BORDERS; ++border) {
+            int owner = neighborSector(sector, OWNER_DX[border], OWNER_DY[border]);
+            if (owner >= 0)
+                dirtyBorders.emplace_back(owner, border);
+        }
+    }
+
+    std::sort(dirtyBorders.begin(), dirtyBorders.end());
+    dirtyBorders.erase(std::unique(dirtyBorders.begin(), dirtyBorders.end()), dirtyBorders.end());
+
+    // Sector on the far side of each border
+    static const int ACROSS_DX[NUM_BORDERS] = { 1, 0, 1, -1 };
+    static const int ACROSS_DY[NUM_BORDERS] = { 0, 1, 1,  1 };
+    for (auto& entry : dirtyBorders) {
+        Border border = static_cast<Border>(entry.second);
+        if (computeBorder(entry.first, border)) {
+            dirtySectors.push_back(entry.first);
+            int across = neighborSector(entry.first, ACROSS_DX[border], ACROSS_DY[border]);
+            if (across >= 0)
+                dirtySectors.push_back(across);
+        }
+    }
+
+    std::sort(dirtySectors.begin(), dirtySectors.end());
+    dirtySectors.erase(std::unique(dirtySectors.begin(), dirtySectors.end()), dirtySectors.end());
+
+    for (int sector : dirtySectors) {
+        if (computeSectorGraph(sector))
+            m_indexDirty = true;
+    }
+}
+
+void HpaMap::onTerrainChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    onObstaclesChanged(grid, cells);
+}
+
+void HpaMap::onMapReset(const NodeGrid& grid) {
+    rebuild(grid);
+}
@@ -0,0 +1,148 @@
+#include "ida_star_solver.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+IdaStarSolver::IdaStarSolver()
+    : m_iteration(0)
+    , m_firstIteration(1)
+    , m_maxFrames(0)
+    , m_maxDepth(0)
+    , m_outOfMemory(false)
+    , m_iterations(0)
+    , m_pathCost(COST_INFINITY)
+{
+}
+
+bool IdaStarSolver::visit(NodeId nid, Cost g) {
+    // Fibonacci hashing scaled to the table size, so rows and columns
+    // spread evenly over a table of any size
+    Entry& entry = m_table[(uint64_t(nid * 2654435769u) * m_table.size()) >> 32];
+
+    // Equal g is pruned only within one iteration, whose threshold is the
+    // same; a cheaper g from any iteration of this query means the cheaper
+    // path will be searched again under the higher threshold
+    if (entry.nid == nid && entry.iteration >= m_firstIteration &&
+        (entry.g < g || (entry.g == g && entry.iteration == m_iteration)))
+        return false;
+
+    entry = Entry{ nid, g, m_iteration };
+    return true;
+}
+
+bool IdaStarSolver::solve(const NodeGrid& grid, NodeId start, NodeId goal, size_t memoryBytes,
+                          size_t traceLimit, SearchStats& stats, std::deque<TraceEntry>& trace) {
+    // The stack holds a path through every cell or a quarter of the
+    // memory, whichever is less, and the table the rest, but no more
+    // entries than every cell needs
+    size_t numNodes = grid.getTotalNodes();
+    size_t maxFrames = std::min(numNodes + 1, memoryBytes / 4 / sizeof(Frame));
+    maxFrames = std::max<size_t>(maxFrames, 2);
+    size_t tableBytes = memoryBytes - std::min(memoryBytes, maxFrames * sizeof(Frame));
+    size_t tableSize = std::min(tableBytes / sizeof(Entry), numNodes + numNodes / 3 + 2);
+    tableSize = std::min<size_t>(std::max<size_t>(tableSize, 2), UINT32_MAX);
+
+    if (m_table.size() != tableSize) {
+        m_table.assign(tableSize, Entry{ INVALID_NODE, 0, 0 });
+        m_iteration = 0;
+    }
+    if (m_maxFrames != maxFrames) {
+        std::vector<Frame>().swap(m_stack);
+        m_stack.reserve(maxFrames);
+        m_maxFrames = maxFrames;
+    }
+
+    m_stack.clear();
+    m_maxDepth = 0;
+    m_outOfMemory = false;
+    m_iterations = 0;
+    m_pathCost = COST_INFINITY;
+
+    if (grid.isObstacle(start))
+        return false;
+    if (start == goal) {
+        m_stack.push_back(Frame{ start, 0, 0 });
+        m_pathCost = 0;
+        return true;
+    }
+
+    int offset[NUM_DIRECTIONS];
+    for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+        offset[dir] = DIR_DY[dir] * grid.getColumns() + DIR_DX[dir];
+    }
+
+    Cost threshold = grid.heuristicCost(start, goal);
+    size_t recorded = 0;
+    m_firstIteration = m_iteration + 1;
+
+    while (threshold != COST_INFINITY) {
+        if (m_iteration == UINT32_MAX) {
+            std::fill(m_table.begin(), m_table.end(), Entry{ INVALID_NODE, 0, 0 });
+            m_iteration = 0;
+            m_firstIteration = 1;
+        }
+        ++m_iteration;
+        ++m_iterations;
+
+        Cost nextThreshold = COST_INFINITY;
+        m_stack.push_back(Frame{ start, 0, grid.freeNeighbors(start) });
+        visit(start, 0);
+
+        while (!m_stack.empty()) {
+            Frame& top = m_stack.back();
+            if (top.moves == 0) {
+                m_stack.pop_back();
+                continue;
+            }
+
+            int dir = __builtin_ctz(top.moves);
+            top.moves &= top.moves - 1;
+
+            NodeId adj = top.nid + offset[dir];
+            Cost g = top.g + grid.stepCost(top.nid, adj, static_cast<Direction>(dir));
+            Cost f = g + grid.heuristicCost(adj, goal);
+
+            if (f > threshold) {
+                nextThreshold = std::min(nextThreshold, f);
+                continue;
+            }
+            if (!visit(adj, g))
+                continue;
+
+            if (m_stack.size() == m_maxFrames) {
+                m_outOfMemory = true;
+                return false;
+            }
+            if (recorded < traceLimit) {
+                trace.push_back(TraceEntry{ adj, top.nid, Frontier::FORWARD });
+                ++recorded;
+            }
+            ++stats.expansions;
+            ++stats.pushes;
+
+            m_stack.push_back(Frame{ adj, g, grid.freeNeighbors(adj) });
+            m_maxDepth = std::max(m_maxDepth, m_stack.size());
+            stats.maxOpenSize = std::max(stats.maxOpenSize, m_stack.size());
+
+            // f <= threshold <= optimal cost, so the first arrival is optimal
+            if (adj == goal) {
+                m_pathCost = g;
+                return true;
+            }
+        }
+        threshold = nextThreshold;
+    }
+    return false;
+}
+
+void IdaStarSolver::buildPath(std::vector<NodeId>& path) const {
+    if (m_pathCost == COST_INFINITY)
+        return;
+
+    for (auto it = m_stack.rbegin(); it != m_stack.rend(); ++it) {
+        path.push_back(it->nid);
+    }
+}
+
+size_t IdaStarSolver::memoryBytes() const {
+    return m_table.size() * sizeof(Entry) + m_maxDepth * sizeof(Frame);
+}
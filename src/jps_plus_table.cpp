@@ -0,0 +1,190 @@
+#include "jps_plus_table.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+static constexpr int MAX_DISTANCE = INT16_MAX;
+
+// Straight direction of the horizontal / vertical part of a diagonal
+static int horizontalDir(int dx) { return (dx > 0) ? DIR_EAST  : DIR_WEST;  }
+static int verticalDir(int dy)   { return (dy > 0) ? DIR_SOUTH : DIR_NORTH; }
+
+// Next entry along a run: one step further from the jump point or wall
+static int16_t extendRun(int next) {
+    int value = (next > 0) ? next + 1 : next - 1;
+    return static_cast<int16_t>(std::max(-MAX_DISTANCE, std::min(MAX_DISTANCE, value)));
+}
+
+JpsPlusTable::JpsPlusTable()
+    : m_grid(nullptr)
+    , m_rows(0)
+    , m_columns(0)
+{
+}
+
+bool JpsPlusTable::isFree(int x, int y) const {
+    return !m_grid->getObstacles().test(x, y);
+}
+
+void JpsPlusTable::rebuild(const NodeGrid& grid) {
+    m_grid    = &grid;
+    m_rows    = grid.getRows();
+    m_columns = grid.getColumns();
+    m_dist.assign(static_cast<size_t>(grid.getTotalNodes()) * NUM_DIRECTIONS, 0);
+
+    for (int y = 0; y < m_rows; ++y) {
+        computeRow(y, nullptr);
+    }
+    for (int x = 0; x < m_columns; ++x) {
+        computeColumn(x, nullptr);
+    }
+    computeAllDiagonals();
+}
+
+void JpsPlusTable::computeRow(int y, std::vector<NodeId>* changed) {
+    computeStraightLine(0, y, DIR_EAST, changed);
+    computeStraightLine(0, y, DIR_WEST, changed);
+}
+
+void JpsPlusTable::computeColumn(int x, std::vector<NodeId>* changed) {
+    computeStraightLine(x, 0, DIR_SOUTH, changed);
+    computeStraightLine(x, 0, DIR_NORTH, changed);
+}
+
+void JpsPlusTable::computeStraightLine(int x, int y, int dir, std::vector<NodeId>* changed) {
+    int dx = DIR_DX[dir];
+    int dy = DIR_DY[dir];
+
+    // Start at the cell furthest along dir and walk back against it, so the
+    // entry of the next cell is always known
+    int cx = (dx > 0) ? m_columns - 1 : (dx < 0) ? 0 : x;
+    int cy = (dy > 0) ? m_rows - 1    : (dy < 0) ? 0 : y;
+    int16_t next = 0;
+
+    for (; cx >= 0 && cx < m_columns && cy >= 0 && cy < m_rows; cx -= dx, cy -= dy) {
+        int nx = cx + dx;
+        int ny = cy + dy;
+        int16_t value;
+
+        if (!isFree(nx, ny)) {
+            value = 0;
+        }
+        else if (dy == 0 ? ((!isFree(nx, ny + 1) && isFree(nx + dx, ny + 1)) ||
+                            (!isFree(nx, ny - 1) && isFree(nx + dx, ny - 1)))
+                         : ((!isFree(nx + 1, ny) && isFree(nx + 1, ny + dy)) ||
+                            (!isFree(nx - 1, ny) && isFree(nx - 1, ny + dy)))) {
+            value = 1;    // next cell has a forced neighbor
+        }
+        else {
+            value = extendRun(next);
+        }
+
+        int16_t& stored = entry(cx, cy, dir);
+        if (stored != value) {
+            stored = value;
+            if (changed)
+                changed->push_back(m_grid->nodeAt(cx, cy));
+        }
+        next = value;
+    }
+}
+
+int16_t JpsPlusTable::diagonalValue(int x, int y, int dir) const {
+    int dx = DIR_DX[dir];
+    int dy = DIR_DY[dir];
+    int nx = x + dx;
+    int ny = y + dy;
+
+    if (!isFree(nx, ny))
+        return 0;
+
+    NodeId next = m_grid->nodeAt(nx, ny);
+    bool forced = (isFree(nx - dx, ny + dy) && !isFree(nx - dx, ny)) ||
+                  (isFree(nx + dx, ny - dy) && !isFree(nx, ny - dy));
+
+    // A diagonal cell is a jump point if a straight run from it finds one
+    if (forced || distance(next, horizontalDir(dx)) > 0 || distance(next, verticalDir(dy)) > 0)
+        return 1;
+
+    return extendRun(distance(next, dir));
+}
+
+void JpsPlusTable::computeAllDiagonals() {
+    for (int dir = DIR_SOUTH_EAST; dir <= DIR_NORTH_EAST; ++dir) {
+        int dx = DIR_DX[dir];
+        int dy = DIR_DY[dir];
+
+        for (int i = 0; i < m_rows; ++i) {
+            int y = (dy > 0) ? m_rows - 1 - i : i;
+            for (int j = 0; j < m_columns; ++j) {
+                int x = (dx > 0) ? m_columns - 1 - j : j;
+                entry(x, y, dir) = diagonalValue(x, y, dir);
+            }
+        }
+    }
+}
+
+void JpsPlusTable::onMapReset(const NodeGrid& grid) {
+    rebuild(grid);
+}
+
+void JpsPlusTable::onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    // Large batches touch most lines anyway
+    if (m_grid != &grid || cells.size() * 64 > static_cast<size_t>(grid.getTotalNodes())) {
+        rebuild(grid);
+        return;
+    }
+
+    // Straight entries depend on the cells of their own line and the two
+    // lines beside it (forced neighbors)
+    std::vector<int> rows, columns;
+    std::vector<NodeId> seeds;
+
+    for (NodeId nid : cells) {
+        int cell_x = grid.x(nid);
+        int cell_y = grid.y(nid);
+
+        for (int d = -1; d <= 1; ++d) {
+            if (cell_y + d >= 0 && cell_y + d < m_rows)    rows.push_back(cell_y + d);
+            if (cell_x + d >= 0 && cell_x + d < m_columns) columns.push_back(cell_x + d);
+        }
+
+        // The 3x3 block around an edit is where diagonal forced checks change
+        for (int ny = cell_y - 1; ny <= cell_y + 1; ++ny) {
+            for (int nx = cell_x - 1; nx <= cell_x + 1; ++nx) {
+                if (nx >= 0 && nx < m_columns && ny >= 0 && ny < m_rows)
+                    seeds.push_back(grid.nodeAt(nx, ny));
+            }
+        }
+    }
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+
+    for (int y : rows) {
+        computeRow(y, &seeds);
+    }
+    for (int x : columns) {
+        computeColumn(x, &seeds);
+    }
+
+    std::sort(seeds.begin(), seeds.end());
+    seeds.erase(std::unique(seeds.begin(), seeds.end()), seeds.end());
+
+    // A diagonal entry only depends on the next cell along its diagonal, so
+    // walk back from every changed cell until an entry comes out the same
+    for (NodeId seed : seeds) {
+        for (int dir = DIR_SOUTH_EAST; dir <= DIR_NORTH_EAST; ++dir) {
+            int x = grid.x(seed) - DIR_DX[dir];
+            int y = grid.y(seed) - DIR_DY[dir];
+
+            for (; x >= 0 && x < m_columns && y >= 0 && y < m_rows; x -= DIR_DX[dir], y -= DIR_DY[dir]) {
+                int16_t value = diagonalValue(x, y, dir);
+                if (entry(x, y, dir) == value)
+                    break;
+                entry(x, y, dir) = value;
+            }
+        }
+    }
+}
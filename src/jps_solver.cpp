@@ -0,0 +1,249 @@
+#include "jps_solver.hpp"
+#include "node_grid.hpp"
+
+static int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+static uint8_t dirBit(int dx, int dy) {
+    return static_cast<uint8_t>(1u << stepDirection(dx, dy));
+}
+
+JpsSolver::JpsSolver(const NodeGrid& grid, SearchState& state, IndexedHeap<Cost>& openList,
+                     const JpsPlusTable* table)
+    : m_grid(grid)
+    , m_state(state)
+    , m_openList(openList)
+    , m_table(table)
+    , m_goal(INVALID_NODE)
+    , m_goalX(-1)
+    , m_goalY(-1)
+{
+}
+
+Cost JpsSolver::runCost(int dx, int dy) {
+    Cost ax = static_cast<Cost>(std::abs(dx));
+    Cost ay = static_cast<Cost>(std::abs(dy));
+    return COST_STRAIGHT * std::max(ax, ay) + (COST_DIAGONAL - COST_STRAIGHT) * std::min(ax, ay);
+}
+
+bool JpsSolver::isFree(int x, int y) const {
+    return !m_grid.getObstacles().test(x, y);
+}
+
+uint8_t JpsSolver::successorDirections(NodeId nid, NodeId parent) const {
+    if (parent == INVALID_NODE)
+        return m_grid.freeNeighbors(nid);
+
+    int x = m_grid.x(nid);
+    int y = m_grid.y(nid);
+    int dx = sign(x - m_grid.x(parent));
+    int dy = sign(y - m_grid.y(parent));
+    uint8_t dirs = 0;
+
+    if (dx != 0 && dy != 0) {
+        // Natural neighbors, then the two forced ones behind blocked sides
+        dirs |= dirBit(0, dy) | dirBit(dx, 0) | dirBit(dx, dy);
+        if (!isFree(x - dx, y)) dirs |= dirBit(-dx, dy);
+        if (!isFree(x, y - dy)) dirs |= dirBit(dx, -dy);
+    }
+    else if (dx != 0) {
+        dirs |= dirBit(dx, 0);
+        if (!isFree(x, y + 1)) dirs |= dirBit(dx, 1);
+        if (!isFree(x, y - 1)) dirs |= dirBit(dx, -1);
+    }
+    else {
+        dirs |= dirBit(0, dy);
+        if (!isFree(x + 1, y)) dirs |= dirBit(1, dy);
+        if (!isFree(x - 1, y)) dirs |= dirBit(-1, dy);
+    }
+
+    // Jumps stop at blocked cells anyway, this just skips the call
+    return dirs & m_grid.freeNeighbors(nid);
+}
+
+NodeId JpsSolver::jumpHorizontal(int x, int y, int dx) const {
+    const ObstacleBitmap& obstacles = m_grid.getObstacles();
+    constexpr int WORD = ObstacleBitmap::BITS_PER_WORD;
+
+    while (true) {
+        if (obstacles.test(x, y))
+            return INVALID_NODE;
+
+        if (dx > 0) {
+            // Bit i of each word is column x + i. A cell is a jump point when
+            // the cell above or below it is blocked but the next one is free.
+            uint64_t blocked = obstacles.bitsAt(x, y);
+            uint64_t forced  = (obstacles.bitsAt(x, y - 1) & ~obstacles.bitsAt(x + 1, y - 1))
+                             | (obstacles.bitsAt(x, y + 1) & ~obstacles.bitsAt(x + 1, y + 1));
+            uint64_t stop = blocked | forced;
+
+            if (y == m_goalY && m_goalX >= x && m_goalX - x < WORD)
+                stop |= uint64_t(1) << (m_goalX - x);
+
+            if (stop) {
+                int i = __builtin_ctzll(stop);
+                return ((blocked >> i) & 1) ? INVALID_NODE : m_grid.nodeAt(x + i, y);
+            }
+            x += WORD;
+        }
+        else {
+            // Same scan mirrored: window [lo, x], bit i is column lo + i
+            int lo = std::max(x - (WORD - 1), 0);
+            int width = x - lo + 1;
+            uint64_t mask = (width == WORD) ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+
+            uint64_t blocked = obstacles.bitsAt(lo, y);
+            uint64_t forced  = (obstacles.bitsAt(lo, y - 1) & ~obstacles.bitsAt(lo - 1, y - 1))
+                             | (obstacles.bitsAt(lo, y + 1) & ~obstacles.bitsAt(lo - 1, y + 1));
+            uint64_t stop = blocked | forced;
+
+            if (y == m_goalY && m_goalX >= lo && m_goalX <= x)
+                stop |= uint64_t(1) << (m_goalX - lo);
+            stop &= mask;
+
+            if (stop) {
+                int i = WORD - 1 - __builtin_clzll(stop);
+                return ((blocked >> i) & 1) ? INVALID_NODE : m_grid.nodeAt(lo + i, y);
+            }
+            if (lo == 0)
+                return INVALID_NODE;
+            x = lo - 1;
+        }
+    }
+}
+
+NodeId JpsSolver::jumpVertical(int x, int y, int dy) const {
+    while (true) {
+        if (!isFree(x, y))
+            return INVALID_NODE;
+        if (x == m_goalX && y == m_goalY)
+            return m_goal;
+
+        if ((isFree(x + 1, y + dy) && !isFree(x + 1, y)) ||
+            (isFree(x - 1, y + dy) && !isFree(x - 1, y)))
+            return m_grid.nodeAt(x, y);
+
+        y += dy;
+    }
+}
+
+NodeId JpsSolver::jump(int x, int y, int dx, int dy) const {
+    if (dy == 0)
+        return jumpHorizontal(x, y, dx);
+    if (dx == 0)
+        return jumpVertical(x, y, dy);
+
+    while (true) {
+        if (!isFree(x, y))
+            return INVALID_NODE;
+        if (x == m_goalX && y == m_goalY)
+            return m_goal;
+
+        if ((isFree(x - dx, y + dy) && !isFree(x - dx, y)) ||
+            (isFree(x + dx, y - dy) && !isFree(x, y - dy)))
+            return m_grid.nodeAt(x, y);
+
+        // A diagonal cell is a jump point if a straight run from it finds one
+        if (jumpHorizontal(x + dx, y, dx) != INVALID_NODE ||
+            jumpVertical(x, y + dy, dy) != INVALID_NODE)
+            return m_grid.nodeAt(x, y);
+
+        x += dx;
+        y += dy;
+    }
+}
+
+NodeId JpsSolver::tableSuccessor(int x, int y, int dir) const {
+    int dx = DIR_DX[dir];
+    int dy = DIR_DY[dir];
+    int dist  = m_table->distance(m_grid.nodeAt(x, y), dir);
+    int reach = std::abs(dist);    // free cells before the jump point or wall
+
+    // Steps towards the goal along each axis, > 0 if it lies ahead
+    int ahead_x = (m_goalX - x) * dx;
+    int ahead_y = (m_goalY - y) * dy;
+
+    if (dx == 0 || dy == 0) {
+        // Goal straight ahead within the run
+        bool onRay = (dx != 0) ? (m_goalY == y && ahead_x > 0) : (m_goalX == x && ahead_y > 0);
+        int steps  = (dx != 0) ? ahead_x : ahead_y;
+        if (onRay && steps <= reach)
+            return m_goal;
+    }
+    else if (ahead_x > 0 && ahead_y > 0) {
+        // Goal in this quadrant: stop where the run lines up with its row
+        // or column, the straight run from there can reach it
+        int steps = std::min(ahead_x, ahead_y);
+        if (steps <= reach)
+            return m_grid.nodeAt(x + steps * dx, y + steps * dy);
+    }
+
+    return (dist > 0) ? m_grid.nodeAt(x + dist * dx, y + dist * dy) : INVALID_NODE;
+}
+
+NodeId JpsSolver::successor(int x, int y, int dir) const {
+    if (m_table)
+        return tableSuccessor(x, y, dir);
+    return jump(x + DIR_DX[dir], y + DIR_DY[dir], DIR_DX[dir], DIR_DY[dir]);
+}
+
+bool JpsSolver::solve(NodeId start, NodeId goal, SearchStats& stats, std::deque<TraceEntry>& trace) {
+    m_goal  = goal;
+    m_goalX = m_grid.x(goal);
+    m_goalY = m_grid.y(goal);
+    m_openList.clear();
+
+    Cost startH = m_grid.heuristicCost(start, goal);
+    m_state.open(start, 0, startH, INVALID_NODE);
+    m_openList.push(start, startH, startH);
+    ++stats.pushes;
+
+    while (!m_openList.empty()) {
+        NodeId current = m_openList.pop();
+        m_state.close(current);
+        ++stats.pops;
+
+        if (current != start)
+            trace.push_back(TraceEntry{ current, m_state.parent(current), Frontier::FORWARD });
+
+        if (current == goal)
+            return true;
+
+        ++stats.expansions;
+        int x = m_grid.x(current);
+        int y = m_grid.y(current);
+        Cost currentG = m_state.gRaw(current);
+        unsigned dirs = successorDirections(current, m_state.parent(current));
+
+        while (dirs) {
+            int dir = __builtin_ctz(dirs);
+            dirs &= dirs - 1;
+
+            NodeId jumpPoint = successor(x, y, dir);
+            if (jumpPoint == INVALID_NODE)
+                continue;
+
+            SearchState::Status status = m_state.status(jumpPoint);
+            if (status == SearchState::CLOSED)
+                continue;
+
+            Cost jumpG = currentG + runCost(m_grid.x(jumpPoint) - x, m_grid.y(jumpPoint) - y);
+
+            if (status == SearchState::UNSEEN) {
+                Cost jumpH = m_grid.heuristicCost(jumpPoint, goal);
+                m_state.open(jumpPoint, jumpG, jumpH, current);
+                m_openList.push(jumpPoint, jumpG + jumpH, jumpH);
+                ++stats.pushes;
+            }
+            else if (jumpG < m_state.gRaw(jumpPoint)) {
+                m_state.relax(jumpPoint, jumpG, current);
+                m_openList.decreaseKey(jumpPoint, jumpG + m_state.hRaw(jumpPoint));
+                ++stats.decreaseKeys;
+            }
+        }
+
+        stats.maxOpenSize = std::max(stats.maxOpenSize, m_openList.size());
+    }
+    return false;
+}
@@ -0,0 +1,265 @@
+#include "landmark_table.hpp"
+#include "indexed_heap.hpp"
+#include "node_grid.hpp"
+#include "run_on_threads.hpp"
+#include "search_state.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+static const char FILE_MAGIC[4] = { 'A', 'L', 'T', '1' };
+
+// One-to-all Dijkstra from source; unreachable nodes keep COST_INFINITY
+static void distancesFrom(const NodeGrid& grid, NodeId source, SearchState& state,
+                          IndexedHeap<Cost>& openList, std::vector<Cost>& dist) {
+    dist.assign(grid.getTotalNodes(), COST_INFINITY);
+    state.beginQuery();
+    openList.clear();
+
+    state.open(source, 0, 0, INVALID_NODE);
+    openList.push(source, 0, 0);
+
+    while (!openList.empty()) {
+        NodeId current = openList.pop();
+        state.close(current);
+
+        Cost currentG = state.gRaw(current);
+        dist[current] = currentG;
+
+        grid.forEachNeighbor(current, [&](NodeId adj, Direction dir) {
+            SearchState::Status status = state.status(adj);
+            if (status == SearchState::CLOSED)
+                return;
+
+            Cost adjG = currentG + grid.stepCost(current, adj, dir);
+
+            if (status == SearchState::UNSEEN) {
+                state.open(adj, adjG, 0, current);
+                openList.push(adj, adjG, 0);
+            }
+            else if (adjG < state.gRaw(adj)) {
+                state.relax(adj, adjG, current);
+                openList.decreaseKey(adj, adjG);
+            }
+        });
+    }
+}
+
+LandmarkTable::LandmarkTable(int numLandmarks)
+    : m_numLandmarks(numLandmarks)
+    , m_grid(nullptr)
+    , m_stale(true)
+    , m_rows(0)
+    , m_columns(0)
+    , m_connectivity(Connectivity::EIGHT)
+    , m_cornerRule(CornerRule::CUT_CORNERS)
+    , m_quantum(1)
+{
+}
+
+bool LandmarkTable::isCurrent(const NodeGrid& grid) const {
+    return !m_stale && m_grid == &grid && m_rows == grid.getRows() &&
+           m_columns == grid.getColumns() && m_connectivity == grid.getConnectivity() &&
+           m_cornerRule == grid.getCornerRule();
+}
+
+std::vector<NodeId> LandmarkTable::selectLandmarks(const NodeGrid& grid) const {
+    // Largest connected region by flood fill; landmarks anywhere else
+    // would bound nothing for most queries
+    std::vector<uint8_t> seen(grid.getTotalNodes(), 0);
+    std::vector<NodeId> region, component;
+
+    for (NodeId seed = 0; seed < static_cast<NodeId>(grid.getTotalNodes()); ++seed) {
+        if (seen[seed] || grid.isObstacle(seed))
+            continue;
+
+        component.clear();
+        component.push_back(seed);
+        seen[seed] = 1;
+
+        for (size_t head = 0; head < component.size(); ++head) {
+            grid.forEachNeighbor(component[head], [&](NodeId adj, Direction) {
+                if (!seen[adj]) {
+                    seen[adj] = 1;
+                    component.push_back(adj);
+                }
+            });
+        }
+        if (component.size() > region.size())
+            region.swap(component);
+    }
+
+    // Farthest-point: each landmark is the cell whose nearest landmark is
+    // farthest away, the first one the farthest from an arbitrary seed
+    std::vector<NodeId> landmarks;
+    std::vector<Cost> nearest(region.size(), COST_INFINITY);
+    NodeId from = region.empty() ? INVALID_NODE : region.front();
+
+    for (int k = 0; k < m_numLandmarks && !region.empty(); ++k) {
+        size_t best = 0;
+        for (size_t i = 0; i < region.size(); ++i) {
+            nearest[i] = std::min(nearest[i], grid.heuristicCost(region[i], from));
+            if (nearest[i] > nearest[best])
+                best = i;
+        }
+        if (nearest[best] == 0)
+            break;
+
+        // The seed itself is not a landmark, forget distances to it
+        if (k == 0)
+            std::fill(nearest.begin(), nearest.end(), COST_INFINITY);
+
+        from = region[best];
+        landmarks.push_back(from);
+    }
+    return landmarks;
+}
+
+void LandmarkTable::rebuild(const NodeGrid& grid, unsigned numThreads) {
+    m_grid         = &grid;
+    m_rows         = grid.getRows();
+    m_columns      = grid.getColumns();
+    m_connectivity = grid.getConnectivity();
+    m_cornerRule   = grid.getCornerRule();
+    m_stale        = false;
+    m_landmarks    = selectLandmarks(grid);
+
+    size_t numNodes = grid.getTotalNodes();
+    size_t numLandmarks = m_landmarks.size();
+    std::vector<std::vector<Cost>> exact(numLandmarks);
+
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::max(1u, std::min(numThreads, static_cast<unsigned>(numLandmarks)));
+
+    // Workers pull landmarks off a shared counter, each with its own scratch
+    std::atomic<size_t> next(0);
+    auto worker = [&](unsigned) {
+        SearchState state(numNodes);
+        IndexedHeap<Cost> openList(numNodes);
+
+        for (size_t i = next++; i < numLandmarks; i = next++) {
+            distancesFrom(grid, m_landmarks[i], state, openList, exact[i]);
+        }
+    };
+
+    runOnThreads(numThreads, worker);
+
+    // Smallest quantum that fits the longest finite distance in 16 bits
+    Cost maxDist = 0;
+    for (auto& dist : exact) {
+        for (Cost cost : dist) {
+            if (cost != COST_INFINITY)
+                maxDist = std::max(maxDist, cost);
+        }
+    }
+    m_quantum = std::max<Cost>(1, (maxDist + UNREACHABLE - 2) / (UNREACHABLE - 1));
+
+    m_dist.assign(numNodes * numLandmarks, UNREACHABLE);
+    for (size_t i = 0; i < numLandmarks; ++i) {
+        for (size_t nid = 0; nid < numNodes; ++nid) {
+            if (exact[i][nid] != COST_INFINITY)
+                m_dist[nid * numLandmarks + i] = static_cast<uint16_t>(exact[i][nid] / m_quantum);
+        }
+    }
+}
+
+bool LandmarkTable::save(const char* path) const {
+    if (!m_grid)
+        return false;
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    uint32_t header[6] = {
+        static_cast<uint32_t>(m_rows), static_cast<uint32_t>(m_columns),
+        static_cast<uint32_t>(m_connectivity), static_cast<uint32_t>(m_landmarks.size()),
+        m_quantum, static_cast<uint32_t>(m_cornerRule),
+    };
+    uint64_t hash = m_grid->getMapFingerprint();
+
+    bool ok = fwrite(FILE_MAGIC, sizeof(FILE_MAGIC), 1, file) == 1 &&
+              fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(&hash, sizeof(hash), 1, file) == 1 &&
+              fwrite(m_landmarks.data(), sizeof(NodeId), m_landmarks.size(), file) == m_landmarks.size() &&
+              fwrite(m_dist.data(), sizeof(uint16_t), m_dist.size(), file) == m_dist.size();
+
+    return (fclose(file) == 0) && ok;
+}
+
+bool LandmarkTable::load(const NodeGrid& grid, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    char magic[sizeof(FILE_MAGIC)];
+    uint32_t header[6];
+    uint64_t hash;
+
+    bool ok = fread(magic, sizeof(magic), 1, file) == 1 &&
+              fread(header, sizeof(header), 1, file) == 1 &&
+              fread(&hash, sizeof(hash), 1, file) == 1 &&
+              memcmp(magic, FILE_MAGIC, sizeof(magic)) == 0 &&
+              header[0] == static_cast<uint32_t>(grid.getRows()) &&
+              header[1] == static_cast<uint32_t>(grid.getColumns()) &&
+              header[2] == static_cast<uint32_t>(grid.getConnectivity()) &&
+              header[4] > 0 && header[5] == static_cast<uint32_t>(grid.getCornerRule()) &&
+              hash == grid.getMapFingerprint();
+
+    std::vector<NodeId> landmarks;
+    std::vector<uint16_t> dist;
+    if (ok) {
+        landmarks.resize(header[3]);
+        dist.resize(static_cast<size_t>(grid.getTotalNodes()) * header[3]);
+        ok = fread(landmarks.data(), sizeof(NodeId), landmarks.size(), file) == landmarks.size() &&
+             fread(dist.data(), sizeof(uint16_t), dist.size(), file) == dist.size();
+    }
+    fclose(file);
+
+    if (!ok)
+        return false;
+
+    m_grid         = &grid;
+    m_rows         = grid.getRows();
+    m_columns      = grid.getColumns();
+    m_connectivity = grid.getConnectivity();
+    m_cornerRule   = grid.getCornerRule();
+    m_quantum      = header[4];
+    m_stale        = false;
+    m_landmarks.swap(landmarks);
+    m_dist.swap(dist);
+    return true;
+}
+
+void LandmarkTable::onObstaclesChanged(const NodeGrid&, const std::vector<NodeId>&) {
+    m_stale = true;
+}
+
+void LandmarkTable::onMapReset(const NodeGrid&) {
+    m_stale = true;
+}
+
+LandmarkHeuristic::LandmarkHeuristic(const NodeGrid& grid, const LandmarkTable& table, NodeId goal)
+    : m_grid(grid)
+    , m_table(table)
+    , m_goal(goal)
+    , m_goalDist(table.distances(goal), table.distances(goal) + table.landmarkCount())
+{
+}
+
+Cost LandmarkHeuristic::operator()(NodeId nid) const {
+    const uint16_t* dist = m_table.distances(nid);
+    int best = 0;
+
+    // Quantized |d(L, t) - d(L, v)| is only known to within one quantum
+    for (size_t i = 0; i < m_goalDist.size(); ++i) {
+        if (dist[i] == LandmarkTable::UNREACHABLE || m_goalDist[i] == LandmarkTable::UNREACHABLE)
+            continue;
+        best = std::max(best, std::abs(int(dist[i]) - int(m_goalDist[i])) - 1);
+    }
+
+    return std::max(m_grid.heuristicCost(nid, m_goal), static_cast<Cost>(best) * m_table.quantum());
+}
@@ -1,4 +1,5 @@
 #include "game_engine.hpp"
+#include "benchmark.hpp"
 
 static constexpr int NUM_OF_ARGS = 3;
 
@@ -6,13 +7,20 @@ int main(int argc, char* argv[]) {
 
     if (argc < NUM_OF_ARGS) {
         std::cout << "Please specify number of rows and columns"
-            << "\nUsage: a-star ROWS COLS\n";
+            << "\nUsage: a-star ROWS COLS [--bench | --cpd FILE]\n";
             return -1;
     }
 
     int rows = std::stoi(argv[1]);
     int cols = std::stoi(argv[2]);
 
+    if (argc > NUM_OF_ARGS && std::string(argv[3]) == "--bench") {
+        return runBenchmarks(rows, cols);
+    }
+    if (argc > NUM_OF_ARGS + 1 && std::string(argv[3]) == "--cpd") {
+        return runPathDatabaseTool(rows, cols, argv[4]);
+    }
+
     int px_height = rows*SCALE_FACTOR;
     int px_width = cols*SCALE_FACTOR;
 
@@ -1,17 +1,51 @@
 #include "node_grid.hpp"
+#include "ara_solver.hpp"
+#include "bidirectional_solver.hpp"
+#include "jps_solver.hpp"
+#include "policy_search.hpp"
+#include "theta_solver.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
-#include <queue>
 
 NodeGrid::NodeGrid(int rows, int columns)
     : m_rows(rows)
     , m_columns(columns)
-    , startNode(nullptr)
-    , endNode(nullptr)
+    , m_obstacles(columns, rows)
+    , m_columnObstacles(rows, columns)
+    , m_terrainCounts()
+    , m_minTerrain(TERRAIN_PLAIN)
+    , m_maxTerrain(TERRAIN_PLAIN)
+    , m_connectivity(Connectivity::EIGHT)
+    , m_cornerRule(CornerRule::CUT_CORNERS)
+    , m_heuristicType(HeuristicType::OCTILE)
+    , m_weight(1.0f)
+    , m_anytimeEpsilon(AraSolver::DEFAULT_EPSILON)
+    , m_anytimeBudgetMs(100.0)
+    , m_memoryLimit(DEFAULT_MEMORY_LIMIT)
+    , m_openListType(OpenListType::HEAP)
+    , m_solverType(SolverType::ASTAR)
+    , m_ara(*this, m_context.search, m_context.heapOpenList)
+    , m_useLandmarks(false)
+    , m_useAdaptive(false)
+    , m_useComponents(true)
+    , startNode(INVALID_NODE)
+    , endNode(INVALID_NODE)
+    , m_editDepth(0)
+    , m_mapRevision(0)
+    , m_verbose(true)
 {
     // Grid Map Constructor
+    for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+        m_dirOffset[dir] = DIR_DY[dir] * m_columns + DIR_DX[dir];
+    }
+
+    addEditListener(&m_pathCache);
     initGridNodes(getTotalNodes());
 
-    printf("Creating grid map with %zu nodes.\n", m_NodeGrid.size());
+    printf("Creating grid map with %zu nodes.\n", m_flags.size());
     printf("No. of rows: %d\n", getRows());
     printf("No. of cols: %d\n", getColumns());
 
@@ -21,201 +55,887 @@ NodeGrid::~NodeGrid() {
     // Grid Map Destructor
 }
 
-int NodeGrid::getRows() {
+int NodeGrid::getRows() const {
     return m_rows;
 }
 
-int NodeGrid::getColumns() {
+int NodeGrid::getColumns() const {
     return m_columns;
 }
 
-int NodeGrid::getTotalNodes() {
+int NodeGrid::getTotalNodes() const {
     return m_rows * m_columns;
 }
 
-std::vector<NodePtr> NodeGrid::getNodes() {
-    return m_NodeGrid;
-}
-
-std::vector<NodePtr> NodeGrid::getShortestPath() {
-    return m_shortestPath;
+const std::vector<NodeId>& NodeGrid::getShortestPath() const {
+    return m_context.path;
 }
 
-std::deque<NodePtr> NodeGrid::getVisitedNodes() {
-    return m_visitedNodes;
+const std::deque<TraceEntry>& NodeGrid::getVisitedNodes() const {
+    return m_context.visited;
 }
 
 void NodeGrid::popFrontVisitedNode() {
-    m_visitedNodes.pop_front();
+    m_context.visited.pop_front();
 }
 
-NodePtr NodeGrid::getStartNode() {
+NodeId NodeGrid::getStartNode() const {
     return startNode;
 }
 
-NodePtr NodeGrid::getEndNode() {
+NodeId NodeGrid::getEndNode() const {
     return endNode;
 }
 
-void NodeGrid::initGridNodes(int totalNodes) {
-    for (int nid = 0; nid < totalNodes; ++nid) {
-        int xpos = nid % m_columns;
-        int ypos = nid / m_columns;
-        m_NodeGrid.push_back(std::make_shared<Node>(xpos, ypos, nid));
+void NodeGrid::flipObstacle(NodeId nid) {
+    m_obstacles.toggle(x(nid), y(nid));
+    m_columnObstacles.toggle(y(nid), x(nid));
+    m_pendingEdits.push_back(nid);
+}
+
+void NodeGrid::setObstacle(NodeId nid, bool blocked) {
+    beginEdit();
+    if (isObstacle(nid) != blocked && !(blocked && m_flags[nid])) {
+        flipObstacle(nid);
+    }
+    commitEdit();
+}
+
+void NodeGrid::toggleObstacle(NodeId nid) {
+    setObstacle(nid, !isObstacle(nid));
+}
+
+void NodeGrid::setObstacleRect(int x0, int y0, int x1, int y1, bool blocked) {
+    beginEdit();
+    m_obstacles.forEachDifferingInRect(x0, y0, x1, y1, blocked, [&](int cell_x, int cell_y) {
+        NodeId nid = nodeAt(cell_x, cell_y);
+        if (!(blocked && m_flags[nid])) {
+            flipObstacle(nid);
+        }
+    });
+    commitEdit();
+}
+
+void NodeGrid::setObstacles(const std::vector<NodeId>& cells, bool blocked) {
+    beginEdit();
+    for (NodeId nid : cells) {
+        setObstacle(nid, blocked);
+    }
+    commitEdit();
+}
+
+// The layer is allocated by the first weighted cell
+void NodeGrid::writeTerrain(NodeId nid, uint8_t multiplier) {
+    multiplier = std::max(multiplier, TERRAIN_PLAIN);
+    if (m_terrain.empty()) {
+        if (multiplier == TERRAIN_PLAIN)
+            return;
+        m_terrain.assign(getTotalNodes(), TERRAIN_PLAIN);
+        m_terrainCounts[TERRAIN_PLAIN] = static_cast<uint32_t>(getTotalNodes());
+    }
+
+    uint8_t& cell = m_terrain[nid];
+    if (cell == multiplier)
+        return;
+
+    --m_terrainCounts[cell];
+    ++m_terrainCounts[multiplier];
+    cell = multiplier;
+    m_pendingTerrainEdits.push_back(nid);
+}
+
+void NodeGrid::setTerrain(NodeId nid, uint8_t multiplier) {
+    beginEdit();
+    writeTerrain(nid, multiplier);
+    commitEdit();
+}
+
+void NodeGrid::setTerrainRect(int x0, int y0, int x1, int y1, uint8_t multiplier) {
+    beginEdit();
+    for (int cell_y = std::max(y0, 0); cell_y < std::min(y1, m_rows); ++cell_y) {
+        for (int cell_x = std::max(x0, 0); cell_x < std::min(x1, m_columns); ++cell_x) {
+            writeTerrain(nodeAt(cell_x, cell_y), multiplier);
+        }
     }
+    commitEdit();
+}
+
+void NodeGrid::setTerrains(const std::vector<NodeId>& cells, uint8_t multiplier) {
+    beginEdit();
+    for (NodeId nid : cells) {
+        writeTerrain(nid, multiplier);
+    }
+    commitEdit();
+}
+
+void NodeGrid::clearTerrain() {
+    beginEdit();
+    for (NodeId nid = 0; nid < m_terrain.size(); ++nid) {
+        writeTerrain(nid, TERRAIN_PLAIN);
+    }
+    commitEdit();
+}
+
+const JpsPlusTable& NodeGrid::getJpsPlusTable() {
+    if (!m_jpsPlusTable) {
+        m_jpsPlusTable.reset(new JpsPlusTable());
+        m_jpsPlusTable->rebuild(*this);
+        addEditListener(m_jpsPlusTable.get());
+    }
+    return *m_jpsPlusTable;
+}
+
+HpaMap& NodeGrid::getHpaMap() {
+    if (!m_hpaMap) {
+        m_hpaMap.reset(new HpaMap());
+        m_hpaMap->rebuild(*this);
+        addEditListener(m_hpaMap.get());
+    }
+    return *m_hpaMap;
+}
+
+DStarLite& NodeGrid::getDStarLite() {
+    if (!m_dstarLite) {
+        m_dstarLite.reset(new DStarLite());
+        addEditListener(m_dstarLite.get());
+    }
+    return *m_dstarLite;
+}
+
+const LandmarkTable& NodeGrid::getLandmarkTable() {
+    if (!m_landmarkTable) {
+        m_landmarkTable.reset(new LandmarkTable());
+        addEditListener(m_landmarkTable.get());
+    }
+    if (!m_landmarkTable->isCurrent(*this))
+        m_landmarkTable->rebuild(*this);
+    return *m_landmarkTable;
+}
+
+const AdaptiveHeuristic& NodeGrid::getAdaptiveHeuristic() {
+    if (!m_adaptiveHeuristic) {
+        m_adaptiveHeuristic.reset(new AdaptiveHeuristic());
+        m_adaptiveHeuristic->setGoal(*this, endNode);
+        addEditListener(m_adaptiveHeuristic.get());
+    }
+    return *m_adaptiveHeuristic;
+}
+
+const FlowField& NodeGrid::getFlowField(NodeId goal) {
+    auto found = std::find_if(m_flowFields.begin(), m_flowFields.end(),
+                              [&](const std::unique_ptr<FlowField>& field) { return field->goal() == goal; });
+
+    if (found != m_flowFields.end()) {
+        std::rotate(found, found + 1, m_flowFields.end());
+    }
+    else {
+        if (m_flowFields.size() >= MAX_FLOW_FIELDS) {
+            removeEditListener(m_flowFields.front().get());
+            m_flowFields.erase(m_flowFields.begin());
+        }
+        m_flowFields.emplace_back(new FlowField());
+        addEditListener(m_flowFields.back().get());
+    }
+
+    FlowField& field = *m_flowFields.back();
+    if (!field.isCurrent(*this) || field.goal() != goal)
+        field.rebuild(*this, goal);
+    return field;
+}
+
+const ComponentMap& NodeGrid::getComponentMap() {
+    if (!m_componentMap) {
+        m_componentMap.reset(new ComponentMap());
+        addEditListener(m_componentMap.get());
+    }
+    if (!m_componentMap->isCurrent(*this))
+        m_componentMap->rebuild(*this);
+    return *m_componentMap;
+}
+
+const PathDatabase& NodeGrid::buildPathDatabase(unsigned numThreads) {
+    if (!m_pathDatabase) {
+        m_pathDatabase.reset(new PathDatabase());
+        addEditListener(m_pathDatabase.get());
+    }
+    m_pathDatabase->rebuild(*this, numThreads);
+    return *m_pathDatabase;
+}
+
+bool NodeGrid::loadPathDatabase(const char* path) {
+    if (!m_pathDatabase) {
+        m_pathDatabase.reset(new PathDatabase());
+        addEditListener(m_pathDatabase.get());
+    }
+    return m_pathDatabase->load(*this, path);
+}
+
+bool NodeGrid::loadLandmarkTable(const char* path) {
+    if (!m_landmarkTable) {
+        m_landmarkTable.reset(new LandmarkTable());
+        addEditListener(m_landmarkTable.get());
+    }
+    return m_landmarkTable->load(*this, path);
+}
+
+uint64_t NodeGrid::getMapFingerprint() const {
+    // FNV-1a over the obstacle bits, a word at a time
+    uint64_t hash = 1469598103934665603ull;
+
+    for (int y = 0; y < m_rows; ++y) {
+        for (int x = 0; x < m_columns; x += ObstacleBitmap::BITS_PER_WORD) {
+            uint64_t bits = m_obstacles.bitsAt(x, y);
+            int valid = m_columns - x;
+            if (valid < ObstacleBitmap::BITS_PER_WORD)
+                bits &= (uint64_t(1) << valid) - 1;
+            hash = (hash ^ bits) * 1099511628211ull;
+        }
+    }
+
+    // Plain maps hash as they did before the terrain layer
+    for (uint8_t multiplier : m_terrain) {
+        hash = (hash ^ multiplier) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void NodeGrid::beginEdit() {
+    ++m_editDepth;
+}
+
+void NodeGrid::commitEdit() {
+    if (m_editDepth == 0 || --m_editDepth > 0 || (m_pendingEdits.empty() && m_pendingTerrainEdits.empty()))
+        return;
+
+    // A cell toggled twice in one transaction is reported once
+    std::sort(m_pendingEdits.begin(), m_pendingEdits.end());
+    m_pendingEdits.erase(std::unique(m_pendingEdits.begin(), m_pendingEdits.end()),
+                         m_pendingEdits.end());
+    std::sort(m_pendingTerrainEdits.begin(), m_pendingTerrainEdits.end());
+    m_pendingTerrainEdits.erase(std::unique(m_pendingTerrainEdits.begin(), m_pendingTerrainEdits.end()),
+                                m_pendingTerrainEdits.end());
+
+    if (!m_pendingTerrainEdits.empty())
+        updateTerrainRange();
+
+    ++m_mapRevision;
+    for (auto listener : m_editListeners) {
+        if (!m_pendingEdits.empty())
+            listener->onObstaclesChanged(*this, m_pendingEdits);
+        if (!m_pendingTerrainEdits.empty())
+            listener->onTerrainChanged(*this, m_pendingTerrainEdits);
+    }
+    m_pendingEdits.clear();
+    m_pendingTerrainEdits.clear();
+}
+
+void NodeGrid::updateTerrainRange() {
+    // A layer back to all plain cells is freed
+    if (m_terrainCounts[TERRAIN_PLAIN] == static_cast<uint32_t>(getTotalNodes())) {
+        std::vector<uint8_t>().swap(m_terrain);
+        m_terrainCounts[TERRAIN_PLAIN] = 0;
+        m_minTerrain = m_maxTerrain = TERRAIN_PLAIN;
+        return;
+    }
+
+    m_minTerrain = TERRAIN_PLAIN;
+    while (m_terrainCounts[m_minTerrain] == 0) {
+        ++m_minTerrain;
+    }
+    m_maxTerrain = TERRAIN_MAX;
+    while (m_terrainCounts[m_maxTerrain] == 0) {
+        --m_maxTerrain;
+    }
+}
+
+void NodeGrid::notifyMapReset() {
+    m_pendingEdits.clear();
+    m_pendingTerrainEdits.clear();
+
+    ++m_mapRevision;
+    for (auto listener : m_editListeners) {
+        listener->onMapReset(*this);
+    }
+}
+
+void NodeGrid::addEditListener(GridEditListener* listener) {
+    m_editListeners.push_back(listener);
+}
+
+void NodeGrid::removeEditListener(GridEditListener* listener) {
+    m_editListeners.erase(std::remove(m_editListeners.begin(), m_editListeners.end(), listener),
+                          m_editListeners.end());
+}
+
+void NodeGrid::initGridNodes(int totalNodes) {
+    // One packed array per attribute instead of one heap allocation per node
+    m_obstacles.clearAll();
+    m_columnObstacles.clearAll();
+    m_flags.assign(totalNodes, 0);
+    std::vector<uint8_t>().swap(m_terrain);
+    std::fill(std::begin(m_terrainCounts), std::end(m_terrainCounts), 0);
+    m_minTerrain = m_maxTerrain = TERRAIN_PLAIN;
 
     setStartNode(0);
     setEndNode(totalNodes - 1);
+
+    notifyMapReset();
 }
 
 void NodeGrid::randomizeObstacles() {
-    std::bernoulli_distribution distribution(0.5);
-    
-    for (auto node_ptr : m_NodeGrid) {
-        if (distribution(generator)) {
-            node_ptr->toggleObstacle();
-        }
-    }
+    // Fair coin flip per cell, drawn a whole bitmap word at a time
+    m_obstacles.toggleRandomly(generator);
+
+    // Keep the endpoints reachable candidates
+    m_obstacles.clear(x(startNode), y(startNode));
+    m_obstacles.clear(x(endNode), y(endNode));
+    m_columnObstacles.assignTransposed(m_obstacles);
+
+    notifyMapReset();
 }
 
 void NodeGrid::setStartNode(int nodeId) {
-    if (startNode != nullptr)
-        startNode->clearFlags();
+    if (startNode != INVALID_NODE)
+        m_flags[startNode] &= ~NODE_START;
 
-    m_NodeGrid[nodeId]->setStartNode(true);
-    m_NodeGrid[nodeId]->setDistFromStart(0.0);
-    startNode = m_NodeGrid[nodeId];
+    setObstacle(nodeId, false);
+    m_flags[nodeId] |= NODE_START;
+    startNode = nodeId;
 }
 
 void NodeGrid::setEndNode(int nodeId) {
-    if (endNode != nullptr)
-        endNode->clearFlags();
+    if (endNode != INVALID_NODE)
+        m_flags[endNode] &= ~NODE_END;
 
-    m_NodeGrid[nodeId]->setEndNode(true);
-    m_NodeGrid[nodeId]->setDistToEnd(0.0);
-    endNode = m_NodeGrid[nodeId];
+    setObstacle(nodeId, false);
+    m_flags[nodeId] |= NODE_END;
+    endNode = nodeId;
 }
 
-void NodeGrid::updateNodeAdjacency() {
-    m_shortestPath.clear();
-    m_visitedNodes.clear();
-    
-    for (auto node : m_NodeGrid) {
-        node->setVisited(false);
-        node->parent = nullptr;
-        node->adjNodes.clear();
+void NodeGrid::resetSearch() {
+    // Invalidates all per-node search state in O(1)
+    m_context.reset();
+    m_anytimeSolutions.clear();
+}
 
-        auto addAdjNode = [&](int x_adj, int y_adj) {
-            int adj_nid = y_adj * m_columns + x_adj;
+// Floor and ceiling of a / b for b > 0
+static int64_t floorDiv(int64_t a, int64_t b) { return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+static int64_t ceilDiv(int64_t a, int64_t b)  { return -floorDiv(-a, b); }
+
+// a / b for b > 0 as a quotient and remainder, advanced by a fixed step
+// of a without dividing again
+struct SteppedQuotient {
+    SteppedQuotient(int64_t a, int64_t b, int64_t step)
+        : q(floorDiv(a, b)), rem(a - q * b), den(b)
+        , stepQ(floorDiv(step, b)), stepRem(step - stepQ * b) {}
+
+    int64_t floor() const { return q; }
+    int64_t ceil()  const { return q + (rem != 0); }
+
+    void advance() {
+        q += stepQ;
+        rem += stepRem;
+        if (rem >= den) {
+            rem -= den;
+            ++q;
+        }
+    }
 
-            if (!m_NodeGrid[adj_nid]->isObstacle()) {
-                node->adjNodes.emplace_back(m_NodeGrid[adj_nid]);
-            }
-        };
-
-        if (!node->isObstacle()) {
-            // if x > 0 check left
-            if(node->x() > 0) {
-                addAdjNode(node->x() - 1, node->y());
-                // if y > 0 check top left corner
-                if(node->y() > 0)  {
-                    addAdjNode(node->x() - 1, node->y() - 1);
-                }
-                // if y < N check bottom left corner
-                if(node->y() < m_rows - 1)  {
-                    addAdjNode(node->x() - 1, node->y() + 1);
-                }
-            }
-            // if x < N check right
-            if(node->x() < m_columns - 1) {
-                addAdjNode(node->x() + 1, node->y());
-                // if y > 0 check top right corner
-                if(node->y() > 0)  {
-                    addAdjNode(node->x() + 1, node->y() - 1);
-                }
-                // if y < N check bottom right corner
-                if(node->y() < m_rows - 1)  {
-                    addAdjNode(node->x() + 1, node->y() + 1);
-                }
-            }
-            // if y > 0 check top
-            if(node->y() > 0) {
-                addAdjNode(node->x(), node->y() - 1);
-                
+    int64_t q, rem, den, stepQ, stepRem;
+};
+
+// Line of sight between cell centers (x0, y0) and (x1, y1) of bitmap,
+// checked row by row. Touching a corner follows rule, which is symmetric
+// in x and y, so the same check runs on the transposed bitmap.
+static bool hasRowLineOfSight(const ObstacleBitmap& bitmap, int x0, int y0, int x1, int y1,
+                              CornerRule rule) {
+    if (y0 > y1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    if (y0 == y1)
+        return bitmap.isRowSpanFree(y0, std::min(x0, x1), std::max(x0, x1));
+
+    int64_t dx = x1 - x0;
+    int64_t dy = y1 - y0;
+
+    // In half cells, the segment is at 2x = 2 x0 + dx t / dy at height
+    // t above y0, and row r spans t in [2 (r - y0) - 1, 2 (r - y0) + 1].
+    // Cell c of the row is entered if its open x interval overlaps that
+    // of the segment within the row; under no cutting, touched if the
+    // closed ones do. Everything is scaled by 2 dy to stay integral, and
+    // both ends of the interval move by 2 dx from one row to the next.
+    bool closed = (rule == CornerRule::NO_CUTTING);
+    auto rowSpanFree = [&](int r, int64_t lo, int64_t hi) {
+        int64_t cellLo = closed ? ceilDiv(lo, 2 * dy) : floorDiv(lo, 2 * dy) + 1;
+        int64_t cellHi = closed ? floorDiv(hi, 2 * dy) : ceilDiv(hi, 2 * dy) - 1;
+        return bitmap.isRowSpanFree(r, static_cast<int>(cellLo), static_cast<int>(cellHi));
+    };
+
+    // The end rows only hold half of the segment's height. Rows are
+    // checked from the start, so blocked segments stop early.
+    if (!rowSpanFree(y0, (2 * x0 - 1) * dy + std::min<int64_t>(0, dx),
+                         (2 * x0 + 1) * dy + std::max<int64_t>(0, dx)))
+        return false;
+
+    SteppedQuotient lo((2 * x0 - 1) * dy + dx + std::min<int64_t>(0, 2 * dx), 2 * dy, 2 * dx);
+    SteppedQuotient hi((2 * x0 + 1) * dy + dx + std::max<int64_t>(0, 2 * dx), 2 * dy, 2 * dx);
+
+    for (int r = y0 + 1; r < y1; ++r) {
+        int cellLo = static_cast<int>(closed ? lo.ceil() : lo.floor() + 1);
+        int cellHi = static_cast<int>(closed ? hi.floor() : hi.ceil() - 1);
+        if (!bitmap.isRowSpanFree(r, cellLo, cellHi))
+            return false;
+        lo.advance();
+        hi.advance();
+    }
+    if (!rowSpanFree(y1, (2 * x0 - 1) * dy + std::min(dx * (2 * dy - 1), 2 * dx * dy),
+                         (2 * x0 + 1) * dy + std::max(dx * (2 * dy - 1), 2 * dx * dy)))
+        return false;
+
+    // Passing exactly through the corner between rows r and r + 1, at
+    // 2x = 2 x0 + dx (2 (r - y0) + 1) / dy, squeezes between the two cells
+    // the segment does not enter there
+    if (rule == CornerRule::NO_SQUEEZE) {
+        SteppedQuotient corner(2 * x0 * dy + dx, dy, 2 * dx);
+        for (int r = y0; r < y1; ++r, corner.advance()) {
+            if (corner.rem != 0 || !(corner.q & 1))
+                continue;
+            int c = static_cast<int>(floorDiv(corner.q - 1, 2));
+            bool first  = bitmap.test((dx > 0) ? c + 1 : c, r);
+            bool second = bitmap.test((dx > 0) ? c : c + 1, r + 1);
+            if (first && second)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool NodeGrid::hasLineOfSight(NodeId from, NodeId to) const {
+    static constexpr int END_CELLS = 2;
+
+    CornerRule rule = (m_connectivity == Connectivity::FOUR) ? CornerRule::NO_CUTTING : m_cornerRule;
+    int x0 = x(from), y0 = y(from);
+    int x1 = x(to),   y1 = y(to);
+    int dx = x1 - x0, dy = y1 - y0;
+
+    // On dense maps most blocked segments are blocked within a cell or two
+    // of an end. Walking those cells from both ends (Amanatides & Woo)
+    // settles them with a few bit tests, before any division sets up the
+    // spans. Exact corners are passed diagonally, so the walk only tests
+    // cells the segment enters, which block it under every corner rule.
+    int adx = std::abs(dx), ady = std::abs(dy);
+    int stepX = (dx > 0) - (dx < 0), stepY = (dy > 0) - (dy < 0);
+    int crossX = 1, crossY = 1;    // next boundary at crossX / (2 adx) and crossY / (2 ady)
+    int ax = x0, ay = y0, bx = x1, by = y1;
+
+    for (int cell = 0; cell < END_CELLS && (ax != x1 || ay != y1); ++cell) {
+        int order = crossX * ady - crossY * adx;
+        if (order <= 0) {
+            ax += stepX;
+            bx -= stepX;
+            crossX += 2;
+        }
+        if (order >= 0) {
+            ay += stepY;
+            by -= stepY;
+            crossY += 2;
+        }
+        if (m_obstacles.test(ax, ay) || m_obstacles.test(bx, by))
+            return false;
+    }
+
+    // Fewer, longer spans along the major axis
+    if (adx >= ady)
+        return hasRowLineOfSight(m_obstacles, x0, y0, x1, y1, rule);
+    return hasRowLineOfSight(m_columnObstacles, y0, x0, y1, x1, rule);
+}
+
+template <typename Heuristic>
+void NodeGrid::runAStar(NodeId start, NodeId goal, const Heuristic& heuristic,
+                        SearchContext& context) const {
+    if (m_terrain.empty())
+        runAStarWithCost<FixedCost>(start, goal, heuristic, context);
+    else
+        runAStarWithCost<TerrainCost>(start, goal, heuristic, context);
+}
+
+template <typename CostModel, typename Heuristic>
+void NodeGrid::runAStarWithCost(NodeId start, NodeId goal, const Heuristic& heuristic,
+                                SearchContext& context) const {
+    if (m_connectivity == Connectivity::FOUR)
+        runAStar<FourConnected, CornerCutting, CostModel>(start, goal, heuristic, context);
+    else if (m_cornerRule == CornerRule::NO_SQUEEZE)
+        runAStar<EightConnected, NoSqueezing, CostModel>(start, goal, heuristic, context);
+    else if (m_cornerRule == CornerRule::NO_CUTTING)
+        runAStar<EightConnected, NoCornerCutting, CostModel>(start, goal, heuristic, context);
+    else
+        runAStar<EightConnected, CornerCutting, CostModel>(start, goal, heuristic, context);
+}
+
+template <typename Heuristic>
+void NodeGrid::runWeightedAStar(NodeId start, NodeId goal, const Heuristic& heuristic,
+                                SearchContext& context) const {
+    Cost weight = static_cast<Cost>(std::lround(m_weight * 1000.0f));
+
+    if (weight <= WeightedHeuristic<Heuristic>::WEIGHT_ONE)
+        runAStar(start, goal, heuristic, context);
+    else
+        runAStar(start, goal, WeightedHeuristic<Heuristic>(heuristic, weight), context);
+}
+
+template <typename Connectivity, typename Corners, typename CostModel, typename Heuristic>
+void NodeGrid::runAStar(NodeId start, NodeId goal, const Heuristic& heuristic,
+                        SearchContext& context) const {
+    PolicySearch<Connectivity, Corners, CostModel> search(*this, context.search);
+    std::deque<TraceEntry>* trace = context.recordTrace ? &context.visited : nullptr;
+
+    if (m_openListType == OpenListType::BUCKET)
+        search.solve(start, goal, context.bucketOpenList, heuristic, context.stats, trace);
+    else
+        search.solve(start, goal, context.heapOpenList, heuristic, context.stats, trace);
+}
+
+void NodeGrid::buildShortestPath(NodeId goal, SearchContext& context) const {
+    // Parents may be several cells away (jump points), so fill in the
+    // diagonal-then-straight run between each node and its parent
+    NodeId current = goal;
+
+    while (current != INVALID_NODE) {
+        NodeId parent = context.search.parent(current);
+        context.path.push_back(current);
+
+        if (parent != INVALID_NODE) {
+            int cell_x = x(current);
+            int cell_y = y(current);
+
+            while (true) {
+                cell_x += (x(parent) > cell_x) - (x(parent) < cell_x);
+                cell_y += (y(parent) > cell_y) - (y(parent) < cell_y);
+                if (nodeAt(cell_x, cell_y) == parent)
+                    break;
+                context.path.push_back(nodeAt(cell_x, cell_y));
             }
-            // if y < N check bottom
-            if(node->y() < m_rows - 1) {
-                addAdjNode(node->x(), node->y() + 1);
+        }
+        current = parent;
+    }
+}
+
+bool NodeGrid::solve(NodeId start, NodeId goal, SearchContext& context) const {
+    context.allocate(getTotalNodes(), true, m_solverType == SolverType::BIDIRECTIONAL);
+    context.reset();
+
+    if (m_useComponents && m_componentMap && m_componentMap->isCurrent(*this) &&
+        !m_componentMap->connected(start, goal))
+        return false;
+
+    // Any-angle segments would have to weigh every cell they cross
+    bool isAnyAngle = (m_solverType == SolverType::THETA || m_solverType == SolverType::LAZY_THETA);
+
+    if (m_solverType == SolverType::BIDIRECTIONAL) {
+        BidirectionalSolver bidir(*this, context.search, context.heapOpenList,
+                                  context.reverseSearch, context.reverseOpenList);
+        if (bidir.solve(start, goal, context.stats, context.visited)) {
+            bidir.buildPath(context.path);
+            context.pathCost = bidir.pathCost();
+            context.pathBound = 1.0f;
+        }
+    }
+    else if (isAnyAngle && m_terrain.empty()) {
+        ThetaSolver theta(*this, context.search, context.heapOpenList,
+                          m_solverType == SolverType::LAZY_THETA);
+        if (theta.solve(start, goal, context.stats, context.visited)) {
+            theta.buildPath(context.path);
+            context.pathCost = context.search.gRaw(goal);
+        }
+    }
+    else if (m_solverType == SolverType::CPD && m_pathDatabase && m_pathDatabase->isCurrent(*this)) {
+        Cost cost;
+        if (m_pathDatabase->extractPath(start, goal, context.path, cost)) {
+            context.pathCost = cost;
+            context.pathBound = 1.0f;
+        }
+    }
+    else {
+        float bound = 1.0f;
+
+        if ((m_solverType == SolverType::JPS || m_solverType == SolverType::JPS_PLUS) && canJump()) {
+            const JpsPlusTable* table = (m_solverType == SolverType::JPS_PLUS) ? m_jpsPlusTable.get() : nullptr;
+            JpsSolver jps(*this, context.search, context.heapOpenList, table);
+            jps.solve(start, goal, context.stats, context.visited);
+        }
+        else if (m_useLandmarks && m_landmarkTable && m_landmarkTable->isCurrent(*this)) {
+            runWeightedAStar(start, goal, LandmarkHeuristic(*this, *m_landmarkTable, goal), context);
+            bound = m_weight;
+        }
+        else {
+            bool isFour = (m_connectivity == Connectivity::FOUR);
+            bound = m_weight;
+
+            switch (m_heuristicType) {
+                case HeuristicType::MANHATTAN:
+                    runWeightedAStar(start, goal, GoalDistance<ManhattanDistance, FixedCost>(m_columns, goal, m_minTerrain), context);
+                    if (!isFour)
+                        bound = INFINITY;    // overestimates diagonal moves
+                    break;
+                case HeuristicType::EUCLIDEAN:
+                    runWeightedAStar(start, goal, GoalDistance<EuclideanDistance, FixedCost>(m_columns, goal, m_minTerrain), context);
+                    break;
+                case HeuristicType::ZERO:
+                    runWeightedAStar(start, goal, GoalDistance<ZeroDistance, FixedCost>(m_columns, goal, m_minTerrain), context);
+                    break;
+                default:
+                    if (isFour)
+                        runWeightedAStar(start, goal, GoalDistance<ManhattanDistance, FixedCost>(m_columns, goal, m_minTerrain), context);
+                    else
+                        runWeightedAStar(start, goal, GoalDistance<OctileDistance, FixedCost>(m_columns, goal, m_minTerrain), context);
+                    break;
             }
         }
 
+        if (context.search.isClosed(goal)) {
+            buildShortestPath(goal, context);
+            context.pathCost = context.search.gRaw(goal);
+            context.pathBound = bound;
+        }
     }
+
+    // The solvers above always record; the policy search only when asked
+    if (!context.recordTrace)
+        context.visited.clear();
+    return context.pathCost != COST_INFINITY;
 }
 
-void NodeGrid::solvePath() {
-    // (A*) using A-Star algorithm
-    if (startNode == nullptr || endNode == nullptr)
-        return;
+uint64_t NodeGrid::solverSettings() const {
+    uint32_t weightBits;
+    std::memcpy(&weightBits, &m_weight, sizeof(weightBits));
+
+    return uint64_t(weightBits) << 32 |
+           uint64_t(m_solverType) << 16 |
+           uint64_t(m_heuristicType) << 12 |
+           uint64_t(m_cornerRule) << 8 |
+           uint64_t(m_connectivity) << 4 |
+           uint64_t(m_openListType) << 2 |
+           uint64_t(m_useLandmarks) << 1 |
+           uint64_t(m_useAdaptive);
+}
 
+void NodeGrid::prepareQueries() {
+    if (m_solverType == SolverType::JPS_PLUS && canJump())
+        getJpsPlusTable();
+    if (m_useLandmarks)
+        getLandmarkTable();
+    if (m_useComponents)
+        getComponentMap();
+}
 
-    auto euclidean_dist = [](NodePtr node_A, 
-                                NodePtr node_B) 
-    {
-        float x_A = static_cast<float>(node_A->x());
-        float y_A = static_cast<float>(node_A->y());
-        float x_B = static_cast<float>(node_B->x());
-        float y_B = static_cast<float>(node_B->y());
+BatchStats NodeGrid::solveBatch(BatchQuery* queries, size_t count, unsigned numThreads) {
+    if (!m_queryPool || (numThreads && m_queryPool->threadCount() != numThreads)) {
+        m_queryPool.reset();
+        m_queryPool.reset(new QueryPool(numThreads));
+    }
+    prepareQueries();
 
-        float xx = x_A - x_B;
-        float yy = y_A - y_B;
+    unsigned threads = m_queryPool->threadCount();
+    while (m_batchContexts.size() < threads) {
+        m_batchContexts.emplace_back(new SearchContext());
+        m_batchContexts.back()->recordTrace = false;
+    }
 
-        return std::sqrt(xx * xx + yy * yy);
+    // Per-worker counters, a cache line each
+    struct alignas(64) WorkerTotals {
+        uint64_t expansions = 0;
+        size_t solved = 0;
     };
+    std::vector<WorkerTotals> totals(threads);
+
+    BatchStats stats;
+    stats.queries = count;
+    stats.threads = threads;
+
+    auto begin = std::chrono::steady_clock::now();
+    stats.steals = m_queryPool->run(count, [&](unsigned worker, size_t index) {
+        auto queryBegin = std::chrono::steady_clock::now();
+        SearchContext& context = *m_batchContexts[worker];
+        BatchQuery& query = queries[index];
+
+        query.length = 0;
+        query.cost = COST_INFINITY;
+        if (solve(query.start, query.goal, context)) {
+            size_t copied = std::min<size_t>(context.path.size(), query.capacity);
+            std::copy(context.path.begin(), context.path.begin() + copied, query.path);
+            query.length = static_cast<uint32_t>(context.path.size());
+            query.cost = context.pathCost;
+            ++totals[worker].solved;
+        }
+        totals[worker].expansions += context.stats.expansions;
 
-    class pQueueCompare {
-        public:
-        bool operator() (const NodePtr& node_A,
-                            const NodePtr& node_B)
-        {
-            float heuristic_A = node_A->distFromStart() + node_A->distToEnd();
-            float heuristic_B = node_B->distFromStart() + node_B->distToEnd();
+        query.latencyUs = std::chrono::duration<float, std::micro>(
+                              std::chrono::steady_clock::now() - queryBegin).count();
+    });
+    stats.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
 
-            return (heuristic_A > heuristic_B);
-        }
-    };
+    for (auto& total : totals) {
+        stats.expansions += total.expansions;
+        stats.solved += total.solved;
+    }
+    if (count == 0)
+        return stats;
+
+    std::vector<float> latencies(count);
+    for (size_t i = 0; i < count; ++i) {
+        latencies[i] = queries[i].latencyUs;
+        stats.meanLatencyUs += latencies[i];
+    }
+    stats.meanLatencyUs /= count;
+    stats.queriesPerSecond = count / (stats.wallMs / 1000.0);
+
+    std::nth_element(latencies.begin(), latencies.begin() + count / 2, latencies.end());
+    stats.p50LatencyUs = latencies[count / 2];
+    std::nth_element(latencies.begin(), latencies.begin() + count * 99 / 100, latencies.end());
+    stats.p99LatencyUs = latencies[count * 99 / 100];
+    stats.maxLatencyUs = *std::max_element(latencies.begin(), latencies.end());
+    return stats;
+}
 
-    std::priority_queue<NodePtr, std::vector<NodePtr>, pQueueCompare> pQueue;
-    startNode->setVisited(true);
-    pQueue.push(startNode);
+void NodeGrid::solvePath() {
+    // (A*) using A-Star algorithm
+    if (startNode == INVALID_NODE || endNode == INVALID_NODE)
+        return;
 
-    while (pQueue.top() != endNode && !pQueue.empty()) {
-        auto current = pQueue.top();
+    resetSearch();
 
-        if (current->isVisited())
-            pQueue.pop();
+    // No solver can join two regions, so none has to flood one to see it
+    if (m_useComponents && !getComponentMap().connected(startNode, endNode)) {
+        if (m_verbose)
+            printf("No path: start and end node are in different regions\n");
+        return;
+    }
 
-        for (auto adj : current->adjNodes) {
-            if (!adj->isVisited()) {
-                adj->parent = current;
-                adj->setDistFromStart(current->distFromStart() + euclidean_dist(current, adj));
-                adj->setDistToEnd(euclidean_dist(adj, endNode));
-                adj->setVisited(true);
-                m_visitedNodes.push_back(adj);
+    // Paths of the any-angle solvers are waypoints, not moves, and ARA*
+    // paths depend on its time budget, so neither is cached
+    bool cacheable = (m_solverType != SolverType::ARA && m_solverType != SolverType::THETA &&
+                      m_solverType != SolverType::LAZY_THETA);
+    uint64_t settings = solverSettings();
+    bool cached = cacheable && m_pathCache.lookup(*this, settings, startNode, endNode, m_context.path,
+                                                  m_context.pathCost, m_context.pathBound);
 
-                pQueue.push(adj);
+    // Adaptive A* learns across queries, so it runs here rather than in solve
+    bool isJps = (m_solverType == SolverType::JPS || m_solverType == SolverType::JPS_PLUS);
+
+    if (cached) {
+        // Nothing was searched, the path is all there is
+    }
+    else if (m_solverType == SolverType::DSTAR_LITE) {
+        DStarLite& dstar = getDStarLite();
+        if (dstar.plan(*this, startNode, endNode, m_context.stats, m_context.visited)) {
+            dstar.buildPath(m_context.path);
+            m_context.pathCost = dstar.pathCost();
+            m_context.pathBound = 1.0f;
+        }
+    }
+    else if (m_solverType == SolverType::FRINGE || m_solverType == SolverType::IDA_STAR) {
+        size_t traceLimit = m_memoryLimit / 4 / sizeof(TraceEntry);
+        size_t solverBytes = m_memoryLimit - traceLimit * sizeof(TraceEntry);
+        bool useIdaStar = (m_solverType == SolverType::IDA_STAR);
+
+        if (!useIdaStar) {
+            if (m_fringe.solve(*this, startNode, endNode, solverBytes, traceLimit, m_context.stats,
+                               m_context.visited)) {
+                m_fringe.buildPath(m_context.path);
+                m_context.pathCost = m_fringe.pathCost();
+                m_context.pathBound = 1.0f;
+            }
+            else if (m_fringe.outOfMemory()) {
+                // IDA* keeps no entry per node it reaches, so it still fits
+                if (m_verbose)
+                    printf("Fringe reached more nodes than fit in %zu KB, running IDA*\n",
+                           solverBytes / 1024);
+                m_context.visited.clear();
+                useIdaStar = true;
+            }
+        }
+
+        if (useIdaStar) {
+            if (m_idaStar.solve(*this, startNode, endNode, solverBytes, traceLimit, m_context.stats,
+                                m_context.visited)) {
+                m_idaStar.buildPath(m_context.path);
+                m_context.pathCost = m_idaStar.pathCost();
+                m_context.pathBound = 1.0f;
+            }
+            else if (m_idaStar.outOfMemory() && m_verbose) {
+                printf("No path found: IDA* needs a deeper stack than fits in %zu KB\n",
+                       solverBytes / 1024);
+            }
+        }
+    }
+    else if (m_solverType == SolverType::ARA) {
+        m_context.allocate(getTotalNodes(), true, false);
+
+        auto deadline = AraSolver::Clock::now() +
+                        std::chrono::duration_cast<AraSolver::Clock::duration>(
+                            std::chrono::duration<double, std::milli>(m_anytimeBudgetMs));
+
+        if (m_ara.solve(startNode, endNode, m_anytimeEpsilon, m_context.stats, m_context.visited)) {
+            while (m_ara.improve(deadline, m_context.stats, m_context.visited)) {
+            }
+            m_anytimeSolutions = m_ara.solutions();
+            m_context.path = m_anytimeSolutions.back().path;
+            m_context.pathCost = m_anytimeSolutions.back().cost;
+            m_context.pathBound = m_anytimeSolutions.back().bound;
+
+            if (m_verbose) {
+                for (auto& solution : m_anytimeSolutions) {
+                    printf("ARA* path at %.2f ms: cost %.3f, within %.3f of optimal\n",
+                           solution.elapsedMs, costToFloat(solution.cost), solution.bound);
+                }
             }
         }
     }
-    
-    if (endNode->parent != nullptr) {
-        printf("Solved path from start to end node!!!\n");
-        auto current = endNode;
+    else if (m_solverType == SolverType::HPA) {
+        HpaPath path;
+        if (getHpaMap().findPath(startNode, endNode, path, m_context.stats, &m_context.visited)) {
+            // Refine the whole path at once, stored end to start like the others
+            path.nextSteps(SIZE_MAX, m_context.path);
+            std::reverse(m_context.path.begin(), m_context.path.end());
+            m_context.path.push_back(startNode);
+            m_context.pathCost = path.cost();
+        }
+    }
+    else if (m_useAdaptive && !m_useLandmarks &&
+             (m_solverType == SolverType::ASTAR || (isJps && !canJump()))) {
+        m_context.allocate(getTotalNodes(), true, false);
+
+        getAdaptiveHeuristic();
+        m_adaptiveHeuristic->setGoal(*this, endNode);
+        runWeightedAStar(startNode, endNode, *m_adaptiveHeuristic, m_context);
+
+        // Weighted searches do not settle nodes at their true distance
+        if (m_weight <= 1.0f)
+            m_adaptiveHeuristic->learn(m_context.search, startNode, m_context.visited);
+
+        if (m_context.search.isClosed(endNode)) {
+            buildShortestPath(endNode, m_context);
+            m_context.pathCost = m_context.search.gRaw(endNode);
+            m_context.pathBound = m_weight;
+        }
+    }
+    else {
+        prepareQueries();
+        solve(startNode, endNode, m_context);
+    }
 
-        while (current != nullptr) {
-            printf("[%i] - ", current->nid());
-            m_shortestPath.push_back(current);
-            current = current->parent;
+    if (cacheable && !cached) {
+        m_pathCache.insert(*this, settings, startNode, endNode, m_context.path, m_context.pathCost,
+                           m_context.pathBound);
+    }
+
+    if (m_context.pathCost != COST_INFINITY && m_verbose) {
+        printf("Solved path from start to end node!!! (cost %.3f, %llu expansions)\n",
+               getPathCost(), static_cast<unsigned long long>(m_context.stats.expansions));
+        for (NodeId nid : m_context.path) {
+            printf("[%u] - ", nid);
         }
         printf("\n");
     }
-}
\ No newline at end of file
+}
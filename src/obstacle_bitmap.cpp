@@ -0,0 +1,146 @@
+#include "obstacle_bitmap.hpp"
+#include <algorithm>
+
+ObstacleBitmap::ObstacleBitmap(int width, int height)
+    : m_width(width)
+    , m_height(height)
+    , m_stride((width + 2 + BITS_PER_WORD - 1) / BITS_PER_WORD + 1)
+{
+    m_rowMask.resize(m_stride);
+    for (int w = 0; w < m_stride; ++w) {
+        m_rowMask[w] = rangeMask(w, 1, width + 1);
+    }
+
+    clearAll();
+}
+
+void ObstacleBitmap::clearAll() {
+    // Everything blocked, then open up the map cells of each row
+    m_words.assign(static_cast<size_t>(m_height + 2) * m_stride, ~uint64_t(0));
+
+    for (int y = 0; y < m_height; ++y) {
+        uint64_t* row = rowWords(y);
+        for (int w = 0; w < m_stride; ++w) {
+            row[w] &= ~m_rowMask[w];
+        }
+    }
+}
+
+void ObstacleBitmap::assignTransposed(const ObstacleBitmap& source) {
+    clearAll();
+    for (int y = 0; y < source.height(); ++y) {
+        for (int x = source.findNextObstacle(0, y); x < source.width();
+             x = source.findNextObstacle(x + 1, y)) {
+            set(y, x);
+        }
+    }
+}
+
+void ObstacleBitmap::assignRect(int x0, int y0, int x1, int y1, bool blocked) {
+    if (!clipRect(x0, y0, x1, y1))
+        return;
+
+    int wordLo = (x0 + 1) / BITS_PER_WORD;
+    int wordHi = x1 / BITS_PER_WORD;   // word holding padded bit x1 (= column x1 - 1)
+
+    for (int y = y0; y < y1; ++y) {
+        uint64_t* row = rowWords(y);
+        for (int w = wordLo; w <= wordHi; ++w) {
+            uint64_t mask = rangeMask(w, x0 + 1, x1 + 1);
+            row[w] = blocked ? (row[w] | mask) : (row[w] & ~mask);
+        }
+    }
+}
+
+void ObstacleBitmap::setRect(int x0, int y0, int x1, int y1) {
+    assignRect(x0, y0, x1, y1, true);
+}
+
+void ObstacleBitmap::clearRect(int x0, int y0, int x1, int y1) {
+    assignRect(x0, y0, x1, y1, false);
+}
+
+size_t ObstacleBitmap::countRow(int y) const {
+    const uint64_t* row = rowWords(y);
+    size_t total = 0;
+
+    for (int w = 0; w < m_stride; ++w) {
+        total += __builtin_popcountll(row[w] & m_rowMask[w]);
+    }
+    return total;
+}
+
+size_t ObstacleBitmap::count() const {
+    size_t total = 0;
+    for (int y = 0; y < m_height; ++y) {
+        total += countRow(y);
+    }
+    return total;
+}
+
+size_t ObstacleBitmap::countRect(int x0, int y0, int x1, int y1) const {
+    if (!clipRect(x0, y0, x1, y1))
+        return 0;
+
+    int wordLo = (x0 + 1) / BITS_PER_WORD;
+    int wordHi = x1 / BITS_PER_WORD;
+    size_t total = 0;
+
+    for (int y = y0; y < y1; ++y) {
+        const uint64_t* row = rowWords(y);
+        for (int w = wordLo; w <= wordHi; ++w) {
+            total += __builtin_popcountll(row[w] & rangeMask(w, x0 + 1, x1 + 1));
+        }
+    }
+    return total;
+}
+
+int ObstacleBitmap::findNextObstacle(int x, int y) const {
+    if (x >= m_width)
+        return m_width;
+
+    const uint64_t* row = rowWords(y);
+    int bit = x + 1;
+    int w = bit / BITS_PER_WORD;
+    uint64_t word = row[w] & ~((uint64_t(1) << (bit % BITS_PER_WORD)) - 1);
+
+    // The right guard cell is always blocked, so this terminates in the row
+    while (word == 0) {
+        word = row[++w];
+    }
+
+    int found = w * BITS_PER_WORD + __builtin_ctzll(word) - 1;
+    return std::min(found, m_width);
+}
+
+int ObstacleBitmap::findNextFreeInRow(int x, int y) const {
+    if (x >= m_width)
+        return m_width;
+
+    const uint64_t* row = rowWords(y);
+    int bit = x + 1;
+    int w = bit / BITS_PER_WORD;
+    uint64_t word = ~row[w] & m_rowMask[w] & ~((uint64_t(1) << (bit % BITS_PER_WORD)) - 1);
+
+    while (word == 0) {
+        if (++w >= m_stride)
+            return m_width;
+        word = ~row[w] & m_rowMask[w];
+    }
+
+    return w * BITS_PER_WORD + __builtin_ctzll(word) - 1;
+}
+
+bool ObstacleBitmap::findNextFree(int& x, int& y) const {
+    int col = x;
+
+    for (int row = y; row < m_height; ++row, col = 0) {
+        int found = findNextFreeInRow(col, row);
+        if (found < m_width) {
+            x = found;
+            y = row;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,272 @@
+#include "path_cache.hpp"
+#include "node_grid.hpp"
+#include <algorithm>
+
+PathCache::PathCache(size_t capacity)
+    : m_capacity(capacity)
+    , m_settings(0)
+    , m_revision(0)
+    , m_head(NONE)
+    , m_tail(NONE)
+{
+}
+
+void PathCache::setCapacity(size_t capacity) {
+    m_capacity = capacity;
+    while (m_index.size() > m_capacity) {
+        remove(m_tail);
+        ++m_stats.evictions;
+    }
+}
+
+void PathCache::clear() {
+    m_entries.clear();
+    m_freeSlots.clear();
+    m_index.clear();
+    m_postings.clear();
+    m_head = m_tail = NONE;
+}
+
+size_t PathCache::memoryBytes() const {
+    size_t bytes = m_entries.capacity() * sizeof(Entry);
+    for (const auto& entry : m_entries) {
+        bytes += entry.path.capacity() * sizeof(NodeId) + entry.costs.capacity() * sizeof(Cost);
+    }
+    for (const auto& postings : m_postings) {
+        bytes += sizeof(postings) + postings.second.capacity() * sizeof(Posting);
+    }
+    return bytes + m_index.size() * sizeof(std::pair<uint64_t, uint32_t>);
+}
+
+void PathCache::validate(const NodeGrid& grid, uint64_t settings) {
+    if (settings == m_settings && grid.getMapRevision() == m_revision)
+        return;
+
+    clear();
+    m_settings = settings;
+    m_revision = grid.getMapRevision();
+}
+
+void PathCache::unlink(uint32_t slot) {
+    Entry& entry = m_entries[slot];
+    (entry.prev != NONE ? m_entries[entry.prev].next : m_head) = entry.next;
+    (entry.next != NONE ? m_entries[entry.next].prev : m_tail) = entry.prev;
+}
+
+void PathCache::pushFront(uint32_t slot) {
+    Entry& entry = m_entries[slot];
+    entry.prev = NONE;
+    entry.next = m_head;
+    (m_head != NONE ? m_entries[m_head].prev : m_tail) = slot;
+    m_head = slot;
+}
+
+void PathCache::remove(uint32_t slot) {
+    Entry& entry = m_entries[slot];
+    unlink(slot);
+    m_index.erase(key(entry.start, entry.goal));
+
+    for (NodeId nid : entry.path) {
+        auto found = m_postings.find(nid);
+        std::vector<Posting>& postings = found->second;
+        postings.erase(std::find_if(postings.begin(), postings.end(),
+                                    [&](const Posting& posting) { return posting.slot == slot; }));
+        if (postings.empty())
+            m_postings.erase(found);
+    }
+
+    entry.path = std::vector<NodeId>();
+    entry.costs = std::vector<Cost>();
+    m_freeSlots.push_back(slot);
+}
+
+bool PathCache::isMove(const NodeGrid& grid, NodeId from, NodeId to) {
+    Direction dir = stepDirection(grid.x(to) - grid.x(from), grid.y(to) - grid.y(from));
+    return grid.freeNeighbors(from) & (1u << dir);
+}
+
+bool PathCache::lookup(const NodeGrid& grid, uint64_t settings, NodeId start, NodeId goal,
+                       std::vector<NodeId>& path, Cost& cost, float& bound) {
+    if (m_capacity == 0)
+        return false;
+    validate(grid, settings);
+
+    auto found = m_index.find(key(start, goal));
+    if (found != m_index.end()) {
+        const Entry& entry = m_entries[found->second];
+        path = entry.path;
+        cost = entry.cost;
+        bound = entry.bound;
+
+        unlink(found->second);
+        pushFront(found->second);
+        ++m_stats.hits;
+        return true;
+    }
+
+    // A shortest path through both cells, in either direction
+    auto startPostings = m_postings.find(start);
+    auto goalPostings  = m_postings.find(goal);
+    if (startPostings != m_postings.end() && goalPostings != m_postings.end()) {
+        for (const Posting& from : startPostings->second) {
+            const Entry& entry = m_entries[from.slot];
+            if (entry.bound != 1.0f)
+                continue;
+
+            for (const Posting& to : goalPostings->second) {
+                if (to.slot != from.slot)
+                    continue;
+
+                size_t i = from.position, j = to.position, last = entry.path.size() - 1;
+                if (j <= i)
+                    path.assign(entry.path.begin() + j, entry.path.begin() + i + 1);
+                else
+                    path.assign(entry.path.rbegin() + (last - j), entry.path.rbegin() + (last - i) + 1);
+                cost = entry.costs[std::max(i, j)] - entry.costs[std::min(i, j)];
+                bound = 1.0f;
+
+                unlink(from.slot);
+                pushFront(from.slot);
+                ++m_stats.subpathHits;
+                return true;
+            }
+        }
+    }
+
+    ++m_stats.misses;
+    return false;
+}
+
+void PathCache::insert(const NodeGrid& grid, uint64_t settings, NodeId start, NodeId goal,
+                       const std::vector<NodeId>& path, Cost cost, float bound) {
+    if (m_capacity == 0 || path.empty())
+        return;
+    validate(grid, settings);
+
+    if (m_index.count(key(start, goal)))
+        return;
+    while (m_index.size() >= m_capacity) {
+        remove(m_tail);
+        ++m_stats.evictions;
+    }
+
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<uint32_t>(m_entries.size());
+        m_entries.emplace_back();
+    }
+
+    Entry& entry = m_entries[slot];
+    entry.start = start;
+    entry.goal  = goal;
+    entry.path  = path;
+    entry.cost  = cost;
+    entry.bound = bound;
+    entry.costs.resize(path.size());
+    entry.costs[0] = 0;
+
+    for (size_t i = 1; i < path.size(); ++i) {
+        entry.costs[i] = entry.costs[i - 1] + grid.stepCost(path[i - 1], path[i]);
+    }
+
+    for (size_t i = 0; i < path.size(); ++i) {
+        m_postings[path[i]].push_back(Posting{ slot, static_cast<uint32_t>(i) });
+    }
+    m_index.emplace(key(start, goal), slot);
+    pushFront(slot);
+}
+
+void PathCache::onObstaclesChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    if (m_index.empty() || m_revision + 1 != grid.getMapRevision()) {
+        clear();
+        m_revision = grid.getMapRevision();
+        return;
+    }
+    m_revision = grid.getMapRevision();
+
+    // Diagonals past a cell exist unless corners may be cut
+    bool opensDiagonals = (grid.getConnectivity() == Connectivity::EIGHT &&
+                           grid.getCornerRule() != CornerRule::CUT_CORNERS);
+    std::vector<uint32_t> stale;
+
+    for (NodeId nid : cells) {
+        if (grid.isObstacle(nid)) {
+            // Paths through the cell, and steps around it that are no
+            // longer moves
+            for (int dir = -1; dir < NUM_DIRECTIONS; ++dir) {
+                int cell_x = grid.x(nid) + (dir < 0 ? 0 : DIR_DX[dir]);
+                int cell_y = grid.y(nid) + (dir < 0 ? 0 : DIR_DY[dir]);
+                if (cell_x < 0 || cell_y < 0 || cell_x >= grid.getColumns() || cell_y >= grid.getRows())
+                    continue;
+
+                auto found = m_postings.find(grid.nodeAt(cell_x, cell_y));
+                if (found == m_postings.end())
+                    continue;
+
+                for (const Posting& posting : found->second) {
+                    const std::vector<NodeId>& path = m_entries[posting.slot].path;
+                    size_t i = posting.position;
+
+                    if (dir < 0 || (i > 0 && !isMove(grid, path[i], path[i - 1])) ||
+                        (i + 1 < path.size() && !isMove(grid, path[i], path[i + 1])))
+                        stale.push_back(posting.slot);
+                }
+            }
+        }
+        else {
+            // Paths a detour through the opened cell may beat
+            findBeatable(grid, nid, opensDiagonals ? 2 * COST_DIAGONAL * grid.getMinTerrain() : 0, stale);
+        }
+    }
+    removeStale(stale);
+}
+
+void PathCache::onTerrainChanged(const NodeGrid& grid, const std::vector<NodeId>& cells) {
+    // Obstacles changed in the same commit were handled just before
+    uint32_t revision = grid.getMapRevision();
+    if (m_index.empty() || (m_revision != revision && m_revision + 1 != revision)) {
+        clear();
+        m_revision = revision;
+        return;
+    }
+    m_revision = revision;
+
+    std::vector<uint32_t> stale;
+    for (NodeId nid : cells) {
+        auto found = m_postings.find(nid);
+        if (found != m_postings.end()) {
+            for (const Posting& posting : found->second) {
+                stale.push_back(posting.slot);
+            }
+        }
+        findBeatable(grid, nid, 0, stale);
+    }
+    removeStale(stale);
+}
+
+void PathCache::findBeatable(const NodeGrid& grid, NodeId nid, Cost slack, std::vector<uint32_t>& stale) const {
+    for (const auto& indexed : m_index) {
+        const Entry& entry = m_entries[indexed.second];
+        Cost through = grid.heuristicCost(entry.start, nid) + grid.heuristicCost(nid, entry.goal);
+        if (through < entry.cost + slack)
+            stale.push_back(indexed.second);
+    }
+}
+
+void PathCache::removeStale(std::vector<uint32_t>& stale) {
+    std::sort(stale.begin(), stale.end());
+    stale.erase(std::unique(stale.begin(), stale.end()), stale.end());
+    for (uint32_t slot : stale) {
+        remove(slot);
+    }
+    m_stats.invalidations += stale.size();
+}
+
+void PathCache::onMapReset(const NodeGrid& grid) {
+    clear();
+    m_revision = grid.getMapRevision();
+}
@@ -0,0 +1,359 @@
+#include "path_database.hpp"
+#include "indexed_heap.hpp"
+#include "node_grid.hpp"
+#include "run_on_threads.hpp"
+#include "search_state.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+static const char FILE_MAGIC[8] = { 'A', 'S', 'T', 'A', 'R', 'C', 'P', 'D' };
+static constexpr uint32_t FILE_VERSION = 1;
+
+// Position of (x, y) along the Hilbert curve over an n x n square, n a
+// power of two
+static uint64_t hilbertIndex(uint32_t n, uint32_t x, uint32_t y) {
+    uint64_t index = 0;
+
+    for (uint32_t s = n / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        index += uint64_t(s) * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant so the curve continues where it left off
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+// One-to-all Dijkstra from source that keeps, per reached node, the set
+// of first moves (bits by Direction) that start an optimal path to it
+static void firstMovesFrom(const NodeGrid& grid, NodeId source, SearchState& state,
+                           IndexedHeap<Cost>& openList, std::vector<uint8_t>& moves) {
+    state.beginQuery();
+    openList.clear();
+
+    state.open(source, 0, 0, INVALID_NODE);
+    openList.push(source, 0, 0);
+    moves[source] = 0;
+
+    while (!openList.empty()) {
+        NodeId current = openList.pop();
+        state.close(current);
+        Cost currentG = state.gRaw(current);
+
+        grid.forEachNeighbor(current, [&](NodeId adj, Direction dir) {
+            SearchState::Status status = state.status(adj);
+            if (status == SearchState::CLOSED)
+                return;
+
+            Cost adjG = currentG + grid.stepCost(current, adj, dir);
+            uint8_t via = (current == source) ? uint8_t(1u << dir) : moves[current];
+
+            if (status == SearchState::UNSEEN) {
+                state.open(adj, adjG, 0, current);
+                openList.push(adj, adjG, 0);
+                moves[adj] = via;
+            }
+            else if (adjG < state.gRaw(adj)) {
+                state.relax(adj, adjG, current);
+                openList.decreaseKey(adj, adjG);
+                moves[adj] = via;
+            }
+            else if (adjG == state.gRaw(adj)) {
+                moves[adj] |= via;
+            }
+        });
+    }
+}
+
+PathDatabase::PathDatabase()
+    : m_grid(nullptr)
+    , m_stale(true)
+    , m_rows(0)
+    , m_columns(0)
+    , m_connectivity(Connectivity::EIGHT)
+    , m_cornerRule(CornerRule::CUT_CORNERS)
+    , m_runBegin(nullptr)
+    , m_rank(nullptr)
+    , m_runs(nullptr)
+    , m_numRuns(0)
+    , m_mapping(nullptr)
+    , m_mappingBytes(0)
+{
+}
+
+PathDatabase::~PathDatabase() {
+    unmap();
+}
+
+void PathDatabase::unmap() {
+    if (m_mapping)
+        munmap(m_mapping, m_mappingBytes);
+    m_mapping = nullptr;
+    m_mappingBytes = 0;
+}
+
+bool PathDatabase::isCurrent(const NodeGrid& grid) const {
+    return !m_stale && m_grid == &grid && m_rows == grid.getRows() &&
+           m_columns == grid.getColumns() && m_connectivity == grid.getConnectivity() &&
+           m_cornerRule == grid.getCornerRule();
+}
+
+std::vector<uint32_t> PathDatabase::rankCells(const NodeGrid& grid) {
+    uint32_t side = 1;
+    while (side < static_cast<uint32_t>(std::max(grid.getRows(), grid.getColumns()))) {
+        side *= 2;
+    }
+
+    std::vector<std::pair<uint64_t, NodeId>> curve(grid.getTotalNodes());
+    for (NodeId nid = 0; nid < curve.size(); ++nid) {
+        curve[nid] = std::make_pair(hilbertIndex(side, grid.x(nid), grid.y(nid)), nid);
+    }
+    std::sort(curve.begin(), curve.end());
+
+    std::vector<uint32_t> rank(curve.size());
+    for (uint32_t i = 0; i < curve.size(); ++i) {
+        rank[curve[i].second] = i;
+    }
+    return rank;
+}
+
+void PathDatabase::rebuild(const NodeGrid& grid, unsigned numThreads) {
+    static constexpr size_t SOURCES_PER_CHUNK = 64;
+
+    unmap();
+    m_grid         = &grid;
+    m_rows         = grid.getRows();
+    m_columns      = grid.getColumns();
+    m_connectivity = grid.getConnectivity();
+    m_cornerRule   = grid.getCornerRule();
+    m_stale        = false;
+
+    size_t numNodes = grid.getTotalNodes();
+    m_ownRank = rankCells(grid);
+    std::vector<NodeId> byRank(numNodes);
+    for (NodeId nid = 0; nid < numNodes; ++nid) {
+        byRank[m_ownRank[nid]] = nid;
+    }
+
+    // Sources go in chunks, each into a buffer of its own, joined in order
+    // once all are done
+    size_t numChunks = (numNodes + SOURCES_PER_CHUNK - 1) / SOURCES_PER_CHUNK;
+    std::vector<std::vector<uint32_t>> chunkRuns(numChunks);
+    std::vector<uint32_t> sourceRuns(numNodes, 0);
+
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::max(1u, std::min(numThreads, static_cast<unsigned>(numChunks)));
+
+    std::atomic<size_t> next(0);
+    auto worker = [&](unsigned) {
+        SearchState state(numNodes);
+        IndexedHeap<Cost> openList(numNodes);
+        std::vector<uint8_t> moves(numNodes);
+
+        for (size_t chunk = next++; chunk < numChunks; chunk = next++) {
+            std::vector<uint32_t>& runs = chunkRuns[chunk];
+            NodeId end = static_cast<NodeId>(std::min(numNodes, (chunk + 1) * SOURCES_PER_CHUNK));
+
+            for (NodeId source = chunk * SOURCES_PER_CHUNK; source < end; ++source) {
+                if (grid.isObstacle(source))
+                    continue;
+                firstMovesFrom(grid, source, state, openList, moves);
+
+                // Greedy runs: extend while some move suits every target so
+                // far; the source and unreachable cells suit any move
+                size_t before = runs.size();
+                uint32_t runStart = 0;
+                uint8_t open = 0xFF;
+
+                for (uint32_t rank = 0; rank < numNodes; ++rank) {
+                    NodeId target = byRank[rank];
+                    uint8_t allowed = (target != source && state.isClosed(target)) ? moves[target] : 0xFF;
+
+                    if (open & allowed) {
+                        open &= allowed;
+                        continue;
+                    }
+                    runs.push_back(runStart << MOVE_BITS | __builtin_ctz(open));
+                    runStart = rank;
+                    open = allowed;
+                }
+                runs.push_back(runStart << MOVE_BITS | __builtin_ctz(open));
+                sourceRuns[source] = static_cast<uint32_t>(runs.size() - before);
+            }
+        }
+    };
+
+    runOnThreads(numThreads, worker);
+
+    m_ownRunBegin.assign(numNodes + 1, 0);
+    for (size_t nid = 0; nid < numNodes; ++nid) {
+        m_ownRunBegin[nid + 1] = m_ownRunBegin[nid] + sourceRuns[nid];
+    }
+    m_ownRuns.clear();
+    m_ownRuns.reserve(m_ownRunBegin.back());
+    for (auto& runs : chunkRuns) {
+        m_ownRuns.insert(m_ownRuns.end(), runs.begin(), runs.end());
+    }
+
+    m_runBegin = m_ownRunBegin.data();
+    m_rank     = m_ownRank.data();
+    m_runs     = m_ownRuns.data();
+    m_numRuns  = m_ownRuns.size();
+}
+
+int PathDatabase::firstMove(NodeId from, NodeId goal) const {
+    const uint32_t* begin = m_runs + m_runBegin[from];
+    const uint32_t* end   = m_runs + m_runBegin[from + 1];
+    if (from == goal || begin == end)
+        return NO_MOVE;
+
+    // Last run starting at or before the goal's rank
+    const uint32_t* run = std::upper_bound(begin, end, (m_rank[goal] << MOVE_BITS) | MOVE_MASK);
+    return static_cast<int>(run[-1] & MOVE_MASK);
+}
+
+bool PathDatabase::extractPath(NodeId start, NodeId goal, std::vector<NodeId>& path, Cost& cost) const {
+    path.clear();
+    cost = 0;
+    if (m_grid->isObstacle(start) || m_grid->isObstacle(goal))
+        return false;
+
+    // A goal out of reach reads as arbitrary moves, which sooner or later
+    // hit a wall or outlast every free cell
+    size_t maxSteps = static_cast<size_t>(m_rows) * m_columns;
+    NodeId current = start;
+    path.push_back(start);
+
+    while (current != goal) {
+        int dir = firstMove(current, goal);
+        if (dir == NO_MOVE || !(m_grid->freeNeighbors(current) & (1u << dir)) || path.size() > maxSteps) {
+            path.clear();
+            cost = 0;
+            return false;
+        }
+
+        NodeId next = m_grid->nodeAt(m_grid->x(current) + DIR_DX[dir], m_grid->y(current) + DIR_DY[dir]);
+        cost += m_grid->stepCost(current, next, static_cast<Direction>(dir));
+        current = next;
+        path.push_back(current);
+    }
+
+    // End to start, like the searched paths
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+size_t PathDatabase::memoryBytes() const {
+    if (!m_runs)
+        return 0;
+    size_t numNodes = static_cast<size_t>(m_rows) * m_columns;
+    return (numNodes + 1) * sizeof(uint64_t) + numNodes * sizeof(uint32_t) + m_numRuns * sizeof(uint32_t);
+}
+
+bool PathDatabase::save(const char* path) const {
+    if (!m_grid || !m_runs)
+        return false;
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    FileHeader header;
+    memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version      = FILE_VERSION;
+    header.rows         = static_cast<uint32_t>(m_rows);
+    header.columns      = static_cast<uint32_t>(m_columns);
+    header.connectivity = static_cast<uint32_t>(m_connectivity);
+    header.cornerRule   = static_cast<uint32_t>(m_cornerRule);
+    header.reserved     = 0;
+    header.fingerprint  = m_grid->getMapFingerprint();
+    header.numRuns      = m_numRuns;
+
+    size_t numNodes = static_cast<size_t>(m_rows) * m_columns;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(m_runBegin, sizeof(uint64_t), numNodes + 1, file) == numNodes + 1 &&
+              fwrite(m_rank, sizeof(uint32_t), numNodes, file) == numNodes &&
+              fwrite(m_runs, sizeof(uint32_t), m_numRuns, file) == m_numRuns;
+
+    return (fclose(file) == 0) && ok;
+}
+
+bool PathDatabase::load(const NodeGrid& grid, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    size_t bytes = 0;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(FileHeader)) {
+        bytes = static_cast<size_t>(info.st_size);
+        mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    const FileHeader& header = *static_cast<const FileHeader*>(mapping);
+    size_t numNodes = grid.getTotalNodes();
+    size_t tables = (numNodes + 1) * sizeof(uint64_t) + numNodes * sizeof(uint32_t);
+
+    bool ok = memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+              header.version == FILE_VERSION &&
+              header.rows == static_cast<uint32_t>(grid.getRows()) &&
+              header.columns == static_cast<uint32_t>(grid.getColumns()) &&
+              header.connectivity == static_cast<uint32_t>(grid.getConnectivity()) &&
+              header.cornerRule == static_cast<uint32_t>(grid.getCornerRule()) &&
+              header.fingerprint == grid.getMapFingerprint() &&
+              header.numRuns <= bytes / sizeof(uint32_t) &&
+              bytes == sizeof(FileHeader) + tables + header.numRuns * sizeof(uint32_t);
+
+    if (!ok) {
+        munmap(mapping, bytes);
+        return false;
+    }
+
+    unmap();
+    m_ownRunBegin = std::vector<uint64_t>();
+    m_ownRank     = std::vector<uint32_t>();
+    m_ownRuns     = std::vector<uint32_t>();
+    m_mapping      = mapping;
+    m_mappingBytes = bytes;
+
+    const char* base = static_cast<const char*>(mapping) + sizeof(FileHeader);
+    m_runBegin = reinterpret_cast<const uint64_t*>(base);
+    m_rank     = reinterpret_cast<const uint32_t*>(base + (numNodes + 1) * sizeof(uint64_t));
+    m_runs     = m_rank + numNodes;
+    m_numRuns  = header.numRuns;
+
+    m_grid         = &grid;
+    m_rows         = grid.getRows();
+    m_columns      = grid.getColumns();
+    m_connectivity = grid.getConnectivity();
+    m_cornerRule   = grid.getCornerRule();
+    m_stale        = false;
+    return true;
+}
+
+void PathDatabase::onObstaclesChanged(const NodeGrid&, const std::vector<NodeId>&) {
+    m_stale = true;
+}
+
+void PathDatabase::onMapReset(const NodeGrid&) {
+    m_stale = true;
+}
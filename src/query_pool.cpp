@@ -0,0 +1,134 @@
+#include "query_pool.hpp"
+#include <algorithm>
+
+QueryPool::QueryPool(unsigned numThreads)
+    : m_numThreads(numThreads ? numThreads : std::max(1u, std::thread::hardware_concurrency()))
+    , m_ranges(new Range[m_numThreads])
+    , m_batch(0)
+    , m_running(0)
+    , m_stop(false)
+    , m_task(nullptr)
+    , m_steals(0)
+{
+    for (unsigned w = 0; w < m_numThreads; ++w) {
+        m_ranges[w].bounds.store(0, std::memory_order_relaxed);
+    }
+    for (unsigned w = 1; w < m_numThreads; ++w) {
+        m_threads.emplace_back(&QueryPool::workerLoop, this, w);
+    }
+}
+
+QueryPool::~QueryPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+uint64_t QueryPool::run(size_t count, const std::function<void(unsigned, size_t)>& task) {
+    // Even shares up front; stealing evens out the rest
+    for (unsigned w = 0; w < m_numThreads; ++w) {
+        uint64_t begin = count * w / m_numThreads;
+        uint64_t end   = count * (w + 1) / m_numThreads;
+        m_ranges[w].bounds.store(pack(begin, end), std::memory_order_relaxed);
+    }
+    m_steals.store(0, std::memory_order_relaxed);
+    m_task = &task;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_batch;
+        m_running = m_numThreads - 1;
+    }
+    m_wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_running == 0; });
+    m_task = nullptr;
+    return m_steals.load(std::memory_order_relaxed);
+}
+
+bool QueryPool::takeOwn(unsigned worker, size_t& index) {
+    std::atomic<uint64_t>& bounds = m_ranges[worker].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+
+    while (true) {
+        uint64_t begin = current >> 32;
+        uint64_t end   = current & UINT32_MAX;
+        if (begin >= end)
+            return false;
+        if (bounds.compare_exchange_weak(current, pack(begin + 1, end), std::memory_order_acq_rel)) {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+bool QueryPool::steal(unsigned worker) {
+    while (true) {
+        // The fullest range left, as seen right now
+        unsigned victim = worker;
+        uint64_t bestLeft = 0, bestBounds = 0;
+        for (unsigned i = 1; i < m_numThreads; ++i) {
+            unsigned w = (worker + i) % m_numThreads;
+            uint64_t bounds = m_ranges[w].bounds.load(std::memory_order_acquire);
+            uint64_t begin = bounds >> 32, end = bounds & UINT32_MAX;
+
+            if (end > begin && end - begin > bestLeft) {
+                victim = w;
+                bestLeft = end - begin;
+                bestBounds = bounds;
+            }
+        }
+        if (victim == worker)
+            return false;
+
+        uint64_t begin = bestBounds >> 32, end = bestBounds & UINT32_MAX;
+        uint64_t split = end - (end - begin + 1) / 2;
+        if (m_ranges[victim].bounds.compare_exchange_strong(bestBounds, pack(begin, split),
+                                                            std::memory_order_acq_rel)) {
+            // Only its owner refills an empty range, so a plain store does
+            m_ranges[worker].bounds.store(pack(split, end), std::memory_order_release);
+            m_steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+void QueryPool::work(unsigned worker) {
+    size_t index;
+    do {
+        while (takeOwn(worker, index)) {
+            (*m_task)(worker, index);
+        }
+    } while (steal(worker));
+}
+
+void QueryPool::workerLoop(unsigned worker) {
+    uint64_t seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_batch != seen; });
+            if (m_stop)
+                return;
+            seen = m_batch;
+        }
+
+        work(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_running;
+        }
+        m_done.notify_one();
+    }
+}
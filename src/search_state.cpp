@@ -0,0 +1,32 @@
+#include "search_state.hpp"
+#include <algorithm>
+
+template <typename CostT>
+BasicSearchState<CostT>::BasicSearchState(size_t numNodes)
+    : m_generation(1)
+{
+    resize(numNodes);
+}
+
+template <typename CostT>
+void BasicSearchState<CostT>::resize(size_t numNodes) {
+    // Stamp 0 never matches a live generation, so every entry starts unseen
+    m_generation = 1;
+    m_stamp.assign(numNodes, 0);
+    m_g.resize(numNodes);
+    m_h.resize(numNodes);
+    m_parent.resize(numNodes);
+}
+
+template <typename CostT>
+void BasicSearchState<CostT>::beginQuery() {
+    if (m_generation == MAX_GENERATION) {
+        // Generation counter wrapped: pay for one full clear every ~1G queries
+        m_generation = 0;
+        std::fill(m_stamp.begin(), m_stamp.end(), 0);
+    }
+    ++m_generation;
+}
+
+template class BasicSearchState<Cost>;
+template class BasicSearchState<float>;
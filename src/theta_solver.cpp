@@ -0,0 +1,115 @@
+#include "theta_solver.hpp"
+#include "node_grid.hpp"
+#include "search_policies.hpp"
+#include <cmath>
+
+ThetaSolver::ThetaSolver(const NodeGrid& grid, SearchState& state, IndexedHeap<Cost>& openList,
+                         bool lazy)
+    : m_grid(grid)
+    , m_state(state)
+    , m_openList(openList)
+    , m_lazy(lazy)
+    , m_goal(INVALID_NODE)
+    , m_sightChecks(0)
+{
+}
+
+Cost ThetaSolver::segmentCost(const NodeGrid& grid, NodeId from, NodeId to) {
+    double dx = grid.x(to) - grid.x(from);
+    double dy = grid.y(to) - grid.y(from);
+    return static_cast<Cost>(std::lround(COST_STRAIGHT * std::sqrt(dx * dx + dy * dy)));
+}
+
+void ThetaSolver::relax(NodeId nid, NodeId parent, Cost g, SearchStats& stats) {
+    if (!m_state.isTouched(nid)) {
+        unsigned dx = static_cast<unsigned>(std::abs(m_grid.x(nid) - m_grid.x(m_goal)));
+        unsigned dy = static_cast<unsigned>(std::abs(m_grid.y(nid) - m_grid.y(m_goal)));
+        Cost h = FixedCost::euclidean(dx, dy);
+
+        m_state.open(nid, g, h, parent);
+        m_openList.push(nid, g + h, h);
+        ++stats.pushes;
+    }
+    else if (g < m_state.gRaw(nid)) {
+        m_state.relax(nid, g, parent);
+        m_openList.decreaseKey(nid, g + m_state.hRaw(nid));
+        ++stats.decreaseKeys;
+    }
+}
+
+void ThetaSolver::confirmParent(NodeId nid) {
+    NodeId parent = m_state.parent(nid);
+    if (parent == INVALID_NODE)
+        return;
+
+    ++m_sightChecks;
+    if (m_grid.hasLineOfSight(parent, nid))
+        return;
+
+    // The node was generated by an expanded neighbor, so one exists
+    Cost best = COST_INFINITY;
+    m_grid.forEachNeighbor(nid, [&](NodeId adj, Direction dir) {
+        if (m_state.isClosed(adj) && m_state.gRaw(adj) + DIR_COST[dir] < best) {
+            best = m_state.gRaw(adj) + DIR_COST[dir];
+            parent = adj;
+        }
+    });
+    m_state.relax(nid, best, parent);
+}
+
+bool ThetaSolver::solve(NodeId start, NodeId goal, SearchStats& stats,
+                        std::deque<TraceEntry>& trace) {
+    m_goal = goal;
+    m_sightChecks = 0;
+    m_openList.clear();
+
+    if (m_grid.isObstacle(start))
+        return false;
+
+    relax(start, INVALID_NODE, 0, stats);
+
+    while (!m_openList.empty()) {
+        NodeId current = m_openList.pop();
+        if (m_lazy)
+            confirmParent(current);
+
+        m_state.close(current);
+        ++stats.pops;
+
+        if (current != start)
+            trace.push_back(TraceEntry{ current, m_state.parent(current), Frontier::FORWARD });
+        if (current == goal)
+            return true;
+
+        ++stats.expansions;
+        NodeId parent = m_state.parent(current);
+        Cost currentG = m_state.gRaw(current);
+
+        m_grid.forEachNeighbor(current, [&](NodeId adj, Direction dir) {
+            if (m_state.isClosed(adj))
+                return;
+
+            // Straight from the parent if it can see adj (or, lazily,
+            // until expanding adj shows it can not)
+            bool viaParent = (parent != INVALID_NODE);
+            if (viaParent && !m_lazy) {
+                ++m_sightChecks;
+                viaParent = m_grid.hasLineOfSight(parent, adj);
+            }
+
+            if (viaParent)
+                relax(adj, parent, m_state.gRaw(parent) + segmentCost(m_grid, parent, adj), stats);
+            else
+                relax(adj, current, currentG + DIR_COST[dir], stats);
+        });
+
+        stats.maxOpenSize = std::max(stats.maxOpenSize, m_openList.size());
+    }
+    return false;
+}
+
+void ThetaSolver::buildPath(std::vector<NodeId>& path) const {
+    for (NodeId nid = m_goal; nid != INVALID_NODE; nid = m_state.parent(nid)) {
+        path.push_back(nid);
+    }
+}